@@ -20,6 +20,7 @@ INSTALL_LIBDIR = $${PREFIX}/lib
 greaterThan(QT_MAJOR_VERSION, 4) {
     QT += widgets
     QT += printsupport
+    QT += concurrent
 }
 
 exists( /usr/include/mpv/client.h ) {
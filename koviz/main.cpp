@@ -26,16 +26,20 @@ using namespace std;
 #include "libkoviz/tricktablemodel.h"
 #include "libkoviz/dp.h"
 #include "libkoviz/snap.h"
-#include "libkoviz/csv.h"
+#include "libkoviz/csvtotrk.h"
+#include "libkoviz/csvwriter.h"
+#include "libkoviz/trkwriter.h"
 #include "libkoviz/datamodel_trick.h"
+#include "libkoviz/columncache.h"
 #include "libkoviz/curvemodel.h"
 #include "libkoviz/trick_types.h"
 #include "libkoviz/session.h"
 
 QStandardItemModel* createVarsModel(Runs* runs);
-bool writeTrk(const QString& ftrk, const QString &timeName,
-              double start, double stop, double timeShift,
-              QStringList& paramList, Runs* runs);
+QStringList dp2trkFileNames(const QString& ftrk, const QStringList& runDirs);
+bool writeTrks(const QStringList& ftrks, const QString& timeName,
+               double start, double stop, const QList<double>& timeShifts,
+               QStringList& paramList, Runs* runs);
 bool writeCsv(const QString& fcsv, const QStringList& timeNames,
               DPTable* dpTable, const QString &runDir,
               double startTime, double stopTime, double tolerance);
@@ -80,6 +84,7 @@ class SnapOptions : public Options
     double stop;
     bool isReportRT;
     QString presentation;
+    QString baseline;
     unsigned int beginRun;
     unsigned int endRun;
     QString pdfOutFile;
@@ -157,6 +162,7 @@ class SnapOptions : public Options
     QString buttonZoom;
     QString buttonReset;
     QString platform;
+    uint cacheSize;
 };
 
 SnapOptions opts;
@@ -176,8 +182,11 @@ int main(int argc, char *argv[])
     opts.add("-start", &opts.start, -DBL_MAX, "start time", preset_start);
     opts.add("-stop", &opts.stop, DBL_MAX, "stop time", preset_stop);
     opts.add("-pres",&opts.presentation,"",
-             "present plot with two curves as compare,error or error+compare",
+             "present plot with two curves as compare,error or error+compare, "
+             "or many curves as baseline_error or baseline_envelope",
              presetPresentation);
+    opts.add("-baseline",&opts.baseline,"",
+             "RUN that baseline error plots are against (default first RUN)");
     opts.add("-beginRun",&opts.beginRun,0,
              "begin run (inclusive) in set of Monte carlo RUNs",
              presetBeginRun);
@@ -194,7 +203,9 @@ int main(int argc, char *argv[])
              "Name of pdf output file");
     opts.add("-dp2trk", &opts.dp2trkOutFile, QString(""),
              "Create trk from DP_ vars, "
-             "e.g. koviz DP_foo RUN_a -dp2trk foo.trk");
+             "e.g. koviz DP_foo RUN_a -dp2trk foo.trk "
+             "(with many runs e.g. a MONTE, dir/foo.trk makes "
+             "dir/RUN_x/foo.trk per run)");
     opts.add("-dp2csv", &opts.csvOutFile, QString(""),
              "Create csv from DP_ vars, "
              "e.g. koviz DP_foo RUN_a -dp2csv foo.csv");
@@ -299,6 +310,8 @@ int main(int argc, char *argv[])
              &opts.buttonReset,"right","left, middle or right mouse button");
     opts.add("-platform",
              &opts.platform,"","Set to \"offscreen\" for pdf without X");
+    opts.add("-cacheSize",&opts.cacheSize,1024,
+             "Memory budget (MB) for cached data columns, 0 disables");
 
     opts.parse(argc,argv, QString("koviz"), &ok);
 
@@ -317,6 +330,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    ColumnCache::instance()->setBudget((qint64)opts.cacheSize*1024LL*1024LL);
+
     QStringList dps;
     QStringList runDirs;
     foreach ( QString f, opts.rundps ) {
@@ -1025,6 +1040,28 @@ int main(int argc, char *argv[])
             exit(-1);
         }
 
+        // Baseline run for baseline error plots (index into runs)
+        int baselineRunID = 0;
+        if ( !opts.baseline.isEmpty() ) {
+            baselineRunID = -1;
+            QString baseline = QDir::cleanPath(opts.baseline);
+            QStringList runPaths = runs->runDirs();
+            for ( int i = 0; i < runPaths.size(); ++i ) {
+                QString runDir = QDir::cleanPath(runPaths.at(i));
+                if ( runDir == baseline ||
+                     QFileInfo(runDir).fileName() == baseline ) {
+                    baselineRunID = i;
+                    break;
+                }
+            }
+            if ( baselineRunID < 0 ) {
+                fprintf(stderr, "koviz [error]: -baseline \"%s\" is not "
+                                "one of the RUNs.\n",
+                        opts.baseline.toLatin1().constData());
+                exit(-1);
+            }
+        }
+
         // Create book model
         PlotBookModel* bookModel = new PlotBookModel(timeNames,runs,0,1);
         if ( titles.size() == 4 ) {
@@ -1121,6 +1158,7 @@ int main(int argc, char *argv[])
                                      opts.buttonZoom );
         bookModel->addChild(rootItem,"ButtonReset",
                                      opts.buttonReset );
+        bookModel->addChild(rootItem,"BaselineRunID", baselineRunID );
 
         if ( isTrk ) {
 
@@ -1129,36 +1167,49 @@ int main(int argc, char *argv[])
                 params = DPProduct::paramList(dps,timeName);
             }
 
-            if ( runs->runDirs().count() == 1 ) {
-                QHash<QString,QVariant> shifts = getShiftHash(shiftString,
-                                                              runDirs);
+            // A trk per run, runs of a MONTE get a mirrored tree of trks
+            QStringList runPaths = runs->runDirs();
+            QStringList ftrks = dp2trkFileNames(opts.dp2trkOutFile,runPaths);
+
+            // A run's shift is keyed by its path (or its MONTE's path)
+            QHash<QString,QVariant> shifts = getShiftHash(shiftString,
+                                                          runDirs);
+            QList<double> timeShifts;
+            foreach ( QString runPath, runPaths ) {
+                QFileInfo fi(runPath);
+                QVariant shift;
+                if ( runPaths.size() == 1 && shifts.size() == 1 ) {
+                    shift = shifts.values().at(0);
+                } else if ( shifts.contains(fi.absoluteFilePath()) ) {
+                    shift = shifts.value(fi.absoluteFilePath());
+                } else if ( shifts.contains(fi.absolutePath()) ) {
+                    shift = shifts.value(fi.absolutePath());
+                }
                 double timeShift = 0.0;
-                if ( shifts.size() == 1 ) {
+                if ( shift.isValid() ) {
                     bool ok;
-                    timeShift = shifts.values().at(0).toDouble(&ok);
+                    timeShift = shift.toDouble(&ok);
                     if ( !ok ) {
                         fprintf(stderr, "koviz [bad scoobs]: -shift <value> "
                                         "cannot be converted to a double.\n");
                         exit(-1);
                     }
                 }
-                bool r = writeTrk(opts.dp2trkOutFile,
-                                  timeName,
-                                  startTime,
-                                  stopTime,
-                                  timeShift,
-                                  params,runs);
-                if ( r ) {
-                    ret = 0;
-                } else {
-                    fprintf(stderr, "koviz [error]: Failed to write: %s\n",
-                            opts.dp2trkOutFile.toLatin1().constData());
-                    ret = -1;
-                }
+                timeShifts << timeShift;
+            }
+
+            bool r = writeTrks(ftrks,
+                               timeName,
+                               startTime,
+                               stopTime,
+                               timeShifts,
+                               params,runs);
+            if ( r ) {
+                ret = 0;
             } else {
-                fprintf(stderr, "koviz [error]: Only one RUN allowed with "
-                                 "the -trk and -dp2trk options.\n");
-                exit(-1);
+                fprintf(stderr, "koviz [error]: Failed to write: %s\n",
+                        opts.dp2trkOutFile.toLatin1().constData());
+                ret = -1;
             }
 
         } else if ( isCsv ) {
@@ -1360,9 +1411,11 @@ void presetPresentation(QString* presVar, const QString& pres, bool* ok)
     Q_UNUSED(presVar);
 
     if ( !pres.isEmpty() && pres != "compare" && pres != "error" &&
-         pres != "error+compare" ) {
+         pres != "error+compare" && pres != "baseline_error" &&
+         pres != "baseline_envelope" ) {
         fprintf(stderr,"koviz [error] : option -presentation, set to \"%s\", "
-                "should be \"compare\", \"error\" or \"error+compare\"\n",
+                "should be \"compare\", \"error\", \"error+compare\", "
+                "\"baseline_error\" or \"baseline_envelope\"\n",
                 pres.toLatin1().constData());
         *ok = false;
     }
@@ -1429,45 +1482,133 @@ void presetplotLegendPosition(QString* presVar,const QString& position,bool* ok)
     }
 }
 
-bool writeTrk(const QString& ftrk, const QString& timeName,
-              double start, double stop, double timeShift,
-              QStringList& paramList, Runs* runs)
+// With many runs, -dp2trk dir/foo.trk mirrors the runs under dir, each
+// run gets dir/<run>/foo.trk where <run> is the run path below the
+// directory common to all runs e.g. MONTE_x/RUN_00012 -> dir/RUN_00012
+QStringList dp2trkFileNames(const QString& ftrk, const QStringList& runDirs)
 {
-    QFileInfo ftrki(ftrk);
-    if ( ftrki.exists() ) {
-        fprintf(stderr, "koviz [error]: Will not overwrite %s\n",
-                ftrk.toLatin1().constData());
-        return false;
+    QStringList ftrks;
+
+    if ( runDirs.size() == 1 ) {
+        ftrks << ftrk;
+        return ftrks;
     }
 
-    // Print message
-    fprintf(stderr, "\nkoviz [info]: extracting the following params "
-                    "into %s:\n\n",
-                    ftrk.toLatin1().constData());
-    foreach ( QString param, paramList ) {
-        fprintf(stderr, "    %s\n", param.toLatin1().constData());
+    QStringList absRunDirs;
+    foreach ( QString runDir, runDirs ) {
+        absRunDirs << QDir::cleanPath(QFileInfo(runDir).absoluteFilePath());
     }
-    fprintf(stderr, "\n");
+    QString commonDir = Runs::commonPrefix(absRunDirs,"/");
 
-    //
-    // Make param list
-    // And make curves list (based on param list)
-    //
-    QList<TrickParameter> params;
-    QList<CurveModel*> curves;
+    QFileInfo fi(ftrk);
+    foreach ( QString absRunDir, absRunDirs ) {
+        QString run = absRunDir.mid(commonDir.size());
+        ftrks << QDir::cleanPath(fi.absolutePath() + "/" + run + "/" +
+                                 fi.fileName());
+    }
+
+    return ftrks;
+}
+
+// One run of a -dp2trk extraction
+class TrkJob
+{
+  public:
+    QString ftrk;
+    double start;
+    double stop;
+    double timeShift;
+    QList<TrickParameter> params;  // time is the first param
+    QList<CurveModel*> curves;     // null for time
+};
+
+// Writes a run's trk (called on worker threads, one run per thread)
+class TrkJobWriter
+{
+  public:
+    typedef bool result_type;
+    bool operator()(const TrkJob& job) const;
+};
+
+bool TrkJobWriter::operator()(const TrkJob &job) const
+{
+    // Make time stamps list
+    TimeStamps merger;
+    foreach ( CurveModel* curve, job.curves ) {
+        if ( !curve ) continue ;
+        merger.addColumn(curve->dataModel(),curve->tColumn(),
+                         job.start,job.stop);
+    }
+    QVector<double> timeStamps = merger.merge();
+    int nTimeStamps = timeStamps.size();
+
+    // Shifted time stamps
+    QVector<double> times(nTimeStamps);
+    for ( int j = 0; j < nTimeStamps; ++j ) {
+        times[j] = timeStamps.at(j)+job.timeShift;
+    }
 
+    // Curves of a model share the model rows at each time stamp
+    QHash<DataModel*,QVector<int> > model2rows;
+    foreach ( CurveModel* curve, job.curves ) {
+        if ( !curve ) continue;
+        curve->map();
+        DataModel* model = curve->dataModel();
+        if ( model2rows.contains(model) ) continue;
+        QVector<int> rows(nTimeStamps);
+        int cursor = 0;
+        for ( int j = 0; j < nTimeStamps; ++j ) {
+            rows[j] = model->indexAtTime(timeStamps.at(j),&cursor);
+        }
+        model2rows.insert(model,rows);
+    }
+
+    TrkWriter writer;
+    for ( int i = 0; i < job.curves.size(); ++i ) {
+        CurveModel* curve = job.curves.at(i);
+        if ( !curve ) {
+            writer.addColumn(job.params.at(i),times);
+        } else {
+            DataModel* model = curve->dataModel();
+            writer.addColumn(job.params.at(i),model,curve->yColumn(),
+                             model2rows[model]);
+        }
+    }
+
+    bool ret = false;
+    QFile trk(job.ftrk);
+    if (!trk.open(QIODevice::WriteOnly)) {
+        fprintf(stderr,"koviz: [error] could not open %s\n",
+                job.ftrk.toLatin1().constData());
+    } else {
+        ret = writer.write(&trk,nTimeStamps);
+        trk.close();
+    }
+
+    foreach ( CurveModel* curve, job.curves ) {
+        if ( curve ) curve->unmap();
+    }
+
+    return ret;
+}
+
+// Makes the param and curve lists of a run's trk
+bool makeTrkJob(TrkJob* job, const QString &timeName,
+                QStringList& paramList, Runs* runs, int runIdx)
+{
     // Time is first "param"
     TrickParameter timeParam;
     timeParam.setName(timeName);
     timeParam.setUnit("s");
     timeParam.setType(TRICK_07_DOUBLE);
     timeParam.setSize(sizeof(double));
-    params << timeParam;
+    job->params << timeParam;
 
     // Each param gets a curve. Make the first curve null since
     // there is no actual curve to go with timeStamps
-    curves << 0;
+    job->curves << 0;
 
+    QString runDir = runs->runDirs().at(runIdx);
     foreach ( QString yParam, paramList ) {
 
         // If time is in param list, then skip it  since timestamps
@@ -1476,149 +1617,131 @@ bool writeTrk(const QString& ftrk, const QString& timeName,
             continue;
         }
 
-        CurveModel* c = runs->curveModel(0,timeName,timeName,yParam);
+        CurveModel* c = runs->curveModel(runIdx,timeName,timeName,yParam);
 
         // Error check: see if MonteModel could not find curve (timeName,yParam)
         if ( !c) {
-            fprintf(stderr, "koviz [error]: could not find curve: \n    ("
-                    "%s,%s)\n",
+            fprintf(stderr, "koviz [error]: could not find curve in %s: \n"
+                    "    (%s,%s)\n",
+                    runDir.toLatin1().constData(),
                     timeName.toLatin1().constData(),
                     yParam.toLatin1().constData());
-            foreach ( CurveModel* curveModel, curves ) {
-                delete curveModel;
-            }
-            delete c;
-            return false;
-        }
-
-        // Map Curve
-        c->map();
-
-        // Error check:   make sure curve has data
-        if ( c->rowCount() == 0 ) {
-            // No data
-            fprintf(stderr, "koviz [error]: no data found in %s\n",
-                    c->fileName().toLatin1().constData());
-            foreach ( CurveModel* curveModel, curves ) {
-                delete curveModel;
-            }
-            delete c;
             return false;
         }
 
-        // Make a Param (for trk header)
+        // Make params/curves lists (lazily mapping params to curves)
         TrickParameter p;
         p.setName(yParam);
         p.setUnit(c->y()->unit());
         p.setType(TRICK_07_DOUBLE);
         p.setSize(sizeof(double));
+        job->params.append(p);
+        job->curves.append(c);
 
-        // Make params/curves lists (lazily mapping params to curves)
-        params.append(p);
-        curves.append(c);
-
-        // Unmap Curve
+        // Error check:   make sure curve has data
+        c->map();
+        int nRows = c->rowCount();
         c->unmap();
+        if ( nRows == 0 ) {
+            // No data
+            fprintf(stderr, "koviz [error]: no data found in %s\n",
+                    c->fileName().toLatin1().constData());
+            return false;
+        }
     }
-    if ( params.size() < 2 ) {
-        fprintf(stderr,"koviz [error]: Could not find any params in RUN that "
-                       "are in DP files\n\n");
+    if ( job->params.size() < 2 ) {
+        fprintf(stderr,"koviz [error]: Could not find any params in %s that "
+                       "are in DP files\n\n",
+                runDir.toLatin1().constData());
         return false;
     }
 
-    // Make time stamps list
-    QList<double> timeStamps;
-    foreach ( CurveModel* curve, curves ) {
-
-        if ( !curve ) continue ;
-
-        curve->map();
+    return true;
+}
 
-        ModelIterator* it = curve->begin();
-        while ( !it->isDone() ) {
-            double t = it->t();
-            if ( t < start ) {
-                it->next();
-                continue;
-            }
-            if ( t > stop ) {
-                break;
-            }
-            TimeStamps::insert(t,timeStamps);
-            it->next();
+// Writes a trk per run, ftrks[i] for run i.  Runs are written in
+// parallel, each with one sequential pass over its data.
+bool writeTrks(const QStringList& ftrks, const QString& timeName,
+               double start, double stop, const QList<double>& timeShifts,
+               QStringList& paramList, Runs* runs)
+{
+    foreach ( QString ftrk, ftrks ) {
+        QFileInfo ftrki(ftrk);
+        if ( ftrki.exists() ) {
+            fprintf(stderr, "koviz [error]: Will not overwrite %s\n",
+                    ftrk.toLatin1().constData());
+            return false;
         }
-        delete it;
-        curve->unmap();
     }
 
-    // Open trk file for writing
-    QFile trk(ftrk);
-    if (!trk.open(QIODevice::WriteOnly)) {
-        fprintf(stderr,"koviz: [error] could not open %s\n",
-                ftrk.toLatin1().constData());
-        return false;
+    // Print message
+    if ( ftrks.size() == 1 ) {
+        fprintf(stderr, "\nkoviz [info]: extracting the following params "
+                        "into %s:\n\n",
+                        ftrks.at(0).toLatin1().constData());
+    } else {
+        fprintf(stderr, "\nkoviz [info]: extracting the following params "
+                        "from %d runs into %s etc.:\n\n",
+                        ftrks.size(), ftrks.at(0).toLatin1().constData());
     }
-    QDataStream out(&trk);
-
-    // Write Trk Header
-    TrickModel::writeTrkHeader(out,params);
-    trk.flush();
-
-    // Resize Trk file to fit all the data + header
-    qint64 headerSize = trk.size();
-    qint64 nParams = params.size();
-    qint64 recordSize = nParams*sizeof(double);
-    qint64 nRecords = timeStamps.count();
-    qint64 dataSize = nRecords*recordSize;
-    qint64 fileSize = headerSize + dataSize;
-    trk.resize(fileSize);
-
-    int nTimeStamps = timeStamps.count();
-
-    // Write time stamps and data
-    int i = 0;
-    foreach ( CurveModel* curve, curves ) {
-
-        if ( !curve ) {
-            // write time stamps
-            for ( int j = 0 ; j < nTimeStamps; ++j ) {
-                qint64 recordOffset = j*recordSize;
-                qint64 paramOffset = 0;
-                qint64 offset = headerSize + recordOffset + paramOffset;
-                trk.seek(offset);
-                out << timeStamps.at(j)+timeShift;
-            }
-        } else {
-            // write curve data
-            curve->map();
-            ModelIterator* it = curve->begin();
-            for ( int j = 0 ; j < nTimeStamps; ++j ) {
+    foreach ( QString param, paramList ) {
+        fprintf(stderr, "    %s\n", param.toLatin1().constData());
+    }
+    fprintf(stderr, "\n");
 
-                double timeStamp = timeStamps.at(j);
-                int k = curve->indexAtTime(timeStamp);
-                double v = it->at(k)->y();
+    //
+    // Make a job per run
+    //
+    bool ret = true;
+    QList<TrkJob> jobs;
+    for ( int i = 0; i < ftrks.size(); ++i ) {
+        TrkJob job;
+        job.ftrk = ftrks.at(i);
+        job.start = start;
+        job.stop = stop;
+        job.timeShift = timeShifts.at(i);
+        bool isOk = makeTrkJob(&job,timeName,paramList,runs,i);
+        jobs.append(job);
+        if ( !isOk ) {
+            ret = false;
+            break;
+        }
+        QString ftrkDir = QFileInfo(job.ftrk).absolutePath();
+        if ( !QDir().mkpath(ftrkDir) ) {
+            fprintf(stderr,"koviz [error]: could not make directory %s\n",
+                    ftrkDir.toLatin1().constData());
+            ret = false;
+            break;
+        }
+    }
 
-                qint64 recordOffset = j*recordSize;
-                qint64 paramOffset = i*sizeof(double);
-                qint64 offset = headerSize + recordOffset + paramOffset;
-                trk.seek(offset);
-                out << v;
+    //
+    // Write trks
+    //
+    if ( ret ) {
+        QList<bool> rets = QtConcurrent::blockingMapped<QList<bool> >(
+                                                     jobs,TrkJobWriter());
+        for ( int i = 0; i < rets.size(); ++i ) {
+            if ( !rets.at(i) ) {
+                if ( ftrks.size() > 1 ) {
+                    fprintf(stderr, "koviz [error]: Failed to write: %s\n",
+                            ftrks.at(i).toLatin1().constData());
+                }
+                ret = false;
             }
-            delete it;
-            curve->unmap();
         }
-        ++i;
     }
 
     //
     // Clean up
     //
-    trk.close();
-    foreach ( CurveModel* curveModel, curves ) {
-        delete curveModel;
+    foreach ( TrkJob job, jobs ) {
+        foreach ( CurveModel* curveModel, job.curves ) {
+            delete curveModel;
+        }
     }
 
-    return true;
+    return ret;
 }
 
 bool writeCsv(const QString& fcsv, const QStringList& timeNames,
@@ -1639,13 +1762,9 @@ bool writeCsv(const QString& fcsv, const QStringList& timeNames,
                 fcsv.toLatin1().constData());
         return false;
     }
-    QTextStream out(&csv);
 
-    // Format output
-    out.setFieldAlignment(QTextStream::AlignRight);
-    out.setFieldWidth(12);
-    out.setPadChar(' ');
-    out.setRealNumberPrecision(8);
+    // Fields (and line ends) are right aligned in 12 wide fields
+    QByteArray rowEnd = QByteArray(11,' ') + "\n";
 
     // Csv header
     QString header;
@@ -1656,8 +1775,8 @@ bool writeCsv(const QString& fcsv, const QStringList& timeNames,
         header += var->name() +  unit + ",";
     }
     header.chop(1);
-    out << header;
-    out << "\n";
+    QByteArray headerBytes = header.rightJustified(12,' ').toLocal8Bit();
+    headerBytes += rowEnd;
 
     // Csv body
     QStringList params;
@@ -1665,39 +1784,62 @@ bool writeCsv(const QString& fcsv, const QStringList& timeNames,
         params << var->name() ;
     }
 
-
     TrickTableModel ttm(timeNames, runDir, params);
-    int rc = ttm.rowCount();
+    const QVector<double>& timeStamps = ttm.timeStamps();
+    int rc = timeStamps.size();
     int cc = ttm.columnCount();
+
+    // Records with time in [start,stop] (within tolerance)
     double epsilon = tolerance/2.0;
-    for ( int r = 0 ; r < rc; ++r ) {
-        bool isWriteRecord = true;
-        for ( int c = 0 ; c < cc; ++c ) {
-            QModelIndex idx = ttm.index(r,c);
-            double v = ttm.data(idx).toDouble();
-            if ( c == 0 ) {
-                if ( v < startTime-epsilon || v > stopTime+epsilon ) {
-                    isWriteRecord = false;
-                    break;
-                }
-            }
-            out << v;
-            if ( c < cc-1 ) {
-                int fw = out.fieldWidth();
-                out.setFieldWidth(0);
-                out << ",";
-                out.setFieldWidth(fw);
-            }
+    int beg = 0;
+    while ( beg < rc && timeStamps.at(beg) < startTime-epsilon ) {
+        ++beg;
+    }
+    int end = beg;
+    while ( end < rc && timeStamps.at(end) <= stopTime+epsilon ) {
+        ++end;
+    }
+    QVector<double> times = timeStamps.mid(beg,end-beg);
+    int nRows = times.size();
+
+    CsvWriter writer(CsvWriter::Width12Format);
+    writer.setRowEnd(rowEnd, end < rc); // last record in table isn't ended
+    writer.addColumn(times);
+
+    // Params are the sample at or before the record time
+    QList<DataModel*> trkModels = ttm.trkModels();
+    foreach ( DataModel* trkModel, trkModels ) {
+        trkModel->map();
+    }
+    QHash<DataModel*,QVector<int> > model2rows;
+    QVector<double> zeros(nRows,0.0);
+    for ( int c = 1; c < cc; ++c ) {
+        DataModel* trkModel = ttm.columnModel(c);
+        int col = trkModel ? trkModel->paramColumn(params.at(c-1)) : -1;
+        if ( col < 0 ) {
+            writer.addColumn(zeros);
+            continue;
         }
-        if ( isWriteRecord && r < rc-1 ) {
-            out << "\n";
+        if ( !model2rows.contains(trkModel) ) {
+            QVector<int> rows(nRows);
+            int cursor = 0;
+            for ( int i = 0; i < nRows; ++i ) {
+                rows[i] = trkModel->indexAtTime(times.at(i),&cursor);
+            }
+            model2rows.insert(trkModel,rows);
         }
+        writer.addColumn(trkModel,col,model2rows.value(trkModel));
     }
 
+    bool ret = writer.write(&csv,headerBytes,nRows);
+
     // Clean up
+    foreach ( DataModel* trkModel, trkModels ) {
+        trkModel->unmap();
+    }
     csv.close();
 
-    return true;
+    return ret;
 }
 
 void preset_start(double* time, double new_time, bool* ok)
@@ -1765,142 +1907,41 @@ bool convert2csv(const QStringList& timeNames,
                 fcsv.toLatin1().constData());
         return false;
     }
-    QTextStream out(&csv);
 
     // Write csv param list (top line in csv file)
+    QString header;
     int cc = m.columnCount();
     for ( int i = 0; i < cc; ++i) {
         QString pName = m.param(i)->name();
         QString pUnit = m.param(i)->unit();
-        out << pName << " {" << pUnit << "}";
+        header += pName + " {" + pUnit + "}";
         if ( i < cc-1 ) {
-            out << ",";
+            header += ",";
         }
     }
-    out << "\n";
+    header += "\n";
 
     //
     // Write param values
     //
-    int rc = m.rowCount();
-    for ( int r = 0 ; r < rc; ++r ) {
-        for ( int c = 0 ; c < cc; ++c ) {
-            QModelIndex idx = m.index(r,c);
-            out << m.data(idx).toString();
-            if ( c < cc-1 ) {
-                out << ",";
-            } else {
-                out << "\n";
-            }
-        }
+    CsvWriter writer(CsvWriter::ShortestFormat);
+    for ( int c = 0 ; c < cc; ++c ) {
+        writer.addColumn(&m,c);
     }
+    m.map();
+    bool ret = writer.write(&csv,header.toLocal8Bit(),m.rowCount());
+    m.unmap();
 
     // Clean up
     csv.close();
 
-    return true;
+    return ret;
 }
 
 bool convert2trk(const QString& csvFileName, const QString& trkFileName)
 {
-    QFile file(csvFileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)){
-        fprintf(stderr, "koviz [error]: Cannot read file %s!",
-                csvFileName.toLatin1().constData());
-    }
-    CSV csv(&file);
-
-    // Parse first line to get param list
-    QList<TrickParameter> params;
-    QStringList list = csv.parseLine() ;
-    if ( list.isEmpty() ) {
-        fprintf(stderr, "koviz [error]: Empty csv file \"%s\"",
-                csvFileName.toLatin1().constData());
-        return false;
-    }
-    foreach ( QString s, list ) {
-        TrickParameter p;
-        QStringList plist = s.split(" ", QString::SkipEmptyParts);
-        p.setName(plist.at(0));
-        if ( plist.size() > 1 ) {
-            QString unitString = plist.at(1);
-            if ( unitString.startsWith('{') ) {
-                unitString = unitString.remove(0,1);
-            }
-            if ( unitString.endsWith('}') ) {
-                unitString.chop(1);
-            }
-            Unit u;
-            if ( u.isUnit(unitString.toLatin1().constData()) ) {
-                p.setUnit(unitString);
-            }
-        }
-        p.setType(TRICK_07_DOUBLE);
-        p.setSize(sizeof(double));
-        params.append(p);
-    }
-
-    QFileInfo ftrki(trkFileName);
-    if ( ftrki.exists() ) {
-        fprintf(stderr, "koviz [error]: Will not overwrite %s\n",
-                trkFileName.toLatin1().constData());
-        return false;
-    }
-
-    QFile trk(trkFileName);
-
-    if (!trk.open(QIODevice::WriteOnly)) {
-        fprintf(stderr,"koviz [error]: could not open %s\n",
-                trkFileName.toLatin1().constData());
-        return false;
-    }
-    QDataStream out(&trk);
-
-    // Write trk header
-    TrickModel::writeTrkHeader(out,params);
-
-    //
-    // Write param values
-    //
-    int line = 1;
-    while ( 1 ) {
-        ++line;
-        QStringList list = csv.parseLine() ;
-        if ( list.isEmpty() ) break;  // end of file, hopefully!!!
-        foreach ( QString s, list ) {
-            bool ok;
-            double val = s.toDouble(&ok);
-            if ( !ok ) {
-                QStringList vals = s.split(":");
-                if (vals.length() == 3 ) {
-                    // Try converting to a utc timestamp
-                    val = 3600.0*vals.at(0).toDouble(&ok);
-                    if ( ok ) {
-                        val += 60.0*vals.at(1).toDouble(&ok);
-                        if ( ok ) {
-                            val += vals.at(2).toDouble(&ok);
-                        }
-                    }
-                }
-            }
-            if ( !ok ) {
-                QFileInfo fi(csvFileName);
-                fprintf(stderr,
-                 "koviz [error]: Bad value \"%s\" on line %d in file %s\n",
-                        s.toLatin1().constData(),
-                        line,
-                        fi.absoluteFilePath().toLatin1().constData());
-                file.close();
-                trk.remove();
-                return false;
-            }
-            out << val;
-        }
-    }
-
-    file.close();
-
-    return true;
+    CsvToTrk converter(csvFileName,trkFileName);
+    return converter.convert();
 }
 
 // shiftString has the form "[RUN_0:]val0[,RUN_1:val1,...]"
@@ -507,7 +507,7 @@ void BookIdxView::_paintCurvesLegend(const QRect& R,
 
     QString pres = _bookModel()->getDataString(curvesIdx.parent(),
                                                "PlotPresentation","Plot");
-    if ( pres == "error" ) {
+    if ( pres == "error" || pres == "baseline_envelope" ) {
         return;
     }
 
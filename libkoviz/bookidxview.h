@@ -85,8 +85,8 @@ protected:
                              const QStringList& symbols,
                              const QStringList& labels,
                              QPainter& painter);
-    virtual void __paintSymbol(const QPointF &p, const QString& symbol,
-                               QPainter& painter);
+    static void __paintSymbol(const QPointF &p, const QString& symbol,
+                              QPainter& painter);
     void _paintGrid(QPainter& painter, const QModelIndex &plotIdx);
 
     QList<QAbstractItemView*> _childViews;
@@ -1,12 +1,57 @@
 #include "bookmodel.h"
 #include <float.h>
+#include <algorithm>
+#include <QtConcurrentMap>
 #include "unit.h"
 
+// Builds a curve path (called on worker threads)
+class CurvePathBuilder
+{
+  public:
+    typedef CurvePathJob result_type;
+
+    CurvePathJob operator()(const CurvePathJob& jobIn) const
+    {
+        CurvePathJob job = jobIn;
+        job.build();
+        return job;
+    }
+};
+
+static CurvePath* createCurvesErrorPath(const CurvesErrorPathKey& key,
+                                        double start, double stop);
+static void setCurvePathWindow(CurvePath* path, CurveModel* curveModel,
+                               bool isXLogScale, double start, double stop);
+static void setTimeXPathWindow(CurvePath* path, bool isXLogScale,
+                               double start, double stop);
+
+class CurvesErrorPathBuilder
+{
+  public:
+    typedef CurvePath* result_type;
+
+    CurvesErrorPathBuilder(double start, double stop) :
+        _start(start), _stop(stop)
+    {}
+
+    CurvePath* operator()(const CurvesErrorPathKey& key) const
+    {
+        return createCurvesErrorPath(key,_start,_stop);
+    }
+
+  private:
+    double _start;
+    double _stop;
+};
+
 PlotBookModel::PlotBookModel(const QStringList& timeNames,
                              Runs *runs, QObject *parent) :
     QStandardItemModel(parent),
     _timeNames(timeNames),
-    _runs(runs)
+    _runs(runs),
+    _curvePathBatch(0),
+    _errorPathCount(0),
+    _errorPathBatch(0)
 {
     _initModel();
 }
@@ -16,20 +61,64 @@ PlotBookModel::PlotBookModel(const QStringList& timeNames,
                              int rows, int columns, QObject *parent) :
     QStandardItemModel(rows,columns,parent),
     _timeNames(timeNames),
-    _runs(runs)
+    _runs(runs),
+    _curvePathBatch(0),
+    _errorPathCount(0),
+    _errorPathBatch(0)
 {
     _initModel();
 }
 
 PlotBookModel::~PlotBookModel()
 {
-    foreach ( QPainterPath* path, _curve2path.values() ) {
+    // Workers may be reading curve models deleted below
+    foreach ( QFutureWatcher<CurvePathJob>* watcher,
+              _curvePathBatches.keys() ) {
+        watcher->disconnect(this);
+        watcher->cancel();
+        watcher->waitForFinished();
+        foreach ( CurvePathJob job, watcher->future().results() ) {
+            delete job.path;
+            delete job.lod;
+        }
+        delete watcher;
+    }
+    _curvePathBatches.clear();
+    foreach ( QFutureWatcher<CurvePath*>* watcher,
+              _errorPathBatches.keys() ) {
+        watcher->disconnect(this);
+        watcher->cancel();
+        watcher->waitForFinished();
+        foreach ( CurvePath* path, watcher->future().results() ) {
+            delete path;
+        }
+        delete watcher;
+    }
+    _errorPathBatches.clear();
+
+    foreach ( CurvePath* path, _curve2path.values() ) {
         if ( path ) {
             delete path;
         }
     }
     _curve2path.clear();
 
+    foreach ( CurveLOD* lod, _curve2lod.values() ) {
+        delete lod;
+    }
+    _curve2lod.clear();
+
+    foreach ( CurvesErrorPath e, _curve2errorPath.values() ) {
+        delete e.path;
+    }
+    _curve2errorPath.clear();
+
+    foreach ( CurvesErrorEnvelope e, _curve2errorEnvelope.values() ) {
+        delete e.minPath;
+        delete e.maxPath;
+    }
+    _curve2errorEnvelope.clear();
+
     foreach ( QModelIndex pageIdx, pageIdxs() ) {
         foreach ( QModelIndex plotIdx, plotIdxs(pageIdx) ) {
             QModelIndex curvesIdx = getIndex(plotIdx,"Curves","Plot");
@@ -44,17 +133,23 @@ PlotBookModel::~PlotBookModel()
 bool PlotBookModel::setData(const QModelIndex &idx,
                             const QVariant &value, int role)
 {
-    // If setting curve data, for speed, cache a painterpath out of curve model
+    // If setting curve data, for speed, cache a curve path out of curve model
     if ( idx.column() == 1 ) {
         QModelIndex tagIdx = sibling(idx.row(),0,idx);
         QString tag = data(tagIdx).toString();
         if ( tag == "CurveData" ) {
             CurveModel* curveModel = QVariantToPtr<CurveModel>::convert(value);
             QModelIndex curveIdx = idx.parent();
-            _createPainterPath(curveIdx,
-                               false,0,false,0,false,0,
-                               false,0,false,0,false,0,
-                               "","","","",curveModel);
+            _removeCurvesErrorPaths(curveModel);
+            if ( isChildIndex(curveIdx,"Curve","CurveData") ) {
+                _removeCurvesErrorPaths(getCurveModel(curveIdx));
+            }
+            QList<CurvePathJob> jobs;
+            jobs << _curvePathJob(curveIdx,
+                                  false,0,false,0,false,0,
+                                  false,0,false,0,false,0,
+                                  "","","","",curveModel);
+            _createCurvePaths(jobs);
         } else if ( tag == "StartTime" || tag == "StopTime") {
             double start = -DBL_MAX;
             double stop = DBL_MAX;
@@ -85,17 +180,40 @@ bool PlotBookModel::setData(const QModelIndex &idx,
                                 "PlotBookModel::setData()\n");
                 exit(-1);
             }
+            // Paths keep the whole run so a new time only moves their
+            // windows.  Paths with unsorted time were built with only the
+            // points in the old window and are rebuilt from the curve
+            // model (a newer time cancels the rebuild).
+            QList<CurvePathJob> jobs;
             QModelIndexList pages = pageIdxs();
             foreach ( QModelIndex pageIdx, pages ) {
                 foreach ( QModelIndex plotIdx, plotIdxs(pageIdx) ) {
                     QModelIndex curvesIdx = getIndex(plotIdx,"Curves","Plot");
+                    bool isTime = isXTime(plotIdx);
+                    bool isXLog = ( getDataString(plotIdx,"PlotXScale",
+                                                  "Plot") == "log" );
                     foreach ( QModelIndex curveIdx, curveIdxs(curvesIdx) ) {
-                        _createPainterPath(curveIdx,
-                                           true,start,true,stop,
-                                           false,0,false,0,false,0,false,0);
+                        CurveModel* curveModel = getCurveModel(curveIdx);
+                        CurvePath* path = _curve2path.value(curveModel,0);
+                        if ( path && path->isWholeRun() ) {
+                            double tb = 0.0;
+                            double ts = 1.0;
+                            if ( isTime ) {
+                                tb = xBias(curveIdx,curveModel);
+                                ts = xScale(curveIdx,curveModel);
+                            }
+                            setCurvePathWindow(path,curveModel,isXLog,
+                                               (start-tb)/ts,(stop-tb)/ts);
+                        } else {
+                            jobs << _curvePathJob(curveIdx,
+                                              true,start,true,stop,
+                                              false,0,false,0,false,0,false,0);
+                        }
                     }
                 }
             }
+
+            return _setDataAndRebuild(idx,value,role,jobs,true);
         } else if ( tag == "PlotXScale" || tag == "PlotYScale" ) {
             QString plotXScale = "linear";
             QString plotYScale = "linear";
@@ -117,12 +235,14 @@ bool PlotBookModel::setData(const QModelIndex &idx,
                                     "PlotBookModel::setData()\n");
                     exit(-1);
                 }
+                QList<CurvePathJob> jobs;
                 foreach ( QModelIndex curveIdx, curveIdxs(curvesIdx) ) {
-                    _createPainterPath(curveIdx,
-                                       false,0,false,0,false,0,
-                                       false,0,false,0,false,0,
-                                       "","",plotXScale,plotYScale);
+                    jobs << _curvePathJob(curveIdx,
+                                          false,0,false,0,false,0,
+                                          false,0,false,0,false,0,
+                                          "","",plotXScale,plotYScale);
                 }
+                return _setDataAndRebuild(idx,value,role,jobs);
             }
         } else if ( tag == "CurveYUnit" ) {
             QModelIndex curveIdx = idx.parent();
@@ -132,10 +252,12 @@ bool PlotBookModel::setData(const QModelIndex &idx,
                 QString plotYScale = getDataString(plotIdx,"PlotYScale","Plot");
                 if ( plotXScale == "log" || plotYScale == "log" ) {
                     QString yUnit = value.toString();
-                    _createPainterPath(curveIdx,
-                                       false,0,false,0,false,0,
-                                       false,0,false,0,false,0,
-                                       "",yUnit,plotXScale,plotYScale);
+                    QList<CurvePathJob> jobs;
+                    jobs << _curvePathJob(curveIdx,
+                                          false,0,false,0,false,0,
+                                          false,0,false,0,false,0,
+                                          "",yUnit,plotXScale,plotYScale);
+                    _createCurvePaths(jobs);
                 }
             }
         }
@@ -144,6 +266,27 @@ bool PlotBookModel::setData(const QModelIndex &idx,
     return QStandardItemModel::setData(idx,value,role);
 }
 
+// The value is stored (quietly) before the rebuild so that rebuilds
+// started while this one is building see it.  Views are notified once
+// the new paths are in (or a newer rebuild cancelled this one).
+bool PlotBookModel::_setDataAndRebuild(const QModelIndex &idx,
+                                       const QVariant &value, int role,
+                                       const QList<CurvePathJob> &jobs,
+                                       bool isSupersede)
+{
+    bool block = blockSignals(true);
+    bool isSet = QStandardItemModel::setData(idx,value,role);
+    blockSignals(block);
+
+    QModelIndex changedIdx;
+    if ( isSet ) {
+        changedIdx = idx;
+    }
+    _createCurvePaths(jobs,changedIdx,isSupersede);
+
+    return isSet;
+}
+
 void PlotBookModel::setPlotMathRect(const QRectF& mathRect,
                                     const QModelIndex& plotIdx)
 {
@@ -507,6 +650,8 @@ QModelIndex PlotBookModel::getIndex(const QModelIndex &startIdx,
             idx = index(26,0);
         } else if ( searchItemText == "ButtonReset" ) {
             idx = index(27,0);
+        } else if ( searchItemText == "BaselineRunID" ) {
+            idx = index(28,0);
         } else {
             fprintf(stderr,"koviz [bad scoobs]:3: getIndex() received "
                            "root as a startIdx and had bad child "
@@ -724,9 +869,9 @@ CurveModel *PlotBookModel::getCurveModel(const QModelIndex &curveIdx) const
     return curveModel;
 }
 
-QPainterPath* PlotBookModel::getPainterPath(const QModelIndex &curveIdx) const
+CurvePath* PlotBookModel::getCurvePath(const QModelIndex &curveIdx) const
 {
-    QPainterPath* path;
+    CurvePath* path;
 
     CurveModel* curveModel = getCurveModel(curveIdx);
 
@@ -734,19 +879,384 @@ QPainterPath* PlotBookModel::getPainterPath(const QModelIndex &curveIdx) const
         path = _curve2path.value(curveModel);
     } else {
         fprintf(stderr,"koviz [bad scoobs]: "
-                       "PlotBookModel::getCurvePainterPath()\n");
+                       "PlotBookModel::getCurvePath()\n");
         exit(-1);
     }
 
     return path;
 }
 
-// TODO: cache error path if it's not changing
-QPainterPath *PlotBookModel::getCurvesErrorPath(const QModelIndex &curvesIdx)
+// Returns 0 if the curve is drawn straight from its painter path
+const CurveLOD* PlotBookModel::getCurveLOD(const QModelIndex &curveIdx) const
 {
-    QPainterPath* path;
-    path = _createCurvesErrorPath(curvesIdx);
-    return path;
+    CurveModel* curveModel = getCurveModel(curveIdx);
+    return _curve2lod.value(curveModel,0);
+}
+
+// Error paths are cached per curve pair and owned by the book.  A cached
+// path is rebuilt only if its curves, units, scales, biases, tolerance or
+// plot scales change.  Start/stop moves its time window.
+CurvePath *PlotBookModel::getCurvesErrorPath(const QModelIndex &curvesIdx) const
+{
+    if ( rowCount(curvesIdx) != 2 ) {
+        fprintf(stderr,"koviz [bad scoobies]:2:"
+                       "PlotBookModel::getCurvesErrorPath(): "
+                       "Expected two curves for creating an error path.\n");
+
+        exit(-1);
+    }
+
+    CurvesErrorPathKey key = _curvesErrorPathKey(curvesIdx);
+    double start = getDataDouble(QModelIndex(),"StartTime");
+    double stop = getDataDouble(QModelIndex(),"StopTime");
+
+    CurvesErrorPath e = _cachedCurvesErrorPath(key,start,stop);
+    if ( !e.path ) {
+        e = _cacheCurvesErrorPath(key,createCurvesErrorPath(key,start,stop),
+                                  start,stop);
+    }
+
+    return e.path;
+}
+
+// Error paths (run minus baseline run) of all curves in curvesIdx.  The
+// list is in curve order with a null for the baseline curve itself (and
+// all nulls if the baseline run has no curve on the plot).
+//
+// The error paths are cached like getCurvesErrorPath().  The ones not
+// cached are built on the thread pool, a merge-join per run.  If isWait
+// the build is waited for (e.g. for a bbox or a print).  If not (e.g.
+// while painting) the paths are null until _curvesErrorPathsFinished()
+// swaps them in and tells the views their curves changed.
+QList<CurvePath*> PlotBookModel::getCurvesBaselineErrorPaths(
+                                        const QModelIndex &curvesIdx,
+                                        bool isWait)
+{
+    QList<CurvePath*> paths;
+
+    int rc = rowCount(curvesIdx);
+    int baselineRow = _baselineRow(curvesIdx);
+    for ( int i = 0; i < rc; ++i ) {
+        paths << 0;
+    }
+    if ( baselineRow < 0 ) {
+        return paths;
+    }
+
+    double start = getDataDouble(QModelIndex(),"StartTime");
+    double stop = getDataDouble(QModelIndex(),"StopTime");
+
+    QList<CurvesErrorPathKey> keys;  // paths to build
+    QList<int> rows;
+    for ( int i = 0; i < rc; ++i ) {
+        if ( i == baselineRow ) {
+            continue;
+        }
+        CurvesErrorPathKey key = _curvesErrorPathKey(curvesIdx,i,baselineRow);
+        CurvesErrorPath e = _cachedCurvesErrorPath(key,start,stop);
+        if ( e.path ) {
+            paths[i] = e.path;
+        } else if ( isWait ||
+                    !_curve2errorPathBuild.contains(key.c0) ||
+                    !(_curve2errorPathBuild.value(key.c0).key == key) ) {
+            keys << key;
+            rows << i;
+        }
+    }
+    if ( keys.isEmpty() ) {
+        return paths;
+    }
+
+    if ( isWait ) {
+        // A build of these curves in flight is dropped when it finishes
+        foreach ( CurvesErrorPathKey key, keys ) {
+            _curve2errorPathBuild.remove(key.c0);
+        }
+        if ( keys.size() == 1 ) {
+            CurvePath* path = createCurvesErrorPath(keys.first(),start,stop);
+            paths[rows.first()] = _cacheCurvesErrorPath(keys.first(),path,
+                                                        start,stop).path;
+        } else {
+            QFuture<CurvePath*> future = QtConcurrent::mapped(keys,
+                                         CurvesErrorPathBuilder(start,stop));
+            future.waitForFinished();
+            for ( int k = 0; k < keys.size(); ++k ) {
+                CurvePath* path = future.resultAt(k);
+                paths[rows.at(k)] = _cacheCurvesErrorPath(keys.at(k),path,
+                                                          start,stop).path;
+            }
+        }
+        return paths;
+    }
+
+    CurvesErrorPathBatch errorPathBatch;
+    errorPathBatch.batch = ++_errorPathBatch;
+    errorPathBatch.keys = keys;
+    errorPathBatch.start = start;
+    errorPathBatch.stop = stop;
+    for ( int k = 0; k < keys.size(); ++k ) {
+        CurvesErrorPath build;
+        build.key = keys.at(k);
+        build.id = errorPathBatch.batch;
+        _curve2errorPathBuild.insert(keys.at(k).c0,build);
+        QModelIndex curveIdx = index(rows.at(k),0,curvesIdx);
+        errorPathBatch.curveDataIdxs << getDataIndex(curveIdx,
+                                                     "CurveData","Curve");
+    }
+
+    QFutureWatcher<CurvePath*>* watcher = new QFutureWatcher<CurvePath*>(this);
+    _errorPathBatches.insert(watcher,errorPathBatch);
+    connect(watcher,SIGNAL(finished()),this,SLOT(_curvesErrorPathsFinished()));
+    watcher->setFuture(QtConcurrent::mapped(keys,
+                                         CurvesErrorPathBuilder(start,stop)));
+
+    return paths;
+}
+
+// Caches the error paths of a batch unless a newer build (or a removal)
+// of their curves took over
+void PlotBookModel::_curvesErrorPathsFinished()
+{
+    QFutureWatcher<CurvePath*>* watcher =
+                     static_cast<QFutureWatcher<CurvePath*>*>(sender());
+    if ( !_errorPathBatches.contains(watcher) ) {
+        return;
+    }
+    CurvesErrorPathBatch errorPathBatch = _errorPathBatches.take(watcher);
+    watcher->deleteLater();
+
+    QList<CurvePath*> paths = watcher->future().results();
+    for ( int k = 0; k < paths.size(); ++k ) {
+        const CurvesErrorPathKey& key = errorPathBatch.keys.at(k);
+        CurvesErrorPath build = _curve2errorPathBuild.value(key.c0);
+        if ( build.id != errorPathBatch.batch ) {
+            delete paths.at(k);
+            continue;
+        }
+        _curve2errorPathBuild.remove(key.c0);
+        delete _curve2errorPath.value(key.c0).path;
+        _cacheCurvesErrorPath(key,paths.at(k),
+                              errorPathBatch.start,errorPathBatch.stop);
+        QModelIndex curveDataIdx = errorPathBatch.curveDataIdxs.at(k);
+        if ( curveDataIdx.isValid() ) {
+            emit dataChanged(curveDataIdx,curveDataIdx);
+        }
+    }
+}
+
+// Min and max of the baseline errors at each baseline time stamp.
+// An error point is put on the baseline time stamp nearest it (which is
+// the one it was matched to within the time match tolerance).
+static void createCurvesErrorEnvelope(const CurvesErrorPathKey& key,
+                                      const QList<CurvePath*>& paths,
+                                      CurvePath* minPath, CurvePath* maxPath)
+{
+    // Baseline time stamps, sorted in case the baseline sim restarted
+    QVector<double> T;
+    key.c1->map();
+    int nrows = key.c1->rowCount();
+    T.resize(nrows);
+    for ( int beg = 0; beg < nrows; beg += DataModel::FetchBlockSize ) {
+        key.c1->fetch(beg,DataModel::FetchBlockSize,T.data()+beg,0,0);
+    }
+    key.c1->unmap();
+    for ( int i = 0; i < nrows; ++i ) {
+        T[i] = key.xs1*T.at(i)+key.xb1;
+    }
+    std::sort(T.begin(),T.end());
+    T.erase(std::unique(T.begin(),T.end()),T.end());
+
+    int n = T.size();
+    const double* g = T.constData();
+    QVector<double> lo(n,DBL_MAX);
+    QVector<double> hi(n,-DBL_MAX);
+    foreach ( CurvePath* path, paths ) {
+        if ( !path || n == 0 ) {
+            continue;
+        }
+        // Error path x is its time (or log10 of it)
+        const QPolygonF& points = path->allPoints();
+        int j = 0;
+        for ( int i = 0; i < points.size(); ++i ) {
+            double t = points.at(i).x();
+            if ( key.isXLogScale ) {
+                t = pow(10.0,t);
+            }
+            if ( path->isXSorted() ) {
+                // Walk the grid along with the path
+                while ( j+1 < n && qAbs(g[j+1]-t) <= qAbs(g[j]-t) ) {
+                    ++j;
+                }
+            } else {
+                j = std::lower_bound(g,g+n,t) - g;
+                if ( j == n || (j > 0 && qAbs(g[j-1]-t) < qAbs(g[j]-t)) ) {
+                    --j;
+                }
+            }
+            double y = points.at(i).y();
+            if ( y < lo.at(j) ) lo[j] = y;
+            if ( y > hi.at(j) ) hi[j] = y;
+        }
+    }
+
+    for ( int j = 0; j < n; ++j ) {
+        if ( lo.at(j) > hi.at(j) ) {
+            continue;  // no run matched this time
+        }
+        double x = g[j];
+        if ( key.isXLogScale ) {
+            if ( x == 0.0 ) {
+                continue;
+            }
+            x = log10(x);
+        }
+        minPath->append(x,lo.at(j));
+        maxPath->append(x,hi.at(j));
+    }
+    minPath->squeeze();
+    maxPath->squeeze();
+}
+
+// Returns the min and max envelope paths of the baseline errors of
+// curvesIdx (empty if the baseline run has no curve on the plot, or if
+// !isWait and error paths are still building)
+QList<CurvePath*> PlotBookModel::getCurvesBaselineErrorEnvelope(
+                                        const QModelIndex &curvesIdx,
+                                        bool isWait)
+{
+    QList<CurvePath*> envelope;
+
+    int baselineRow = _baselineRow(curvesIdx);
+    if ( baselineRow < 0 ) {
+        return envelope;
+    }
+
+    QList<CurvePath*> paths = getCurvesBaselineErrorPaths(curvesIdx,isWait);
+    for ( int i = 0; i < paths.size(); ++i ) {
+        if ( i != baselineRow && !paths.at(i) ) {
+            return envelope;
+        }
+    }
+    QList<int> pathIds;
+    CurvesErrorPathKey key;
+    for ( int i = 0; i < paths.size(); ++i ) {
+        if ( paths.at(i) ) {
+            CurveModel* c0 = getCurveModel(curvesIdx,i);
+            CurvesErrorPath e = _curve2errorPath.value(c0);
+            pathIds << e.id;
+            key = e.key;
+        }
+    }
+    if ( pathIds.isEmpty() ) {
+        return envelope;  // baseline is the only curve
+    }
+
+    double start = getDataDouble(QModelIndex(),"StartTime");
+    double stop = getDataDouble(QModelIndex(),"StopTime");
+
+    CurvesErrorEnvelope e = _curve2errorEnvelope.value(key.c1);
+    if ( !e.minPath || e.pathIds != pathIds ) {
+        delete e.minPath;
+        delete e.maxPath;
+        e.pathIds = pathIds;
+        e.minPath = new CurvePath;
+        e.maxPath = new CurvePath;
+        createCurvesErrorEnvelope(key,paths,e.minPath,e.maxPath);
+        _curve2errorEnvelope.insert(key.c1,e);
+    }
+    setTimeXPathWindow(e.minPath,key.isXLogScale,start,stop);
+    setTimeXPathWindow(e.maxPath,key.isXLogScale,start,stop);
+
+    envelope << e.minPath << e.maxPath;
+    return envelope;
+}
+
+bool PlotBookModel::isBaselinePresentation(const QString &presentation) const
+{
+    return ( presentation == "baseline_error" ||
+             presentation == "baseline_envelope" );
+}
+
+// Returns the cached error path for key windowed on start/stop, or an
+// entry with a null path if it must be (re)built
+CurvesErrorPath PlotBookModel::_cachedCurvesErrorPath(
+                                              const CurvesErrorPathKey &key,
+                                              double start, double stop) const
+{
+    CurvesErrorPath cached = _curve2errorPath.value(key.c0);
+    if ( cached.path && cached.key == key ) {
+        if ( cached.path->isWholeRun() ) {
+            setTimeXPathWindow(cached.path,key.isXLogScale,start,stop);
+            return cached;
+        } else if ( cached.start == start && cached.stop == stop ) {
+            // Unsorted paths hold only their window
+            return cached;
+        }
+    }
+    delete cached.path;
+    _curve2errorPath.remove(key.c0);
+
+    return CurvesErrorPath();
+}
+
+CurvesErrorPath PlotBookModel::_cacheCurvesErrorPath(
+                                              const CurvesErrorPathKey &key,
+                                              CurvePath* path,
+                                              double start, double stop) const
+{
+    CurvesErrorPath e;
+    e.key = key;
+    e.id = ++_errorPathCount;
+    e.path = path;
+    setTimeXPathWindow(e.path,key.isXLogScale,start,stop);
+    e.start = start;
+    e.stop = stop;
+    _curve2errorPath.insert(key.c0,e);
+
+    return e;
+}
+
+// Row of the baseline run's curve in curvesIdx, -1 if there is none
+int PlotBookModel::_baselineRow(const QModelIndex &curvesIdx) const
+{
+    int baselineRunID = 0;
+    if ( isChildIndex(QModelIndex(),"","BaselineRunID") ) {
+        baselineRunID = getDataInt(QModelIndex(),"BaselineRunID");
+    }
+
+    int rc = rowCount(curvesIdx);
+    for ( int i = 0; i < rc; ++i ) {
+        QModelIndex curveIdx = index(i,0,curvesIdx);
+        if ( getDataInt(curveIdx,"CurveRunID","Curve") == baselineRunID ) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Drop cached error paths of a curve model (e.g. one being replaced, or
+// a new one that has the address of a deleted one)
+void PlotBookModel::_removeCurvesErrorPaths(CurveModel *curveModel)
+{
+    foreach ( CurveModel* c0, _curve2errorPath.keys() ) {
+        CurvesErrorPath e = _curve2errorPath.value(c0);
+        if ( e.key.c0 == curveModel || e.key.c1 == curveModel ) {
+            delete e.path;
+            _curve2errorPath.remove(c0);
+        }
+    }
+    foreach ( CurveModel* c0, _curve2errorPathBuild.keys() ) {
+        CurvesErrorPathKey key = _curve2errorPathBuild.value(c0).key;
+        if ( key.c0 == curveModel || key.c1 == curveModel ) {
+            _curve2errorPathBuild.remove(c0);
+        }
+    }
+    if ( _curve2errorEnvelope.contains(curveModel) ) {
+        CurvesErrorEnvelope e = _curve2errorEnvelope.take(curveModel);
+        delete e.minPath;
+        delete e.maxPath;
+    }
 }
 
 QModelIndexList PlotBookModel::getIndexList(const QModelIndex &startIdx,
@@ -973,7 +1483,7 @@ double PlotBookModel::yBias(const QModelIndex &curveIdx) const
     return yb;
 }
 
-QRectF PlotBookModel::calcCurvesBBox(const QModelIndex &curvesIdx) const
+QRectF PlotBookModel::calcCurvesBBox(const QModelIndex &curvesIdx)
 {
     QRectF bbox;
 
@@ -985,7 +1495,7 @@ QRectF PlotBookModel::calcCurvesBBox(const QModelIndex &curvesIdx) const
         int rc = rowCount(curvesIdx);
         for (int i = 0; i < rc; ++i) {
             QModelIndex curveIdx = index(i,0,curvesIdx);
-            QPainterPath* path = getPainterPath(curveIdx);
+            CurvePath* path = getCurvePath(curveIdx);
             double xb = 0.0;
             double yb = 0.0;
             double xs = 1.0;
@@ -998,23 +1508,34 @@ QRectF PlotBookModel::calcCurvesBBox(const QModelIndex &curvesIdx) const
                 yb = yBias(curveIdx);
                 ys = yScale(curveIdx);
             }
+            // Window bbox is a min/max tree lookup (see CurvePath).
+            // Unit scale/bias is done here, normalized for negative scales
             QRectF pathBox = path->boundingRect();
-            double w = pathBox.width();
-            double h = pathBox.height();
-            QPointF topLeft(xs*pathBox.topLeft().x()+xb,
-                           (ys*pathBox.topLeft().y()+yb));
-            QRectF scaledPathBox(topLeft,QSizeF(xs*w,ys*h));
-            bbox = bbox.united(scaledPathBox);
+            QRectF scaledPathBox(QPointF(xs*pathBox.left()+xb,
+                                         ys*pathBox.top()+yb),
+                                 QPointF(xs*pathBox.right()+xb,
+                                         ys*pathBox.bottom()+yb));
+            bbox = bbox.united(scaledPathBox.normalized());
         }
         if ( presentation == "error+compare" ) {
-            QPainterPath* errorPath = _createCurvesErrorPath(curvesIdx);
+            CurvePath* errorPath = getCurvesErrorPath(curvesIdx);
             bbox = bbox.united(errorPath->boundingRect());
-            delete errorPath;
         }
     } else if ( presentation == "error" ) {
-        QPainterPath* errorPath = _createCurvesErrorPath(curvesIdx);
+        CurvePath* errorPath = getCurvesErrorPath(curvesIdx);
         bbox = errorPath->boundingRect();
-        delete errorPath;
+    } else if ( presentation == "baseline_error" ) {
+        foreach ( CurvePath* errorPath,
+                  getCurvesBaselineErrorPaths(curvesIdx) ) {
+            if ( errorPath ) {
+                bbox = bbox.united(errorPath->boundingRect());
+            }
+        }
+    } else if ( presentation == "baseline_envelope" ) {
+        foreach ( CurvePath* path,
+                  getCurvesBaselineErrorEnvelope(curvesIdx) ) {
+            bbox = bbox.united(path->boundingRect());
+        }
     } else {
         fprintf(stderr,"koviz [bad scoobs]: PlotBookModel::calcCurvesBBox()\n");
         exit(-1);
@@ -1094,106 +1615,193 @@ QRectF PlotBookModel::calcCurvesBBox(const QModelIndex &curvesIdx) const
 // Note:
 //   No scaling or bias is done linear plot scale since it is done
 //   via the paint transform. For log scale, the path is scaled/biased.
-QPainterPath* PlotBookModel::__createPainterPath(CurveModel *curveModel,
-                                               double startTime,double stopTime,
-                                               double xs, double xb,
-                                               double ys, double yb,
-                                               const QString &plotXScale,
-                                               const QString &plotYScale)
+//
+//   Only reads the curve model, so it is safe on a worker thread.
+void CurvePathJob::build()
 {
-    QPainterPath* path = new QPainterPath;
+    lod = 0;
 
     curveModel->map();
 
-    ModelIterator* it = curveModel->begin();
+    // Curve time of the window
+    double start = (startTime-timeBias)/timeScale;
+    double stop = (stopTime-timeBias)/timeScale;
 
-    bool isXLogScale = ( plotXScale == "log" ) ? true : false;
-    bool isYLogScale = ( plotYScale == "log" ) ? true : false;
+    path = new CurvePath;
+    if ( !_appendPoints(false,start,stop) ) {
+        // Time goes backwards (e.g. a restarted sim) so the path can't be
+        // windowed, build it with only the points in the window instead
+        delete path;
+        path = new CurvePath;
+        _appendPoints(true,start,stop);
+        path->setWholeRun(false);
+    }
+    path->squeeze();
 
-    double f = getDataDouble(QModelIndex(),"Frequency");
-    bool isFirst = true;
-    while ( !it->isDone() ) {
-        double t = it->t();
-        if ( f > 0.0 ) {
-            if ( fabs(t-round(t/f)*f) > 1.0e-9 ) { // t not divisible by f?
-                it->next();
-                continue;
-            }
-        }
-        if ( t < startTime || t > stopTime ) {
-            it->next();
-            continue;
-        }
+    setCurvePathWindow(path,curveModel,isXLogScale,start,stop);
 
-        double x = it->x();
-        double y = it->y();
+    curveModel->unmap();
 
-        if ( isXLogScale ) {
-            x = x*xs + xb;
-            if ( x > 0 ) {
-                x = log10(x);
-            } else if ( x < 0 ) {
-                x = log10(-x);
-            } else if ( x == 0 ) {
-                it->next();
-                continue; // skip log(0) since -inf
+    // Min/max pyramid so big curves draw with a point per pixel or so
+    if ( path->allPoints().size() >= CurveLOD::MinPoints ) {
+        lod = new CurveLOD(*path);
+        if ( !lod->isValid() ) {
+            delete lod;
+            lod = 0;
+        }
+    }
+}
+
+// Appends the curve points to path.  With isCut only points with time in
+// [start,stop] are appended, else the whole run is and false is returned
+// (and the path is unfinished) if time goes backwards.
+bool CurvePathJob::_appendPoints(bool isCut, double start, double stop)
+{
+    double f = frequency;
+
+    // Walk curve in blocks
+    const int blockSize = DataModel::FetchBlockSize;
+    QVector<double> tBlock(blockSize);
+    QVector<double> xBlock(blockSize);
+    QVector<double> yBlock(blockSize);
+    double* tbuf = tBlock.data();
+    double* xbuf = xBlock.data();
+    double* ybuf = yBlock.data();
+    int nrows = curveModel->rowCount();
+    double tLast = -DBL_MAX;
+    if ( !isCut ) {
+        path->reserve(nrows);
+    }
+    for ( int beg = 0; beg < nrows; beg += blockSize ) {
+        int cnt = curveModel->fetch(beg,blockSize,tbuf,xbuf,ybuf);
+        for ( int i = 0; i < cnt; ++i ) {
+            double t = tbuf[i];
+            if ( isCut ) {
+                if ( !(t >= start && t <= stop) ) {
+                    continue;
+                }
+            } else {
+                if ( !(t >= tLast) ) {
+                    return false;
+                }
+                tLast = t;
             }
-        }
+            if ( f > 0.0 ) {
+                if ( fabs(t-round(t/f)*f) > 1.0e-9 ) { // t not divisible by f?
+                    continue;
+                }
+            }
+
+            double x = xbuf[i];
+            double y = ybuf[i];
 
-        if ( isYLogScale ) {
-            y = y*ys + yb;
-            if ( y > 0 ) {
-                y = log10(y);
-            } else if ( y < 0 ) {
-                y = log10(-y);
-            } else if ( y == 0 ) {
-                it->next();
-                continue; // skip log(0) since -inf
+            if ( isXLogScale ) {
+                x = x*xs + xb;
+                if ( x > 0 ) {
+                    x = log10(x);
+                } else if ( x < 0 ) {
+                    x = log10(-x);
+                } else if ( x == 0 ) {
+                    continue; // skip log(0) since -inf
+                }
             }
-        }
 
-        if ( isFirst ) {
-            path->moveTo(x,y);
-            isFirst = false;
-        } else {
-            int m = path->elementCount();
-            path->lineTo(x,y);
-            int n = path->elementCount();
-            if ( m == n ) {
-                /* When points are very close to one another,
-                 * it looks like Qt will skip adding a lineTo(x,y).
-                 * This bit of code tries to force Qt to add the
-                 * lineTo(x,y) no matter how close the two points
-                 * are to one another.
-                 */
-                path->lineTo(x+1.0,y+1.0);
-                int o = path->elementCount();
-                if ( o > m ) {
-                    path->setElementPositionAt(o-1,x,y);
+            if ( isYLogScale ) {
+                y = y*ys + yb;
+                if ( y > 0 ) {
+                    y = log10(y);
+                } else if ( y < 0 ) {
+                    y = log10(-y);
+                } else if ( y == 0 ) {
+                    continue; // skip log(0) since -inf
                 }
             }
+
+            path->append(x,y,beg+i);
         }
+    }
 
-        it->next();
+    return true;
+}
+
+// Windows a curve path on curve time [start,stop].  When x is time the
+// window is found on x, otherwise the rows of start/stop are looked up
+// in the data model's TimeIndex.  A path cut to its window (unsorted
+// time) is shown whole.
+static void setCurvePathWindow(CurvePath* path, CurveModel* curveModel,
+                               bool isXLogScale, double start, double stop)
+{
+    if ( !path->isWholeRun() ) {
+        path->setWindow(0,path->allPoints().size());
+        return;
+    }
+
+    if ( curveModel->xColumn() == curveModel->tColumn() && !isXLogScale ) {
+        path->setXWindow(start,stop);
+        return;
+    }
+
+    int nrows = curveModel->rowCount();
+    if ( nrows == 0 ) {
+        path->setWindow(0,0);
+        return;
+    }
+
+    // indexAtTime() is the last row with time <= the time (or row 0)
+    curveModel->map();
+    double t;
+    int beg = curveModel->indexAtTime(start);
+    curveModel->fetch(beg,1,&t,0,0);
+    if ( t < start ) {
+        ++beg;
+    } else {
+        // Back up to the first of identical time stamps
+        while ( beg > 0 && curveModel->fetch(beg-1,1,&t,0,0) && t >= start ) {
+            --beg;
+        }
+    }
+    int end = curveModel->indexAtTime(stop);
+    curveModel->fetch(end,1,&t,0,0);
+    if ( t <= stop ) {
+        ++end;
+        while ( end < nrows && curveModel->fetch(end,1,&t,0,0) && t <= stop ) {
+            ++end;
+        }
     }
-    delete it;
     curveModel->unmap();
 
-    return path;
+    path->setRowWindow(beg,end);
+}
+
+// Windows an error (or envelope) path, whose x is time or log10 of time,
+// on time [start,stop].  A path cut to its window is shown whole.
+static void setTimeXPathWindow(CurvePath* path, bool isXLogScale,
+                               double start, double stop)
+{
+    if ( !path->isWholeRun() || !path->isXSorted() ) {
+        path->setWindow(0,path->allPoints().size());
+        return;
+    }
+
+    if ( isXLogScale ) {
+        start = ( start > 0.0 ) ? log10(start) : -DBL_MAX;
+        stop = ( stop > 0.0 ) ? log10(stop) : -DBL_MAX;
+    }
+    path->setXWindow(start,stop);
 }
 
-void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
-                                      bool isUseStartTimeIn, double startTimeIn,
-                                      bool isUseStopTimeIn, double stopTimeIn,
-                                      bool isUseXScaleIn, double xScaleIn,
-                                      bool isUseYScaleIn, double yScaleIn,
-                                      bool isUseXBiasIn, double xBiasIn,
-                                      bool isUseYBiasIn, double yBiasIn,
-                                      const QString &xUnitIn,
-                                      const QString &yUnitIn,
-                                      const QString &plotXScaleIn,
-                                      const QString &plotYScaleIn,
-                                      CurveModel *curveModelIn)
+CurvePathJob PlotBookModel::_curvePathJob(const QModelIndex &curveIdx,
+                                          bool isUseStartTimeIn, double startTimeIn,
+                                          bool isUseStopTimeIn, double stopTimeIn,
+                                          bool isUseXScaleIn, double xScaleIn,
+                                          bool isUseYScaleIn, double yScaleIn,
+                                          bool isUseXBiasIn, double xBiasIn,
+                                          bool isUseYBiasIn, double yBiasIn,
+                                          const QString &xUnitIn,
+                                          const QString &yUnitIn,
+                                          const QString &plotXScaleIn,
+                                          const QString &plotYScaleIn,
+                                          CurveModel *curveModelIn)
 {
     QModelIndex plotIdx = curveIdx.parent().parent();
 
@@ -1203,7 +1811,7 @@ void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
         curveModel = getCurveModel(curveIdx);
     }
     if ( !curveModel ) {
-        fprintf(stderr, "koviz [scoobs]:1: Book::_createPainterPath()\n");
+        fprintf(stderr, "koviz [scoobs]:1: Book::_curvePathJob()\n");
         exit(-1);
     }
 
@@ -1214,7 +1822,7 @@ void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
         if ( isChildIndex(plotIdx,"Plot","PlotXScale") ) {
             plotXScale = getDataString(plotIdx,"PlotXScale","Plot");
         } else {
-            fprintf(stderr, "koviz [scoobs]:2: Book::_createPainterPath()\n");
+            fprintf(stderr, "koviz [scoobs]:2: Book::_curvePathJob()\n");
             exit(-1);
         }
     }
@@ -1222,7 +1830,7 @@ void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
         if ( isChildIndex(plotIdx,"Plot","PlotYScale") ) {
             plotYScale = getDataString(plotIdx,"PlotYScale","Plot");
         } else {
-            fprintf(stderr, "koviz [scoobs]:3: Book::_createPainterPath()\n");
+            fprintf(stderr, "koviz [scoobs]:3: Book::_curvePathJob()\n");
             exit(-1);
         }
     }
@@ -1298,7 +1906,7 @@ void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
         if ( isChildIndex(QModelIndex(),"","StartTime") ) {
             start = getDataDouble(QModelIndex(),"StartTime");
         } else {
-            fprintf(stderr, "koviz [scoobs]:4: Book::_createPainterPath()\n");
+            fprintf(stderr, "koviz [scoobs]:4: Book::_curvePathJob()\n");
             exit(-1);
         }
     }
@@ -1306,67 +1914,182 @@ void PlotBookModel::_createPainterPath(const QModelIndex &curveIdx,
         if ( isChildIndex(QModelIndex(),"","StopTime") ) {
             stop = getDataDouble(QModelIndex(),"StopTime");
         } else {
-            fprintf(stderr, "koviz [scoobs]:5: Book::_createPainterPath()\n");
+            fprintf(stderr, "koviz [scoobs]:5: Book::_curvePathJob()\n");
             exit(-1);
         }
     }
 
-    // Create path and cache it
-    if ( _curve2path.contains(curveModel) ) {
-        QPainterPath* currPath = _curve2path.value(curveModel);
-        delete currPath;
-        _curve2path.remove(curveModel);
-    }
-    QPainterPath* path = __createPainterPath(curveModel,
-                                            (start-tb)/ts,(stop-tb)/ts,
-                                             xs, xb, ys, yb,
-                                            plotXScale, plotYScale);
-    _curve2path.insert(curveModel,path);
+    CurvePathJob job;
+    job.curveModel = curveModel;
+    job.startTime = start;
+    job.stopTime = stop;
+    job.timeBias = tb;
+    job.timeScale = ts;
+    job.xs = xs;
+    job.xb = xb;
+    job.ys = ys;
+    job.yb = yb;
+    job.isXLogScale = ( plotXScale == "log" ) ? true : false;
+    job.isYLogScale = ( plotYScale == "log" ) ? true : false;
+    job.frequency = getDataDouble(QModelIndex(),"Frequency");
+
+    return job;
 }
 
-// curveIdx0/1 are child indices of "Curves" with tagname "Curve"
-//
-// returned path is scaled
+// Builds the job paths on the thread pool and swaps them into the cache.
 //
-// Note: error paths do not do CurveYScale (or bias)
-QPainterPath* PlotBookModel::_createCurvesErrorPath(
-                                            const QModelIndex &curvesIdx) const
+// The batch builds in the background and is swapped in by
+// _curvePathsFinished(), which then tells the views idx changed.  Until
+// then the views draw the old paths.  No event loop is run here, so
+// setData() is never re-entered.  The user may change the time again
+// before it is done.  A supersedable batch cancels the one before it (a
+// new time rebuilds the same curves anyway).  Results for curves that a
+// later batch has taken over are dropped, so the newest rebuild of a
+// curve always wins.
+void PlotBookModel::_createCurvePaths(const QList<CurvePathJob> &jobs,
+                                      const QModelIndex &idx,
+                                      bool isSupersede)
+{
+    int batch = ++_curvePathBatch;
+    foreach ( CurvePathJob job, jobs ) {
+        _curve2batch.insert(job.curveModel,batch);
+    }
+
+    if ( jobs.size() <= 1 ) {
+        // Not worth the thread pool
+        QList<CurvePathJob> results;
+        if ( jobs.size() == 1 ) {
+            CurvePathJob job = jobs.first();
+            job.build();
+            results.append(job);
+        }
+        _swapInCurvePaths(results,batch);
+        if ( idx.isValid() ) {
+            emit dataChanged(idx,idx);
+        }
+        return;
+    }
+
+    QFuture<CurvePathJob> future = QtConcurrent::mapped(jobs,
+                                                        CurvePathBuilder());
+    if ( isSupersede ) {
+        _curvePathFuture.cancel();
+        _curvePathFuture = future;
+    }
+
+    QFutureWatcher<CurvePathJob>* watcher =
+                                     new QFutureWatcher<CurvePathJob>(this);
+    CurvePathBatch curvePathBatch;
+    curvePathBatch.batch = batch;
+    curvePathBatch.idx = idx;
+    _curvePathBatches.insert(watcher,curvePathBatch);
+    connect(watcher,SIGNAL(finished()),this,SLOT(_curvePathsFinished()));
+    watcher->setFuture(future);
+}
+
+void PlotBookModel::_curvePathsFinished()
 {
-    QPainterPath* path = new QPainterPath;
+    QFutureWatcher<CurvePathJob>* watcher =
+                     static_cast<QFutureWatcher<CurvePathJob>*>(sender());
+    if ( !_curvePathBatches.contains(watcher) ) {
+        return;
+    }
+    CurvePathBatch curvePathBatch = _curvePathBatches.take(watcher);
+    watcher->deleteLater();
 
-    if ( !isIndex(curvesIdx,"Curves") ) {
-        fprintf(stderr,"koviz [bad scoobies]:1:"
-                       "PlotBookModel::_createErrorPath()\n");
-        exit(-1);
+    // A cancelled batch was superseded, its curves are rebuilt by the
+    // newer one.  The item value still changed, so views are told.
+    QList<CurvePathJob> results = watcher->future().results();
+    if ( watcher->isCanceled() ) {
+        foreach ( CurvePathJob job, results ) {
+            delete job.path;
+            delete job.lod;
+        }
+    } else {
+        _swapInCurvePaths(results,curvePathBatch.batch);
     }
 
-    if ( rowCount(curvesIdx) != 2 ) {
-        fprintf(stderr,"koviz [bad scoobies]:2:"
-                       "PlotBookModel::_createErrorPath(): "
-                       "Expected two curves for creating an error path.\n");
+    if ( curvePathBatch.idx.isValid() ) {
+        QModelIndex idx = curvePathBatch.idx;
+        emit dataChanged(idx,idx);
+    }
+}
 
+// Swap in all at once, windowed on the book time which may have
+// changed while building
+void PlotBookModel::_swapInCurvePaths(const QList<CurvePathJob> &results,
+                                      int batch)
+{
+    double start = -DBL_MAX;
+    double stop = DBL_MAX;
+    if ( isChildIndex(QModelIndex(),"","StartTime") ) {
+        start = getDataDouble(QModelIndex(),"StartTime");
+    }
+    if ( isChildIndex(QModelIndex(),"","StopTime") ) {
+        stop = getDataDouble(QModelIndex(),"StopTime");
+    }
+    foreach ( CurvePathJob job, results ) {
+        if ( _curve2batch.value(job.curveModel) == batch ) {
+            if ( job.path->isWholeRun() ) {
+                setCurvePathWindow(job.path,job.curveModel,job.isXLogScale,
+                                   (start-job.timeBias)/job.timeScale,
+                                   (stop-job.timeBias)/job.timeScale);
+            }
+            _setCurvePath(job.curveModel,job.path,job.lod);
+        } else {
+            delete job.path;
+            delete job.lod;
+        }
+    }
+}
+
+void PlotBookModel::_setCurvePath(CurveModel *curveModel,
+                                  CurvePath *path, CurveLOD *lod)
+{
+    if ( _curve2path.contains(curveModel) ) {
+        delete _curve2path.take(curveModel);
+    }
+    _curve2path.insert(curveModel,path);
+
+    if ( _curve2lod.contains(curveModel) ) {
+        delete _curve2lod.take(curveModel);
+    }
+    if ( lod ) {
+        _curve2lod.insert(curveModel,lod);
+    }
+}
+
+// Returns the inputs of the error path (curve row0 minus curve row1)
+// of curvesIdx
+CurvesErrorPathKey PlotBookModel::_curvesErrorPathKey(
+                                            const QModelIndex &curvesIdx,
+                                            int row0, int row1) const
+{
+    if ( !isIndex(curvesIdx,"Curves") ) {
+        fprintf(stderr,"koviz [bad scoobies]:1:"
+                       "PlotBookModel::_curvesErrorPathKey()\n");
         exit(-1);
     }
 
-    CurveModel* c0 = getCurveModel(curvesIdx,0);
-    CurveModel* c1 = getCurveModel(curvesIdx,1);
+    CurveModel* c0 = getCurveModel(curvesIdx,row0);
+    CurveModel* c1 = getCurveModel(curvesIdx,row1);
 
     if ( c0 == 0 || c1 == 0 ) {
         fprintf(stderr,"koviz [bad scoobs]:3: "
-                       "PlotBookModel::_createErrorPath(). "
+                       "PlotBookModel::_curvesErrorPathKey(). "
                        "Null curveModel!\n ");
         exit(-1);
     }
 
     if ( c0->t()->unit() != c1->t()->unit() ) {
         fprintf(stderr,"koviz [bad scoobs]:4: "
-                       "PlotBookModel::_createErrorPath().  "
+                       "PlotBookModel::_curvesErrorPathKey().  "
                        "TODO: curveModels time units do not match.\n");
         exit(-1);
     }
 
-    QModelIndex idx0 = index(0,0,curvesIdx);
-    QModelIndex idx1 = index(1,0,curvesIdx);
+    QModelIndex idx0 = index(row0,0,curvesIdx);
+    QModelIndex idx1 = index(row1,0,curvesIdx);
 
     QString curveXName0 = getDataString(idx0,"CurveXName","Curve");
     QString curveXUnit0 = getDataString(idx0,"CurveXUnit","Curve");
@@ -1445,56 +2168,114 @@ QPainterPath* PlotBookModel::_createCurvesErrorPath(
     bool isXLogScale = ( plotXScale == "log" ) ? true : false;
     bool isYLogScale = ( plotYScale == "log" ) ? true : false;
 
-    c0->map();
-    c1->map();
-    ModelIterator* i0 = c0->begin();
-    ModelIterator* i1 = c1->begin();
-    double start = getDataDouble(QModelIndex(),"StartTime");
-    double stop = getDataDouble(QModelIndex(),"StopTime");
-    bool isFirst = true;
-    while ( !i0->isDone() && !i1->isDone() ) {
-        double t0 = xs0*i0->t()+xb0;
-        double t1 = xs1*i1->t()+xb1;
-        double yy = (ys0*i0->y()+yb0) - (ys1*i1->y()+yb1);
+    CurvesErrorPathKey key;
+    key.c0 = c0;
+    key.c1 = c1;
+    key.xs0 = xs0;
+    key.xb0 = xb0;
+    key.ys0 = ys0;
+    key.yb0 = yb0;
+    key.xs1 = xs1;
+    key.xb1 = xb1;
+    key.ys1 = ys1;
+    key.yb1 = yb1;
+    key.tolerance = tolerance;
+    key.isXLogScale = isXLogScale;
+    key.isYLogScale = isYLogScale;
+
+    return key;
+}
+
+bool CurvesErrorPathKey::operator==(const CurvesErrorPathKey &o) const
+{
+    return ( c0 == o.c0 && c1 == o.c1 &&
+             xs0 == o.xs0 && xb0 == o.xb0 && ys0 == o.ys0 && yb0 == o.yb0 &&
+             xs1 == o.xs1 && xb1 == o.xb1 && ys1 == o.ys1 && yb1 == o.yb1 &&
+             tolerance == o.tolerance &&
+             isXLogScale == o.isXLogScale && isYLogScale == o.isYLogScale );
+}
+
+// Batch fetch a curve's time and y, scaled and biased in place
+static void fetchScaledTimeY(CurveModel* curveModel,
+                             double ts, double tb, double ys, double yb,
+                             QVector<double>* T, QVector<double>* Y)
+{
+    int nrows = curveModel->rowCount();
+    T->resize(nrows);
+    Y->resize(nrows);
+    double* t = T->data();
+    double* y = Y->data();
+    for ( int beg = 0; beg < nrows; beg += DataModel::FetchBlockSize ) {
+        curveModel->fetch(beg,DataModel::FetchBlockSize,t+beg,0,y+beg);
+    }
+    for ( int i = 0; i < nrows; ++i ) {
+        t[i] = ts*t[i]+tb;
+        y[i] = ys*y[i]+yb;
+    }
+}
+
+// Appends the errors of the merge-join of the (scaled) curve times to
+// path.  With isCut only errors with time in [start,stop] are appended.
+static void appendCurvesErrors(const CurvesErrorPathKey &key,
+                               const QVector<double>& T0,
+                               const QVector<double>& Y0,
+                               const QVector<double>& T1,
+                               const QVector<double>& Y1,
+                               bool isCut, double start, double stop,
+                               CurvePath* path)
+{
+    const double* ts0 = T0.constData();
+    const double* ys0 = Y0.constData();
+    const double* ts1 = T1.constData();
+    const double* ys1 = Y1.constData();
+    int n0 = T0.size();
+    int n1 = T1.size();
+    int i0 = 0;
+    int i1 = 0;
+    path->reserve(qMin(n0,n1));
+    while ( i0 < n0 && i1 < n1 ) {
+        double t0 = ts0[i0];
+        double t1 = ts1[i1];
+        double yy = ys0[i0] - ys1[i1];
         // Match timestamps as close as possible (freq not used)
         if ( t0 == t1 ) {
-            i0->next();
-            i1->next();
+            ++i0;
+            ++i1;
         } else if ( t0 < t1 ) {
-            i0->next();
-            while ( !i0->isDone() ) {
-                double t00 = xs0*i0->t()+xb0;
+            ++i0;
+            while ( i0 < n0 ) {
+                double t00 = ts0[i0];
                 double dtt = qAbs(t1-t00);
                 if ( dtt < qAbs(t0-t1) ) {
                     t0 = t00;
-                    yy = (ys0*i0->y()+yb0) - (ys1*i1->y()+yb1);
-                    i0->next();
+                    yy = ys0[i0] - ys1[i1];
+                    ++i0;
                 } else {
                     break;
                 }
             }
-            i1->next();
+            ++i1;
         } else if ( t0 > t1 ) {
-            i1->next();
-            while ( !i1->isDone() ) {
-                double t11 = xs1*i1->t()+xb1;
+            ++i1;
+            while ( i1 < n1 ) {
+                double t11 = ts1[i1];
                 double dtt = qAbs(t0-t11);
                 if ( dtt < qAbs(t1-t0) ) {
                     t1 = t11;
-                    yy = (ys0*i0->y()+yb0) - (ys1*i1->y()+yb1);
-                    i1->next();
+                    yy = ys0[i0] - ys1[i1];
+                    ++i1;
                 } else {
                     break;
                 }
             }
-            i0->next();
+            ++i0;
         } else {
             // bad scoobs, but step to avoid inf loop
-            i0->next();
-            i1->next();
+            ++i0;
+            ++i1;
         }
-        if ( qAbs(t1-t0) <= tolerance ) {
-            if ( isYLogScale ) {
+        if ( qAbs(t1-t0) <= key.tolerance ) {
+            if ( key.isYLogScale ) {
                 if ( yy > 0 ) {
                     yy = log10(yy);
                 } else if ( yy < 0 ) {
@@ -1503,26 +2284,50 @@ QPainterPath* PlotBookModel::_createCurvesErrorPath(
                     continue; // skip log(0) since -inf
                 }
             }
-            if ( t0 >= start && t0 <= stop ) {
-                if ( isXLogScale && t0 == 0.0 ) {
+            double x = t0;
+            if ( key.isXLogScale ) {
+                if ( t0 == 0.0 ) {
                     continue;
                 }
-                if ( isXLogScale ) {
-                    t0 = log10(t0);
-                }
-                if ( isFirst ) {
-                    path->moveTo(t0,yy);
-                    isFirst = false;
-                } else {
-                    path->lineTo(t0,yy);
-                }
+                x = log10(t0);
+            }
+            if ( isCut && !(t0 >= start && t0 <= stop) ) {
+                continue;
             }
+            path->append(x,yy);
         }
     }
-    delete i0;
-    delete i1;
-    c0->unmap();
-    c1->unmap();
+}
+
+// returned path is scaled, its x is time (see setTimeXPathWindow())
+//
+// Note: error paths do not do CurveYScale (or bias)
+//
+// Only reads the curve models so it can run on worker threads
+static CurvePath* createCurvesErrorPath(const CurvesErrorPathKey &key,
+                                        double start, double stop)
+{
+    QVector<double> T0;
+    QVector<double> Y0;
+    QVector<double> T1;
+    QVector<double> Y1;
+    key.c0->map();
+    key.c1->map();
+    fetchScaledTimeY(key.c0,key.xs0,key.xb0,key.ys0,key.yb0,&T0,&Y0);
+    fetchScaledTimeY(key.c1,key.xs1,key.xb1,key.ys1,key.yb1,&T1,&Y1);
+    key.c0->unmap();
+    key.c1->unmap();
+
+    CurvePath* path = new CurvePath;
+    appendCurvesErrors(key,T0,Y0,T1,Y1,false,start,stop,path);
+    if ( !path->isXSorted() ) {
+        // Can't be windowed on x, keep only the errors in the window
+        delete path;
+        path = new CurvePath;
+        appendCurvesErrors(key,T0,Y0,T1,Y1,true,start,stop,path);
+        path->setWholeRun(false);
+    }
+    path->squeeze();
 
     return path;
 }
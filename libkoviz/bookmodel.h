@@ -10,6 +10,9 @@
 #include <QPaintEngine>
 #include <QString>
 #include <QStringList>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QPersistentModelIndex>
 #if QT_VERSION >= 0x050000
 #include <QRegularExpressionMatch>
 #include <QHashFunctions>
@@ -18,10 +21,114 @@
 #include "unit.h"
 #include "utils.h"
 #include "curvemodel.h"
+#include "curvepath.h"
+#include "curvelod.h"
 
 #include <QList>
 #include <QColor>
 #include <cmath>
+#include <float.h>
+
+// Everything needed to build a curve path, read out of the book on the
+// gui thread so the path can be built on a worker thread
+struct CurvePathJob
+{
+    CurvePathJob() :
+        curveModel(0),
+        startTime(-DBL_MAX), stopTime(DBL_MAX),
+        timeBias(0.0), timeScale(1.0),
+        xs(1.0), xb(0.0), ys(1.0), yb(0.0),
+        isXLogScale(false), isYLogScale(false),
+        frequency(0.0),
+        path(0), lod(0)
+    {}
+    void build();  // creates path (and lod if curve is big)
+
+    CurveModel* curveModel;
+    double startTime;  // book time
+    double stopTime;
+    double timeBias;   // time shift/scale from book to curve time
+    double timeScale;
+    double xs;
+    double xb;
+    double ys;
+    double yb;
+    bool isXLogScale;
+    bool isYLogScale;
+    double frequency;
+    CurvePath* path;
+    CurveLOD* lod;
+
+  private:
+    bool _appendPoints(bool isCut, double start, double stop);
+};
+
+// A batch of curve path jobs building on the thread pool
+struct CurvePathBatch
+{
+    CurvePathBatch() : batch(0) {}
+    int batch;
+    QPersistentModelIndex idx;  // views are told it changed when done
+};
+
+// Inputs of an error path (curve 0 minus curve 1).  A cached error
+// path is rebuilt when they change.
+struct CurvesErrorPathKey
+{
+    CurvesErrorPathKey() :
+        c0(0), c1(0),
+        xs0(1.0), xb0(0.0), ys0(1.0), yb0(0.0),
+        xs1(1.0), xb1(0.0), ys1(1.0), yb1(0.0),
+        tolerance(0.0),
+        isXLogScale(false), isYLogScale(false)
+    {}
+    bool operator==(const CurvesErrorPathKey& o) const;
+
+    CurveModel* c0;
+    CurveModel* c1;
+    double xs0;  // time scale/bias
+    double xb0;
+    double ys0;  // with unit scale/bias
+    double yb0;
+    double xs1;
+    double xb1;
+    double ys1;
+    double yb1;
+    double tolerance;
+    bool isXLogScale;
+    bool isYLogScale;
+};
+
+struct CurvesErrorPath
+{
+    CurvesErrorPath() : id(0), path(0), start(-DBL_MAX), stop(DBL_MAX) {}
+    CurvesErrorPathKey key;
+    int id;        // unique per built path
+    CurvePath* path;
+    double start;  // window of a path that isn't a whole run
+    double stop;
+};
+
+// Min and max over runs of the errors against a baseline run, on the
+// baseline time stamps.  Rebuilt when any of its error paths is.
+struct CurvesErrorEnvelope
+{
+    CurvesErrorEnvelope() : minPath(0), maxPath(0) {}
+    QList<int> pathIds;
+    CurvePath* minPath;
+    CurvePath* maxPath;
+};
+
+// Baseline error paths building on the thread pool
+struct CurvesErrorPathBatch
+{
+    CurvesErrorPathBatch() : batch(0), start(-DBL_MAX), stop(DBL_MAX) {}
+    int batch;
+    QList<CurvesErrorPathKey> keys;
+    QList<QPersistentModelIndex> curveDataIdxs;  // views are told when done
+    double start;
+    double stop;
+};
 
 class PlotBookModel : public QStandardItemModel
 {
@@ -41,7 +148,7 @@ public:
     double yScale(const QModelIndex& curveIdx) const;
     double xBias(const QModelIndex& curveIdx, CurveModel* curveModelIn=0) const;
     double yBias(const QModelIndex& curveIdx) const;
-    QRectF calcCurvesBBox(const QModelIndex& curvesIdx) const;
+    QRectF calcCurvesBBox(const QModelIndex& curvesIdx);
 
     QStandardItem* addChild(QStandardItem* parentItem,
                             const QString& childTitle,
@@ -93,8 +200,16 @@ public:
     CurveModel* getCurveModel(const QModelIndex& curvesIdx, int i) const;
     CurveModel* getCurveModel(const QModelIndex& curveIdx) const;
 
-    QPainterPath* getPainterPath(const QModelIndex& curveIdx) const;
-    QPainterPath* getCurvesErrorPath(const QModelIndex& curvesIdx);
+    CurvePath* getCurvePath(const QModelIndex& curveIdx) const;
+    const CurveLOD* getCurveLOD(const QModelIndex& curveIdx) const;
+    CurvePath* getCurvesErrorPath(const QModelIndex& curvesIdx) const;
+    QList<CurvePath*> getCurvesBaselineErrorPaths(
+                                        const QModelIndex& curvesIdx,
+                                        bool isWait=true);
+    QList<CurvePath*> getCurvesBaselineErrorEnvelope(
+                                        const QModelIndex& curvesIdx,
+                                        bool isWait=true);
+    bool isBaselinePresentation(const QString& presentation) const;
     QString getCurvesXUnit(const QModelIndex& curvesIdx);
     QString getCurvesYUnit(const QModelIndex& curvesIdx);
     bool isXTime(const QModelIndex& plotIdx) const;
@@ -147,6 +262,10 @@ signals:
     
 public slots:
 
+private slots:
+    void _curvePathsFinished();
+    void _curvesErrorPathsFinished();
+
 private:
     QStringList _timeNames;
     Runs* _runs;
@@ -157,26 +276,51 @@ private:
                         const QString& ancestorText,
                         const QString &expectedStartIdxText=QString()) const;
 
-    QHash<CurveModel*,QPainterPath*> _curve2path;
-    void _createPainterPath(const QModelIndex& curveIdx,
-                            bool isUseStartTimeIn, double startTimeIn,
-                            bool isUseStopTimeIn, double stopTimeIn,
-                            bool isUseXScaleIn, double xScaleIn,
-                            bool isUseYScaleIn, double yScaleIn,
-                            bool isUseXBiasIn, double xBiasIn,
-                            bool isUseYBiasIn, double yBiasIn,
-                            const QString &xUnitIn=QString(""),
-                            const QString& yUnitIn=QString(""),
-                            const QString& plotXScaleIn=QString(""),
-                            const QString& plotYScaleIn=QString(""),
-                            CurveModel* curveModelIn=0);
-    QPainterPath* __createPainterPath(CurveModel *curveModel,
-                                      double startTime, double stopTime,
-                                      double xs, double xb,
-                                      double ys, double yb,
-                                      const QString& plotXScale,
-                                      const QString& plotYScale);
-    QPainterPath* _createCurvesErrorPath(const QModelIndex& curvesIdx) const;
+    QHash<CurveModel*,CurvePath*> _curve2path;
+    QHash<CurveModel*,CurveLOD*> _curve2lod;  // only big curves have a lod
+    CurvePathJob _curvePathJob(const QModelIndex& curveIdx,
+                               bool isUseStartTimeIn, double startTimeIn,
+                               bool isUseStopTimeIn, double stopTimeIn,
+                               bool isUseXScaleIn, double xScaleIn,
+                               bool isUseYScaleIn, double yScaleIn,
+                               bool isUseXBiasIn, double xBiasIn,
+                               bool isUseYBiasIn, double yBiasIn,
+                               const QString &xUnitIn=QString(""),
+                               const QString& yUnitIn=QString(""),
+                               const QString& plotXScaleIn=QString(""),
+                               const QString& plotYScaleIn=QString(""),
+                               CurveModel* curveModelIn=0);
+    bool _setDataAndRebuild(const QModelIndex& idx,
+                            const QVariant& value, int role,
+                            const QList<CurvePathJob>& jobs,
+                            bool isSupersede=false);
+    void _createCurvePaths(const QList<CurvePathJob>& jobs,
+                           const QModelIndex& idx=QModelIndex(),
+                           bool isSupersede=false);
+    void _swapInCurvePaths(const QList<CurvePathJob>& results, int batch);
+    void _setCurvePath(CurveModel* curveModel,
+                       CurvePath* path, CurveLOD* lod);
+    int _curvePathBatch;
+    QHash<CurveModel*,int> _curve2batch;  // last batch to rebuild curve
+    QFuture<CurvePathJob> _curvePathFuture; // supersedable batch in flight
+    QHash<QFutureWatcher<CurvePathJob>*,CurvePathBatch> _curvePathBatches;
+    mutable QHash<CurveModel*,CurvesErrorPath> _curve2errorPath; // by c0
+    mutable int _errorPathCount;
+    // Envelopes by baseline curve (c1 of their error paths)
+    QHash<CurveModel*,CurvesErrorEnvelope> _curve2errorEnvelope;
+    int _errorPathBatch;
+    // Error path builds in flight by c0 (id is the batch building it)
+    QHash<CurveModel*,CurvesErrorPath> _curve2errorPathBuild;
+    QHash<QFutureWatcher<CurvePath*>*,CurvesErrorPathBatch> _errorPathBatches;
+    CurvesErrorPathKey _curvesErrorPathKey(const QModelIndex& curvesIdx,
+                                           int row0=0, int row1=1) const;
+    CurvesErrorPath _cachedCurvesErrorPath(const CurvesErrorPathKey& key,
+                                           double start, double stop) const;
+    CurvesErrorPath _cacheCurvesErrorPath(const CurvesErrorPathKey& key,
+                                          CurvePath* path,
+                                          double start, double stop) const;
+    int _baselineRow(const QModelIndex& curvesIdx) const;
+    void _removeCurvesErrorPaths(CurveModel* curveModel);
 
     QString _commonRootName(const QStringList& names, const QString& sep) const;
     QString __commonRootName(const QString& a, const QString& b,
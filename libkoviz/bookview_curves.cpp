@@ -317,20 +317,23 @@ void CoordArrow::paintMeCenter(QPainter &painter,
 
 CurvesView::CurvesView(QWidget *parent) :
     BookIdxView(parent),
-    _pixmap(0)
+    _isPixmapDirty(true),
+    _renderID(new QAtomicInt(0))
 {
     setFocusPolicy(Qt::StrongFocus);
     setFrameShape(QFrame::NoFrame);
 
     // Set mouse tracking to receive mouse move events when button not pressed
     setMouseTracking(true);
+
+    connect(&_renderWatcher,SIGNAL(finished()),
+            this,SLOT(_renderFinished()));
 }
 
 CurvesView::~CurvesView()
 {
-    if ( _pixmap ) {
-        delete _pixmap;
-    }
+    // Cancel render job (jobs keep their own copy of the curves)
+    _renderID->fetchAndAddOrdered(1);
     foreach ( TimeAndIndex* marker, _markers ) {
         delete marker;
     }
@@ -403,9 +406,21 @@ void CurvesView::paintEvent(QPaintEvent *event)
     painter.setPen(pen);
 
     // Draw curves
-    if ( nCurves == 2 ) {
-        QString plotPresentation = _bookModel()->getDataString(rootIndex(),
+    QString plotPresentation = _bookModel()->getDataString(rootIndex(),
                                                      "PlotPresentation","Plot");
+    if ( nCurves >= 2 &&
+         _bookModel()->isBaselinePresentation(plotPresentation) ) {
+
+        // Plot background
+        QModelIndex pageIdx = rootIndex().parent().parent();
+        QColor bg = _bookModel()->pageBackgroundColor(pageIdx);
+        painter.fillRect(viewport()->rect(),bg);
+
+        _paintGrid(painter,rootIndex());
+
+        _paintBaselineErrorplot(T,painter,pen,rootIndex(),plotPresentation);
+
+    } else if ( nCurves == 2 ) {
         if ( plotPresentation.isEmpty() ) {
             plotPresentation = _bookModel()->getDataString(QModelIndex(),
                                                            "Presentation");
@@ -432,6 +447,14 @@ void CurvesView::paintEvent(QPaintEvent *event)
             exit(-1);
         }
     } else {
+
+        // Plot background
+        QModelIndex pageIdx = rootIndex().parent().parent();
+        QColor bg = _bookModel()->pageBackgroundColor(pageIdx);
+        painter.fillRect(viewport()->rect(),bg);
+
+        _paintGrid(painter,rootIndex());
+
         _paintCoplot(T,painter,pen);
     }
 
@@ -451,14 +474,27 @@ void CurvesView::_paintCoplot(const QTransform &T,QPainter &painter,QPen &pen)
 {
     Q_UNUSED(pen);
 
-    if ( !_pixmap ) return;
+    if ( _isPixmapDirty ) {
+        _startRender();
+    }
 
     painter.save();
 
-    // Draw pixmap of all curves
+    // Draw pixmap of all curves.  While a new one is rendered, the last one
+    // is moved from the transform it was drawn with to this one.
     QTransform I;
     painter.setTransform(I);
-    painter.drawPixmap(viewport()->rect(),*_pixmap);
+    if ( !_pixmap.isNull() ) {
+        bool isInvertible = false;
+        QTransform Tinv = _pixmapT.inverted(&isInvertible);
+        if ( isInvertible ) {
+            painter.setTransform(Tinv*T);
+            painter.drawPixmap(0,0,_pixmap);
+            painter.setTransform(I);
+        } else {
+            painter.drawPixmap(viewport()->rect(),_pixmap);
+        }
+    }
 
     // If curve is selected
     QModelIndex gpidx = currentIndex().parent().parent();
@@ -485,195 +521,240 @@ void CurvesView::_paintCurve(const QModelIndex& curveIdx,
                              const QTransform& T,
                              QPainter& painter, bool isHighlight)
 {
-    painter.save();
-    QPen origPen = painter.pen();
+    CurveDrawItem item;
+    if ( _curveDrawItem(curveIdx,T,isHighlight,&item) ) {
+        _drawCurve(item,painter);
+    }
+}
 
+// Gathers what it takes to draw the curve (gui thread only),
+// returns false if there is no curve to draw
+bool CurvesView::_curveDrawItem(const QModelIndex& curveIdx,
+                                const QTransform& T, bool isHighlight,
+                                CurveDrawItem* item)
+{
     CurveModel* curveModel = _bookModel()->getCurveModel(curveIdx);
+    if ( !curveModel ) {
+        return false;
+    }
 
-    if ( curveModel ) {
-
-        // Line color
-        QPen pen;
-        pen.setWidth(0);
-        QColor color(_bookModel()->getDataString(curveIdx,
-                                                 "CurveColor","Curve"));
-        if ( isHighlight ) {
-            QModelIndex pageIdx = curveIdx.parent().parent().parent().parent();
-            QColor bg = _bookModel()->pageBackgroundColor(pageIdx);
-            if ( bg.lightness() < 128 ) {
-                color = color.lighter(120);
-            } else {
-                color = color.darker(200);
-            }
+    // Line color
+    QColor color(_bookModel()->getDataString(curveIdx,"CurveColor","Curve"));
+    if ( isHighlight ) {
+        QModelIndex pageIdx = curveIdx.parent().parent().parent().parent();
+        QColor bg = _bookModel()->pageBackgroundColor(pageIdx);
+        if ( bg.lightness() < 128 ) {
+            color = color.lighter(120);
+        } else {
+            color = color.darker(200);
         }
-        pen.setColor(color);
+    }
+    item->color = color;
+
+    // Line style pattern
+    QString linestyle =  _bookModel()->getDataString(curveIdx,
+                                                     "CurveLineStyle","Curve");
+    item->pattern = _bookModel()->getLineStylePattern(linestyle);
+    item->lineStyle = linestyle.toLower();
+
+    // Symbols on curve
+    QString symbolStyle = _bookModel()->getDataString(curveIdx,
+                                                   "CurveSymbolStyle", "Curve");
+    item->symbolStyle = symbolStyle.toLower();
+
+    // Get painter path
+    CurvePath* path = _bookModel()->getCurvePath(curveIdx);
+    item->points = path->allPoints();
+    item->beg = path->windowBegin();
+    item->end = path->windowEnd();
+
+    // Get plot scale
+    QModelIndex plotIdx = curveIdx.parent().parent();
+    QString plotXScale = _bookModel()->getDataString(plotIdx,
+                                                     "PlotXScale","Plot");
+    QString plotYScale = _bookModel()->getDataString(plotIdx,
+                                                     "PlotYScale","Plot");
 
-        // Line style pattern
-        QString linestyle =  _bookModel()->getDataString(curveIdx,
-                                                      "CurveLineStyle","Curve");
-        QVector<qreal> pattern = _bookModel()->getLineStylePattern(linestyle);
-        pen.setDashPattern(pattern);
+    // Scale transform (e.g. for unit axis scaling)
+    // If logscale, scale/bias done in CurvePathJob::build()
+    double xs = 1.0;
+    double ys = 1.0;
+    double xb = 0.0;
+    double yb = 0.0;
+    if ( plotXScale == "linear" ) {
+        xs = _bookModel()->xScale(curveIdx);
+        xb = _bookModel()->xBias(curveIdx);
+    }
+    if ( plotYScale == "linear" ) {
+        ys = _bookModel()->yScale(curveIdx);
+        yb = _bookModel()->yBias(curveIdx);
+    }
+    QTransform Tscaled(T);
+    Tscaled = Tscaled.scale(xs,ys);
+    Tscaled = Tscaled.translate(xb/xs,yb/ys);
+    item->T = Tscaled;
+
+    // "Flatline=#" label if curve is flat (constant)
+    QRectF cbox = path->boundingRect();
+    if ( cbox.height() == 0.0 && path->count() > 0 ) {
+        double y = cbox.y()*ys+yb;
+        if (plotYScale=="log") {
+            y = pow(10,y) ;
+        }
+        item->label = QString("Flatline=%1").arg(y);
+        QRectF tbox = Tscaled.mapRect(cbox);
+        double top = tbox.y()-fontMetrics().ascent();
+        if ( top >= 0 ) {
+            // Draw flatline label over curve
+            item->labelPos = tbox.topLeft()-QPointF(0,5);
+        } else {
+            // Draw flatline label under curve since it would drawn off page
+            item->labelPos = tbox.topLeft()+
+                             QPointF(0,fontMetrics().ascent())+QPointF(0,5);
+        }
+    } else if ( path->count() == 0 ) {
+        // Empty plot
+        item->label = "Empty";
+        QRect bb = fontMetrics().boundingRect(item->label);
+        QRect R = viewport()->rect();
+        item->labelPos = R.center()+QPointF(-bb.width()/2,0);
+    }
 
-        // Set pen
-        painter.setPen(pen);
+    // Big curves are drawn with min/max points per pixel column
+    const CurveLOD* lod = _bookModel()->getCurveLOD(curveIdx);
+    item->isLOD = ( lod != 0 );
+    if ( lod ) {
+        QRectF V = Tscaled.inverted().mapRect(QRectF(viewport()->rect()));
+        item->lodPoints = lod->polyline(path->windowBegin(),path->windowEnd(),
+                                        V.left(),V.right(),
+                                        viewport()->rect().width());
+    }
 
-        // Get painter path
-        QPainterPath* path = _bookModel()->getPainterPath(curveIdx);
+    return true;
+}
 
-        // Get plot scale
-        QModelIndex plotIdx = curveIdx.parent().parent();
-        QString plotXScale = _bookModel()->getDataString(plotIdx,
-                                                         "PlotXScale","Plot");
-        QString plotYScale = _bookModel()->getDataString(plotIdx,
-                                                         "PlotYScale","Plot");
+// Draws a curve without touching the book (safe on worker threads)
+void CurvesView::_drawCurve(const CurveDrawItem& item, QPainter& painter)
+{
+    painter.save();
+    QPen origPen = painter.pen();
 
-        // Scale transform (e.g. for unit axis scaling)
-        // If logscale, scale/bias done in _createPainterPath
-        double xs = 1.0;
-        double ys = 1.0;
-        double xb = 0.0;
-        double yb = 0.0;
-        if ( plotXScale == "linear" ) {
-            xs = _bookModel()->xScale(curveIdx);
-            xb = _bookModel()->xBias(curveIdx);
-        }
-        if ( plotYScale == "linear" ) {
-            ys = _bookModel()->yScale(curveIdx);
-            yb = _bookModel()->yBias(curveIdx);
-        }
-        QTransform Tscaled(T);
-        Tscaled = Tscaled.scale(xs,ys);
-        Tscaled = Tscaled.translate(xb/xs,yb/ys);
-        painter.setTransform(Tscaled);
+    // Line color and style pattern
+    QPen pen;
+    pen.setWidth(0);
+    pen.setColor(item.color);
+    QVector<qreal> pattern = item.pattern;
+    pen.setDashPattern(pattern);
 
-        // Draw "Flatline=#" label if curve is flat (constant)
-        QRectF cbox = path->boundingRect();
-        if ( cbox.height() == 0.0 && path->elementCount() > 0 ) {
-            double y = cbox.y()*ys+yb;
-            if (plotYScale=="log") {
-                y = pow(10,y) ;
-            }
-            QString yString = QString("Flatline=%1").arg(y);
-            QRectF tbox = Tscaled.mapRect(cbox);
-            QTransform I;
-            painter.setTransform(I);
-            double top = tbox.y()-fontMetrics().ascent();
-            if ( top >= 0 ) {
-                // Draw flatline label over curve
-                painter.drawText(tbox.topLeft()-QPointF(0,5),yString);
-            } else {
-                // Draw flatline label under curve since it would drawn off page
-                painter.drawText(tbox.topLeft()+
-                                 QPointF(0,fontMetrics().ascent())
-                                 +QPointF(0,5),yString);
-            }
-            painter.setTransform(Tscaled);
-        } else if ( path->elementCount() == 0 ) {
-            // Empty plot
-            QTransform I;
-            painter.setTransform(I);
-            QString lbl("Empty");
-            QRect bb = fontMetrics().boundingRect(lbl);
-            QRect R = viewport()->rect();
-            painter.drawText(R.center()+QPointF(-bb.width()/2,0),lbl);
-            painter.setTransform(Tscaled);
-        }
+    // Set pen
+    painter.setPen(pen);
 
-        // Line style
-        QString lineStyle = _bookModel()->getDataString(curveIdx,
-                                                      "CurveLineStyle","Curve");
-        lineStyle = lineStyle.toLower();
+    const QTransform& Tscaled = item.T;
+    painter.setTransform(Tscaled);
 
-        // Draw curve!
-        if ( lineStyle == "thick_line" || lineStyle == "x_thick_line" ) {
-            // The transform cannot be used when drawing thick lines
-            QTransform I;
-            painter.setTransform(I);
-            double w = pen.widthF();
-            if ( lineStyle == "thick_line" ) {
-                pen.setWidth(3.0);
-            } else if ( lineStyle == "x_thick_line" ) {
-                pen.setWidthF(5.0);
+    // Draw "Flatline=#" or "Empty" label
+    if ( !item.label.isEmpty() ) {
+        QTransform I;
+        painter.setTransform(I);
+        painter.drawText(item.labelPos,item.label);
+        painter.setTransform(Tscaled);
+    }
+
+    const QPointF* points = item.points.constData()+item.beg;
+    int count = item.end-item.beg;
+    const QString& lineStyle = item.lineStyle;
+
+    // Draw curve!
+    if ( lineStyle == "thick_line" || lineStyle == "x_thick_line" ) {
+        // The transform cannot be used when drawing thick lines
+        QTransform I;
+        painter.setTransform(I);
+        double w = pen.widthF();
+        if ( lineStyle == "thick_line" ) {
+            pen.setWidth(3.0);
+        } else if ( lineStyle == "x_thick_line" ) {
+            pen.setWidthF(5.0);
+        } else {
+            fprintf(stderr, "koviz [bad scoobs]: "
+                            "CurvesView::_drawCurve: bad linestyle\n");
+            exit(-1);
+        }
+        painter.setPen(pen);
+        QPointF pLast;
+        int nPoints = item.isLOD ? item.lodPoints.size() : count;
+        for ( int i = 0; i < nPoints; ++i ) {
+            QPointF p;
+            if ( item.isLOD ) {
+                p = item.lodPoints.at(i);
             } else {
-                fprintf(stderr, "koviz [bad scoobs]: "
-                                "CurvesView::_paintCurve: bad linestyle\n");
-                exit(-1);
+                p = points[i];
             }
-            painter.setPen(pen);
-            QPointF pLast;
-            for ( int i = 0; i < path->elementCount(); ++i ) {
-                QPainterPath::Element el = path->elementAt(i);
-                QPointF p(el.x,el.y);
-                p = Tscaled.map(p);
-                if  ( i > 0 ) {
-                    painter.drawLine(pLast,p);
-                }
-                pLast = p;
+            p = Tscaled.map(p);
+            if  ( i > 0 ) {
+                painter.drawLine(pLast,p);
             }
-            pen.setWidthF(w);
-            painter.setPen(pen);
-            painter.setTransform(Tscaled);
-        } else if ( lineStyle == "scatter" ) {
-            QTransform I;
-            painter.setTransform(I);
-            double w = pen.widthF();
-            pen.setWidthF(1.5);
-            painter.setPen(pen);
-            QBrush origBrush = painter.brush();
-            QBrush brush(Qt::SolidPattern);
-            brush.setColor(color);
-            painter.setBrush(brush);
-            double r = pen.widthF();
-            for ( int i = 0; i < path->elementCount(); ++i ) {
-                QPainterPath::Element el = path->elementAt(i);
-                QPointF p(el.x,el.y);
-                p = Tscaled.map(p);
-                painter.drawEllipse(p,r,r);
-            }
-            pen.setWidthF(w);
-            painter.setPen(pen);
-            painter.setBrush(origBrush);
-            painter.setTransform(Tscaled);
-        } else {
-            painter.drawPath(*path);
+            pLast = p;
+        }
+        pen.setWidthF(w);
+        painter.setPen(pen);
+        painter.setTransform(Tscaled);
+    } else if ( lineStyle == "scatter" ) {
+        QTransform I;
+        painter.setTransform(I);
+        double w = pen.widthF();
+        pen.setWidthF(1.5);
+        painter.setPen(pen);
+        QBrush origBrush = painter.brush();
+        QBrush brush(Qt::SolidPattern);
+        brush.setColor(item.color);
+        painter.setBrush(brush);
+        double r = pen.widthF();
+        for ( int i = 0; i < count; ++i ) {
+            QPointF p = Tscaled.map(points[i]);
+            painter.drawEllipse(p,r,r);
         }
+        pen.setWidthF(w);
+        painter.setPen(pen);
+        painter.setBrush(origBrush);
+        painter.setTransform(Tscaled);
+    } else if ( item.isLOD ) {
+        painter.drawPolyline(item.lodPoints);
+    } else {
+        painter.drawPolyline(points,count);
+    }
 
-        // Draw symbols on curve (if there are any)
-        QString symbolStyle = _bookModel()->getDataString(curveIdx,
-                                               "CurveSymbolStyle", "Curve");
-        symbolStyle = symbolStyle.toLower();
-        if ( !symbolStyle.isEmpty() && symbolStyle != "none" ) {
-            pattern.clear();
-            pen.setDashPattern(pattern); // plain lines for drawing symbols
-            QTransform I;
-            painter.setTransform(I);
-            double w = pen.widthF();
-            pen.setWidthF(0.0);
-            painter.setPen(pen);
-            QPointF pLast;
-            for ( int i = 0; i < path->elementCount(); ++i ) {
-                QPainterPath::Element el = path->elementAt(i);
-                QPointF p(el.x,el.y);
-                p = Tscaled.map(p);
-                if ( i > 0 ) {
-                    double r = 32.0;
-                    double x = pLast.x()-r/2.0;
-                    double y = pLast.y()-r/2.0;
-                    QRectF R(x,y,r,r);
-                    if ( R.contains(p) ) {
-                        continue;
-                    }
+    // Draw symbols on curve (if there are any)
+    const QString& symbolStyle = item.symbolStyle;
+    if ( !symbolStyle.isEmpty() && symbolStyle != "none" ) {
+        pattern.clear();
+        pen.setDashPattern(pattern); // plain lines for drawing symbols
+        QTransform I;
+        painter.setTransform(I);
+        double w = pen.widthF();
+        pen.setWidthF(0.0);
+        painter.setPen(pen);
+        QPointF pLast;
+        for ( int i = 0; i < count; ++i ) {
+            QPointF p = Tscaled.map(points[i]);
+            if ( i > 0 ) {
+                double r = 32.0;
+                double x = pLast.x()-r/2.0;
+                double y = pLast.y()-r/2.0;
+                QRectF R(x,y,r,r);
+                if ( R.contains(p) ) {
+                    continue;
                 }
+            }
 
-                __paintSymbol(p,symbolStyle,painter);
+            __paintSymbol(p,symbolStyle,painter);
 
-                pLast = p;
-            }
-            pen.setWidthF(w);
-            painter.setPen(pen);
-            painter.setTransform(Tscaled);
+            pLast = p;
         }
+        pen.setWidthF(w);
+        painter.setPen(pen);
+        painter.setTransform(Tscaled);
     }
+
     painter.setPen(origPen);
     painter.restore();
 }
@@ -780,20 +861,17 @@ void CurvesView::_paintMarkers(QPainter &painter)
         }
 
         // Get path
-        QPainterPath* path = 0;
+        CurvePath* path = 0;
         if ( tag == "Curve" ) {
             QModelIndex curveIdx = marker->modelIdx();
-            path = _bookModel()->getPainterPath(curveIdx);
+            path = _bookModel()->getCurvePath(curveIdx);
         } else if ( tag == "Plot" ) {
             QModelIndex plotIdx = marker->modelIdx();
             QModelIndex curvesIdx = _bookModel()->getIndex(plotIdx,
                                                            "Curves","Plot");
             path = _bookModel()->getCurvesErrorPath(curvesIdx);
         }
-        if ( path->elementCount() == 0 ) {
-            if ( tag == "Plot" ) {
-                delete path; // error path created on the fly!
-            }
+        if ( path->count() == 0 ) {
             continue;
         }
 
@@ -810,13 +888,13 @@ void CurvesView::_paintMarkers(QPainter &painter)
         }
 
         // Get element index (i) for time (t)
-        int high = path->elementCount()-1;
+        int high = path->count()-1;
         int i = _idxAtTimeBinarySearch(path,0,high,t);
 
         /* There may be duplicate timestamps in sequence - go to first */
-        double elementTime = path->elementAt(i).x;
+        double elementTime = path->x(i);
         while ( i > 0 ) {
-            if ( path->elementAt(i-1).x == elementTime ) {
+            if ( path->x(i-1) == elementTime ) {
                 --i;
             } else {
                 break;
@@ -875,8 +953,7 @@ void CurvesView::_paintMarkers(QPainter &painter)
         }
 
         // Element/coord at live time
-        QPainterPath::Element el = path->elementAt(i);
-        QPointF coord(el.x*xs+xb,el.y*ys+yb);
+        QPointF coord(path->x(i)*xs+xb,path->y(i)*ys+yb);
 
         // Init arrow struct
         CoordArrow arrow;
@@ -885,12 +962,12 @@ void CurvesView::_paintMarkers(QPainter &painter)
         // Set arrow text (special syntax for extremums)
         QString x=isXLogScale ? _format(pow(10,coord.x())) : _format(coord.x());
         QString y=isYLogScale ? _format(pow(10,coord.y())) : _format(coord.y());
-        int rc = path->elementCount();
+        int rc = path->count();
         if ( i > 0 && i < rc-1) {
             // First and last point not considered
-            double yPrev = path->elementAt(i-1).y*ys+yb;
-            double yi = path->elementAt(i).y*ys+yb;
-            double yNext = path->elementAt(i+1).y*ys+yb;
+            double yPrev = path->y(i-1)*ys+yb;
+            double yi = path->y(i)*ys+yb;
+            double yNext = path->y(i+1)*ys+yb;
             if ( (yi>yPrev && yi>yNext) || (yi<yPrev && yi<yNext) ) {
                 arrow.txt = QString("<%1, %2>").arg(x).arg(y);
             } else if ( yPrev == yi && yi != yNext ) {
@@ -958,19 +1035,62 @@ void CurvesView::_paintMarkers(QPainter &painter)
     }
 }
 
-int CurvesView::_idxAtTimeBinarySearch(QPainterPath* path,
+// Sets j/k to the first/last window index of the points around i with x
+// in (x0,x1).  Binary searches if the path x is sorted, else walks out
+// from i.
+static void xNeighborhood(const CurvePath* path, int i, double x0, double x1,
+                          int* j, int* k)
+{
+    if ( path->isXSorted() ) {
+        *j = qMin(i,path->upperBoundX(x0));
+        *k = qMax(i,path->lowerBoundX(x1)-1);
+        return;
+    }
+
+    *j = i;
+    while ( *j > 0 && path->x(*j-1) > x0 ) {
+        --(*j);
+    }
+    *k = i;
+    while ( *k+1 < path->count() && path->x(*k+1) < x1 ) {
+        ++(*k);
+    }
+}
+
+// Sets j/k to the first/last window index of the run of points with
+// the x of point i (identical timestamps)
+static void xRun(const CurvePath* path, int i, int* j, int* k)
+{
+    double x = path->x(i);
+    if ( path->isXSorted() ) {
+        *j = path->lowerBoundX(x);
+        *k = path->upperBoundX(x)-1;
+        return;
+    }
+
+    *j = i;
+    while ( *j > 0 && path->x(*j-1) == x ) {
+        --(*j);
+    }
+    *k = i;
+    while ( *k+1 < path->count() && path->x(*k+1) == x ) {
+        ++(*k);
+    }
+}
+
+int CurvesView::_idxAtTimeBinarySearch(CurvePath* path,
                                        int low, int high, double time)
 {
         if (high <= 0 ) {
                 return 0;
         }
         if (low >= high) {
-                return ( path->elementAt(high).x > time ) ? high-1 : high;
+                return ( path->x(high) > time ) ? high-1 : high;
         } else {
                 int mid = (low + high)/2;
-                if (time == path->elementAt(mid).x ) {
+                if (time == path->x(mid) ) {
                         return mid;
-                } else if ( time < path->elementAt(mid).x ) {
+                } else if ( time < path->x(mid) ) {
                         return _idxAtTimeBinarySearch(path,
                                                       low, mid-1, time);
                 } else {
@@ -1154,7 +1274,7 @@ void CurvesView::_paintErrorplot(const QTransform &T,
     painter.save();
 
     QModelIndex curvesIdx = _bookModel()->getIndex(plotIdx,"Curves","Plot");
-    QPainterPath* errorPath = _bookModel()->getCurvesErrorPath(curvesIdx);
+    CurvePath* errorPath = _bookModel()->getCurvesErrorPath(curvesIdx);
 
     QRectF ebox = errorPath->boundingRect();
     QPen ePen(pen);
@@ -1165,7 +1285,7 @@ void CurvesView::_paintErrorplot(const QTransform &T,
         ePen.setColor(_bookModel()->errorLineColor());
     }
     painter.setPen(ePen);
-    if ( ebox.height() == 0.0 && errorPath->elementCount() > 0 ) {
+    if ( ebox.height() == 0.0 && errorPath->count() > 0 ) {
         // Flatline
         QString yval;
         if ( ebox.y() == 0.0 ) {
@@ -1177,7 +1297,7 @@ void CurvesView::_paintErrorplot(const QTransform &T,
         painter.setTransform(I);
         QRectF tbox = T.mapRect(ebox);
         painter.drawText(tbox.topLeft()-QPointF(0,5),yval);
-    } else if ( errorPath->elementCount() == 0 ) {
+    } else if ( errorPath->count() == 0 ) {
         // Empty plot
         QTransform I;
         painter.setTransform(I);
@@ -1187,9 +1307,48 @@ void CurvesView::_paintErrorplot(const QTransform &T,
         painter.drawText(R.center()+QPointF(-bb.width()/2,0),lbl);
     }
     painter.setTransform(T);
-    painter.drawPath(*errorPath);
+    painter.drawPolyline(errorPath->constData(),errorPath->count());
 
-    delete errorPath;
+    painter.setPen(pen);
+    painter.restore();
+}
+
+// Errors of all runs against the baseline run in their curve colors,
+// or the min/max envelope of the errors
+void CurvesView::_paintBaselineErrorplot(const QTransform &T,
+                                         QPainter &painter, const QPen &pen,
+                                         const QModelIndex& plotIdx,
+                                         const QString& presentation)
+{
+    painter.save();
+
+    QModelIndex curvesIdx = _bookModel()->getIndex(plotIdx,"Curves","Plot");
+    QPen ePen(pen);
+    painter.setTransform(T);
+    if ( presentation == "baseline_envelope" ) {
+        ePen.setColor(_bookModel()->errorLineColor());
+        painter.setPen(ePen);
+        foreach ( CurvePath* path,
+                  _bookModel()->getCurvesBaselineErrorEnvelope(curvesIdx,
+                                                               false) ) {
+            painter.drawPolyline(path->constData(),path->count());
+        }
+    } else {
+        QList<CurvePath*> paths =
+                  _bookModel()->getCurvesBaselineErrorPaths(curvesIdx,false);
+        for ( int i = 0; i < paths.size(); ++i ) {
+            CurvePath* path = paths.at(i);
+            if ( !path ) {
+                continue;  // baseline
+            }
+            QModelIndex curveIdx = model()->index(i,0,curvesIdx);
+            QColor color(_bookModel()->getDataString(curveIdx,
+                                                     "CurveColor","Curve"));
+            ePen.setColor(color);
+            painter.setPen(ePen);
+            painter.drawPolyline(path->constData(),path->count());
+        }
+    }
 
     painter.setPen(pen);
     painter.restore();
@@ -1221,10 +1380,7 @@ void CurvesView::dataChanged(const QModelIndex &topLeft,
         QRectF M = model()->data(topLeft).toRectF();
 
         if ( M.size().width() > 0 && M.size().height() != 0 && _lastM != M ) {
-            if ( _pixmap ) {
-                delete _pixmap;
-            }
-            _pixmap = _createLivePixmap();
+            _invalidatePixmap();
         }
 
         _lastM = M;  // Saved so that pixmap is not recreated if M unchanged
@@ -1274,69 +1430,114 @@ void CurvesView::dataChanged(const QModelIndex &topLeft,
         }
     } else if ( topLeft.parent().parent().parent() == rootIndex() ) {
         if ( tag == "CurveXBias" ) {
-            if ( _pixmap ) {
-                delete _pixmap;
-            }
-            _pixmap = _createLivePixmap();
+            _invalidatePixmap();
         } else if ( tag == "CurveColor") {
-            if ( _pixmap ) {
-                delete _pixmap;
-            }
-            _pixmap = _createLivePixmap();
+            _invalidatePixmap();
         } else if ( tag == "CurveData") {
-            if ( _pixmap ) {
-                delete _pixmap;
-            }
-            _pixmap = _createLivePixmap();
+            _invalidatePixmap();
         }
     } else if ( topLeft.parent() == rootIndex() ) {
         if ( tag == "PlotXScale" || tag == "PlotYScale" ) {
-            if ( _pixmap ) {
-                delete _pixmap;
-            }
-            _pixmap = _createLivePixmap();
+            _invalidatePixmap();
             QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),
                                                            "Curves","Plot");
             QRectF bbox = _bookModel()->calcCurvesBBox(curvesIdx);
             _bookModel()->setPlotMathRect(bbox,rootIndex());
         }
+    } else if ( !topLeft.parent().isValid() && rootIndex().isValid() &&
+                (tag == "StartTime" || tag == "StopTime") ) {
+        // The book tells views a new start/stop time once the curve paths
+        // are rebuilt (paths of unsorted time rebuild in the background)
+        _invalidatePixmap();
+        QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),
+                                                       "Curves","Plot");
+        QRectF bbox = _bookModel()->calcCurvesBBox(curvesIdx);
+        _bookModel()->setPlotMathRect(bbox,rootIndex());
     }
 
     viewport()->update();
     update();
 }
 
-QPixmap* CurvesView::_createLivePixmap()
+// Cancels the render in progress (if any) and marks the pixmap for a
+// new render on the next paint.  The last pixmap is drawn until then.
+void CurvesView::_invalidatePixmap()
+{
+    _renderID->fetchAndAddOrdered(1);
+    _isPixmapDirty = true;
+}
+
+// Gathers the curves on the gui thread and renders them on the pool
+void CurvesView::_startRender()
 {
+    _isPixmapDirty = false;
+
     if ( viewport()->rect().size().width() == 0 ||
          viewport()->rect().size().height() == 0 ) {
-        return 0;
+        return;
     }
     bool isCurves  = _bookModel()->isChildIndex(rootIndex(),"Plot","Curves");
     if ( !isCurves ) {
-        return 0;
+        return;
     }
 
-    QPixmap* livePixmap = new QPixmap(viewport()->rect().size());
-
-    QPainter painter(livePixmap);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    QModelIndex pageIdx = rootIndex().parent().parent();
-    QColor bg = _bookModel()->pageBackgroundColor(pageIdx);
-    painter.fillRect(viewport()->rect(),bg);
-
-    _paintGrid(painter, rootIndex());
+    PlotRenderJob job;
+    job.id = _renderID->fetchAndAddOrdered(0);
+    job.renderID = _renderID;
+    job.size = viewport()->rect().size();
+    job.T = _coordToPixelTransform();
+    job.font = font();
 
-    QTransform T = _coordToPixelTransform();
     QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),"Curves","Plot");
     int rc = model()->rowCount(curvesIdx);
     for ( int i = 0; i < rc; ++i ) {
         QModelIndex curveIdx = model()->index(i,0,curvesIdx);
-        _paintCurve(curveIdx,T,painter,false);
+        CurveDrawItem item;
+        if ( _curveDrawItem(curveIdx,job.T,false,&item) ) {
+            job.curves.append(item);
+        }
     }
 
-    return livePixmap;
+    // A newer job replaces the one being watched, which quits early
+    _renderWatcher.setFuture(QtConcurrent::run(_renderPlot,job));
+}
+
+// Renders curves into a transparent image (called on worker threads)
+PlotImage CurvesView::_renderPlot(const PlotRenderJob& job)
+{
+    PlotImage plotImage;
+    plotImage.id = job.id;
+    plotImage.T = job.T;
+
+    QImage image(job.size,QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(job.font);
+    foreach ( const CurveDrawItem& item, job.curves ) {
+        if ( job.renderID->fetchAndAddOrdered(0) != job.id ) {
+            return plotImage; // cancelled
+        }
+        _drawCurve(item,painter);
+    }
+    painter.end();
+
+    plotImage.image = image;
+    return plotImage;
+}
+
+void CurvesView::_renderFinished()
+{
+    PlotImage plotImage = _renderWatcher.result();
+    if ( plotImage.image.isNull() ||
+         plotImage.id != _renderID->fetchAndAddOrdered(0) ) {
+        return; // cancelled or stale
+    }
+
+    _pixmap = QPixmap::fromImage(plotImage.image);
+    _pixmapT = plotImage.T;
+    viewport()->update();
 }
 
 QString CurvesView::_format(double d)
@@ -1491,51 +1692,31 @@ void CurvesView::mouseReleaseEvent(QMouseEvent *event)
     }
 }
 
-// Choose first curve found within 12 pixel square about pt
+// Choose the curve nearest pt that passes within a few pixels of it
 QModelIndex CurvesView::_chooseCurveNearMousePoint(const QPoint &pt)
 {
     QModelIndex idx;
 
-    QImage img(viewport()->rect().size(),QImage::Format_Mono);
-
-    QPainter painter(&img);
-    QPen penBlack(img.colorTable().at(0));
-    penBlack.setWidth(0);
-    painter.setPen(penBlack);
-
-    QTransform T = _coordToPixelTransform();  // _paintCurve sets painter tform
-
-    int s = 12; // side length of small square around mouse click
-    QRectF R(pt.x()-s/2,pt.y()-s/2,s,s);
-
-    // Speed up test by drawing clipped to small square
-    painter.setClipRect(R);
+    QTransform T = _coordToPixelTransform();
 
-    QRectF W = viewport()->rect();
-    QRectF M = _mathRect();
-    double a = M.width()/W.width();
-    double b = M.height()/W.height();
-    double c = M.x() - a*W.x();
-    double d = M.y() - b*W.y();
-    QTransform U( a,    0,
-                  0,    b, /*+*/ c,    d);
-    M = U.mapRect(R);
+    // Half side length of small square around mouse click
+    double r = 6.0;
 
     QString plotXScale = _bookModel()->getDataString(rootIndex(),
                                                      "PlotXScale","Plot");
     QString plotYScale = _bookModel()->getDataString(rootIndex(),
                                                      "PlotYScale","Plot");
 
+    // Each path is searched with its bounding box tree, so picking doesn't
+    // draw anything or depend on the viewport size (see CurvePath)
+    double dMin = DBL_MAX;
     QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),"Curves","Plot");
     int rc = model()->rowCount(curvesIdx);
-    for ( int i = rc-1; i >= 0; --i ) {  // check curves from top to bottom
-
-        // fill image with white (see help for QImage::fill(int))
-        img.fill(1);
+    for ( int i = rc-1; i >= 0; --i ) {  // on a tie, top curve wins
 
         // Get underlying path that goes with curve
         QModelIndex curveIdx = model()->index(i,0,curvesIdx);
-        QPainterPath* path = _bookModel()->getPainterPath(curveIdx);
+        CurvePath* path = _bookModel()->getCurvePath(curveIdx);
         if ( !path ) {
             continue;
         }
@@ -1556,47 +1737,12 @@ QModelIndex CurvesView::_chooseCurveNearMousePoint(const QPoint &pt)
         QTransform Tscaled(T);
         Tscaled = Tscaled.scale(xs,ys);
         Tscaled = Tscaled.translate(xb/xs,yb/ys);
-        painter.setTransform(Tscaled);
-
-        // Ignore paths whose bounding box does not intersect
-        // math click rect. This speeds up a special case of
-        // selecting a spike which falls outside most other curves
-        if ( xs == 1.0 && ys == 1.0 && xb == 0 && yb == 0 ) {
-            // TODO: Lazily checking for xs==ys==1.0 because of scaling issues
-            if ( !path->intersects(M) ) {
-                continue;
-            }
-        }
-
-        // Draw curve onto monochrome image (clipped to small square)
-        painter.drawPath(*path);
 
-        // Check, pixel by pixel, to see if the curve
-        // is in small rectangle around mouse click
-        bool isFound = false;
-        for ( int x = pt.x()-s/2; x < pt.x()+s/2; ++x ) {
-            if ( x < 0 || x >= img.width() ) {
-                continue;
-            }
-            for ( int y = pt.y()-s/2; y < pt.y()+s/2; ++y ) {
-                if ( y < 0 || y >= img.height() ) {
-                    continue;
-                }
-                QRgb pix = img.pixel(x,y);
-                if ( qRed(pix) == 0 ) {
-                    // qRed(pix) is arbitrary. Pen is black and has no red.
-                    isFound = true;
-                    break;
-                }
-            }
-            if ( isFound ) break;
-        }
-        if ( isFound ) {
-            idx = curveIdx;  // choose first curve inside rect and bail
-            break;
+        double d = path->distanceTo(pt,r,Tscaled);
+        if ( d >= 0.0 && d < dMin ) {
+            dMin = d;
+            idx = curveIdx;
         }
-
-
     }
 
     return idx;
@@ -1606,67 +1752,15 @@ bool CurvesView::_isErrorCurveNearMousePoint(const QPoint &pt)
 {
     bool isNear = false;
 
-    QImage img(viewport()->rect().size(),QImage::Format_Mono);
-
-    QPainter painter(&img);
-    QPen penBlack(img.colorTable().at(0));
-    penBlack.setWidth(0);
-    painter.setPen(penBlack);
-
-    QTransform T = _coordToPixelTransform();  // _paintCurve sets painter tform
-
-    int s = 12; // side length of small square around mouse click
-    QRectF R(pt.x()-s/2,pt.y()-s/2,s,s);
-
-    // Speed up test by drawing clipped to small square
-    painter.setClipRect(R);
+    QTransform T = _coordToPixelTransform();
 
-    QRectF W = viewport()->rect();
-    QRectF M = _mathRect();
-    double a = M.width()/W.width();
-    double b = M.height()/W.height();
-    double c = M.x() - a*W.x();
-    double d = M.y() - b*W.y();
-    QTransform U( a,    0,
-                  0,    b, /*+*/ c,    d);
-    M = U.mapRect(R);
+    // Half side length of small square around mouse click
+    double r = 6.0;
 
     QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),"Curves","Plot");
-    QPainterPath* path = _bookModel()->getCurvesErrorPath(curvesIdx);
+    CurvePath* path = _bookModel()->getCurvesErrorPath(curvesIdx);
     if ( path ) {
-
-        // fill image with white (see help for QImage::fill(int))
-        img.fill(1);
-
-        painter.setTransform(T);
-
-        if ( path->intersects(M) ) {
-
-            // Draw curve onto monochrome image (clipped to small square)
-            painter.drawPath(*path);
-
-            // Check, pixel by pixel, to see if the curve
-            // is in small rectangle around mouse click
-            for ( int x = pt.x()-s/2; x < pt.x()+s/2; ++x ) {
-                if ( x < 0 || x >= img.width() ) {
-                    continue;
-                }
-                for ( int y = pt.y()-s/2; y < pt.y()+s/2; ++y ) {
-                    if ( y < 0 || y >= img.height() ) {
-                        continue;
-                    }
-                    QRgb pix = img.pixel(x,y);
-                    if ( qRed(pix) == 0 ) {
-                        // qRed(pix) is arbitrary. Pen is black and has no red.
-                        isNear = true;
-                        break;
-                    }
-                }
-                if ( isNear ) break;
-            }
-        }
-
-        delete path;
+        isNear = ( path->distanceTo(pt,r,T) >= 0.0 );
     }
 
     return isNear;
@@ -1719,8 +1813,8 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                                                                  QModelIndex(),
                                                                "LiveCoordTime");
 
-                QPainterPath* path = _bookModel()->getPainterPath(curveIdx);
-                int rc = path->elementCount();
+                CurvePath* path = _bookModel()->getCurvePath(curveIdx);
+                int rc = path->count();
 
                 QString plotXScale = _bookModel()->getDataString(plotIdx,
                                                            "PlotXScale","Plot");
@@ -1751,14 +1845,11 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
 
                     } else if ( rc == 1 ) {
 
-                        QPainterPath::Element el = path->elementAt(0);
-                        liveCoord = QPointF(el.x,el.y);
+                        liveCoord = path->at(0);
 
                     } else if ( rc == 2 ) {
-                        QPainterPath::Element el0 = path->elementAt(0);
-                        QPainterPath::Element el1 = path->elementAt(1);
-                        QPointF p0(el0.x*xs+xb,el0.y*ys+yb);
-                        QPointF p1(el1.x*xs+xb,el1.y*ys+yb);
+                        QPointF p0(path->x(0)*xs+xb,path->y(0)*ys+yb);
+                        QPointF p1(path->x(1)*xs+xb,path->y(1)*ys+yb);
                         QLineF l0(p0,mPt);
                         QLineF l1(p1,mPt);
                         if ( l0.length() < l1.length() ) {
@@ -1771,8 +1862,7 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
 
                         int i =  _idxAtTimeBinarySearch(path,0,rc-1,
                                                         (mPt.x()-xb)/xs);
-                        QPainterPath::Element el = path->elementAt(i);
-                        QPointF p(el.x*xs+xb,el.y*ys+yb);
+                        QPointF p(path->x(i)*xs+xb,path->y(i)*ys+yb);
 
                         //
                         // Make "neighborhood" around mouse point
@@ -1783,63 +1873,46 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                         double Mr = Wr*(M.width()/W.width());
 
                         // Set j/k for finding min/maxs in next block of code
-                        int j = i;
-                        int k = i;
-                        int nels = path->elementCount();
-                        double iTime = path->elementAt(i).x;
+                        int j;
+                        int k;
+                        double iTime = path->x(i);
                         double startTime = iTime - Mr;
                         double endTime = iTime + Mr;
-                        for ( int l = i ; l >= 0; --l ) {
-                            double lTime = path->elementAt(l).x;
-                            if ( lTime > startTime ) {
-                                j = l;
-                            } else {
-                                break;
-                            }
-                        }
-                        for ( int l = i ; l < nels; ++l ) {
-                            double lTime = path->elementAt(l).x;
-                            if ( lTime < endTime ) {
-                                k = l;
-                            } else {
-                                break;
-                            }
-                        }
+                        xNeighborhood(path,i,startTime,endTime,&j,&k);
 
                         //
-                        // Find local min/maxs in neighborhood
+                        // Find local min/maxs in neighborhood.  The highest
+                        // strict local max (y above both neighbors) and
+                        // lowest strict local min are tree searches of the
+                        // path (a flat top is not a local max).
                         //
                         QList<QPointF> localMaxs;
                         QList<QPointF> localMins;
                         QList<QPointF> flatChangePOIs;
-                        for (int m = j; m <= k; ++m ) {
-                            QPointF pt(path->elementAt(m).x*xs+xb,
-                                       path->elementAt(m).y*ys+yb);
+                        int iMax = path->indexOfLocalMaxY(j,k);
+                        int iMin = path->indexOfLocalMinY(j,k);
+                        if ( ys < 0.0 ) {
+                            qSwap(iMax,iMin);
+                        }
+                        if ( iMax >= 0 ) {
+                            localMaxs << QPointF(path->x(iMax)*xs+xb,
+                                                 path->y(iMax)*ys+yb);
+                        }
+                        if ( iMin >= 0 ) {
+                            localMins << QPointF(path->x(iMin)*xs+xb,
+                                                 path->y(iMin)*ys+yb);
+                        }
+                        // Steps are only looked for if there's no min/max
+                        bool isMonotone = localMaxs.isEmpty() &&
+                                          localMins.isEmpty();
+                        for (int m = j; isMonotone && m <= k; ++m ) {
+                            QPointF pt(path->x(m)*xs+xb,
+                                       path->y(m)*ys+yb);
                             if ( m > 0 && m < k ) {
-                                double yPrev = path->elementAt(m-1).y*ys+yb;
-                                double y  = path->elementAt(m).y*ys+yb;
-                                double yNext = path->elementAt(m+1).y*ys+yb;
-                                if ( y > yPrev && y > yNext ) {
-                                    if ( localMaxs.isEmpty() ) {
-                                        localMaxs << pt;
-                                    } else {
-                                        if ( pt.y() > localMaxs.first().y() ) {
-                                            localMaxs.prepend(pt);
-                                        } else {
-                                            localMaxs << pt;
-                                        }
-                                    }
-                                } else if ( y < yPrev && y < yNext ) {
-                                    if ( localMins.isEmpty() ) {
-                                        localMins << pt;
-                                    } else {
-                                        if ( pt.y() < localMins.first().y() ) {
-                                            localMins.prepend(pt);
-                                        } else {
-                                            localMins << pt;
-                                        }
-                                    }
-                                } else if ( yPrev == y && y != yNext ) {
+                                double yPrev = path->y(m-1)*ys+yb;
+                                double y  = path->y(m)*ys+yb;
+                                double yNext = path->y(m+1)*ys+yb;
+                                if ( yPrev == y && y != yNext ) {
                                     if ( mPt.x() <= pt.x() ) {
                                         // mouse left of change
                                         flatChangePOIs.prepend(pt);
@@ -1860,13 +1933,13 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                         if ( j == 0 || wPt.x()/W.width() < 0.02 ) {
                             // Mouse near curve start or left 2% of window,
                             // set to start pt
-                            liveCoord = QPointF(path->elementAt(0).x*xs+xb,
-                                                path->elementAt(0).y*ys+yb);
+                            liveCoord = QPointF(path->x(0)*xs+xb,
+                                                path->y(0)*ys+yb);
                         } else if ( k == rc-1 || wPt.x()/W.width() > 0.98 ) {
                             // Mouse near curve end or right 2% of window,
                             // set to last pt
-                            liveCoord = QPointF(path->elementAt(k).x*xs+xb,
-                                                path->elementAt(k).y*ys+yb);
+                            liveCoord = QPointF(path->x(k)*xs+xb,
+                                                path->y(k)*ys+yb);
                         } else {
                             bool isMaxs = localMaxs.isEmpty() ? false : true;
                             bool isMins = localMins.isEmpty() ? false : true;
@@ -1922,46 +1995,17 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                         time = log10(time);
                     }
                     int i =  _idxAtTimeBinarySearch(path,0,rc-1,(time-xb)/xs);
-                    double iTime = path->elementAt(i).x;
-                    int j = i;  // j is start index of identical timestamps
-                    for ( int l = i; l >= 0; --l ) {
-                        double lTime = path->elementAt(l).x;
-                        if ( iTime != lTime ) {
-                            break;
-                        } else {
-                            j = l;
-                        }
-                    }
-                    int nels = path->elementCount();
-                    int k = j; // k is last index of identical timestamps
-                    for (int l = j; l < nels; ++l) {
-                        double lTime = path->elementAt(l).x;
-                        if ( iTime != lTime ) {
-                            break;
-                        } else {
-                            k = l;
-                        }
-                    }
+                    // j/k are start/last index of identical timestamps
+                    int j;
+                    int k;
+                    xRun(path,i,&j,&k);
                     int liveCoordTimeIdx = 0;
                     if ( k - j > 1 ) {
                         // Find index of max y of identical timestamps
                         // Note: min is not used even if mouse below curve.
                         //       This is because I simply didn't want any
                         //       more code
-                        double maxY = -DBL_MAX;
-                        int m = 0 ;
-                        for (int l = j; l <= k; ++l) {
-                            double x = path->elementAt(l).x;
-                            double y = path->elementAt(l).y;
-                            if ( y > maxY ) {
-                                maxY = y;
-                                liveCoordTimeIdx = m;
-                            }
-                            if ( x != iTime ) {
-                                break;
-                            }
-                            ++m;
-                        }
+                        liveCoordTimeIdx = qMax(0,path->indexOfMaxY(j,k+1)-j);
                     }
                     QModelIndex idx = _bookModel()->getDataIndex(
                                                        QModelIndex(),
@@ -1973,60 +2017,20 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                                                              "StartTime");
                     double stop = _bookModel()->getDataDouble(QModelIndex(),
                                                             "StopTime");
-                    double xb = _bookModel()->xBias(currentIndex());
-                    double xs = _bookModel()->xScale(currentIndex());
-                    double yb = _bookModel()->yBias(currentIndex());
-                    double ys = _bookModel()->yScale(currentIndex());
-                    bool isXLogScale = (plotXScale=="log") ? true : false;
-                    bool isYLogScale = (plotYScale=="log") ? true : false;
+
+                    // Find closest point on curve to mouse with a nearest
+                    // point search of the path tree (the path is in the
+                    // time range and logscale paths are already scaled)
                     double liveTime = DBL_MAX;
-                    double dMin = DBL_MAX;
                     QTransform T = _coordToPixelTransform();
-                    curveModel->map();
-                    ModelIterator* it = curveModel->begin();
-                    while ( !it->isDone() ) {
-                        // find closest point on curve to mouse
-                        double x = it->x()*xs+xb;
-                        if ( isXLogScale ) {
-                            if ( x > 0 ) {
-                                x = log10(x);
-                            } else if ( x < 0 ) {
-                                x = log10(-x);
-                            } else if ( x == 0 ) {
-                                it->next();
-                                continue; // skip since log(0) -inf
-                            } else {
-                                // bad scoobs
-                                it->next();
-                                continue;
-                            }
-                        }
-                        double y = it->y()*ys+yb;
-                        if ( isYLogScale ) {
-                            if ( y > 0 ) {
-                                y = log10(y);
-                            } else if ( y < 0 ) {
-                                y = log10(-y);
-                            } else if ( y == 0 ) {
-                                it->next();
-                                continue; // skip since log(0) -inf
-                            } else {
-                                // bad scoobs
-                                it->next();
-                                continue;
-                            }
-                        }
-                        QPointF p(x,y);
-                        QPointF q = T.map(p);
-                        double d = QLineF(wPt,q).length();
-                        if ( d < dMin && start <= it->t() && it->t() <= stop ) {
-                            dMin = d;
-                            liveTime = it->t();
-                        }
-                        it->next();
+                    T = T.scale(xs,ys);
+                    T = T.translate(xb/xs,yb/ys);
+                    int i = path->nearestPoint(wPt,T);
+                    if ( i >= 0 ) {
+                        curveModel->map();
+                        curveModel->fetch(path->row(i),1,&liveTime,0,0);
+                        curveModel->unmap();
                     }
-                    delete it;
-                    curveModel->unmap();
 
                     // Set live coord in model
                     if ( liveTime <= start ) {
@@ -2047,15 +2051,15 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
 
             // TODO: This code block is almost a duplicate of the code block
             //       above for compare plot.  The difference is that the
-            //       error data is an unscaled/biased QPainterPath.
+            //       error data is an unscaled/biased CurvePath.
             QModelIndex curvesIdx =  _bookModel()->getIndex(rootIndex(),
                                                             "Curves","Plot");
-            QPainterPath* path = _bookModel()->getCurvesErrorPath(curvesIdx);
+            CurvePath* path = _bookModel()->getCurvesErrorPath(curvesIdx);
             QModelIndex liveTimeIdx = _bookModel()->getDataIndex(
                                                                QModelIndex(),
                                                                "LiveCoordTime");
 
-            int rc = path->elementCount();
+            int rc = path->count();
             QPointF liveCoord(DBL_MAX,DBL_MAX);
 
             if ( rc == 0 ) {
@@ -2065,15 +2069,12 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
 
             } else if ( rc == 1 ) {
 
-                QPainterPath::Element el = path->elementAt(0);
-                liveCoord = QPointF(el.x,el.y);
+                liveCoord = path->at(0);
 
             } else if ( rc == 2 ) {
 
-                QPainterPath::Element el0 = path->elementAt(0);
-                QPainterPath::Element el1 = path->elementAt(1);
-                QPointF p0(el0.x,el0.y);
-                QPointF p1(el1.x,el1.y);
+                QPointF p0 = path->at(0);
+                QPointF p1 = path->at(1);
                 QLineF l0(p0,mPt);
                 QLineF l1(p1,mPt);
                 if ( l0.length() < l1.length() ) {
@@ -2085,8 +2086,7 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
             } else if ( rc >= 3 ) {
 
                 int i =  _idxAtTimeBinarySearch(path,0,rc-1,mPt.x());
-                QPainterPath::Element el = path->elementAt(i);
-                QPointF p(el.x,el.y);
+                QPointF p = path->at(i);
 
                 //
                 // Make "neighborhood" around mouse point
@@ -2097,62 +2097,25 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                 double Mr = Wr*(M.width()/W.width());
 
                 // Set j and k for finding min/maxs
-                int j = i;
-                int k = i;
-                int nels = path->elementCount();
-                double iTime = path->elementAt(i).x;
+                int j;
+                int k;
+                double iTime = path->x(i);
                 double startTime = iTime - Mr;
                 double endTime = iTime + Mr;
-                for ( int l = i ; l >= 0; --l ) {
-                    double lTime = path->elementAt(l).x;
-                    if ( lTime > startTime ) {
-                        j = l;
-                    } else {
-                        break;
-                    }
-                }
-                for ( int l = i ; l < nels; ++l ) {
-                    double lTime = path->elementAt(l).x;
-                    if ( lTime < endTime ) {
-                        k = l;
-                    } else {
-                        break;
-                    }
-                }
+                xNeighborhood(path,i,startTime,endTime,&j,&k);
 
                 //
-                // Find local min/maxs in neighborhood
+                // Find local min/maxs in neighborhood (see compare above)
                 //
                 QList<QPointF> localMaxs;
                 QList<QPointF> localMins;
-                for (int m = j; m <= k; ++m ) {
-                    QPointF pt(path->elementAt(m).x,path->elementAt(m).y);
-                    if ( m > 0 && m < k ) {
-                        double yPrev = path->elementAt(m-1).y;
-                        double y  = path->elementAt(m).y;
-                        double yNext = path->elementAt(m+1).y;
-                        if ( y > yPrev && y > yNext ) {
-                            if ( localMaxs.isEmpty() ) {
-                                localMaxs << pt;
-                            } else {
-                                if ( pt.y() > localMaxs.first().y() ) {
-                                    localMaxs.prepend(pt);
-                                } else {
-                                    localMaxs << pt;
-                                }
-                            }
-                        } else if ( y < yPrev && y < yNext ) {
-                            if ( localMins.isEmpty() ) {
-                                localMins << pt;
-                            } else {
-                                if ( pt.y() < localMins.first().y() ) {
-                                    localMins.prepend(pt);
-                                } else {
-                                    localMins << pt;
-                                }
-                            }
-                        }
-                    }
+                int iMax = path->indexOfLocalMaxY(j,k);
+                int iMin = path->indexOfLocalMinY(j,k);
+                if ( iMax >= 0 ) {
+                    localMaxs << path->at(iMax);
+                }
+                if ( iMin >= 0 ) {
+                    localMins << path->at(iMin);
                 }
 
                 //
@@ -2161,12 +2124,10 @@ void CurvesView::mouseMoveEvent(QMouseEvent *event)
                 //
                 if ( j == 0 ) {
                     // Mouse near start of curve, set to start pt
-                    liveCoord = QPointF(path->elementAt(0).x,
-                                        path->elementAt(0).y);
+                    liveCoord = path->at(0);
                 } else if ( k == rc-1 ) {
                     // Mouse near end of curve, set to last pt
-                    liveCoord = QPointF(path->elementAt(k).x,
-                                        path->elementAt(k).y);
+                    liveCoord = path->at(k);
                 } else {
                     bool isMaxs = localMaxs.isEmpty() ? false : true;
                     bool isMins = localMins.isEmpty() ? false : true;
@@ -2308,26 +2269,46 @@ void CurvesView::currentChanged(const QModelIndex &current,
 
 void CurvesView::resizeEvent(QResizeEvent *event)
 {
-    if ( _pixmap ) {
-        delete _pixmap;
-    }
-    _pixmap = _createLivePixmap();
+    _invalidatePixmap();
 
     QAbstractItemView::resizeEvent(event);
 }
 
+// Cancel rendering when off screen, it is restarted on the next paint
+void CurvesView::hideEvent(QHideEvent *event)
+{
+    if ( _renderWatcher.isRunning() ) {
+        _invalidatePixmap();
+    }
+
+    QAbstractItemView::hideEvent(event);
+}
+
 // For two curves hitting the spacebar will toggle between viewing
-// the two curves in error, compare and error+compare views
+// the two curves in error, compare and error+compare views.
+// If the book presentation is a baseline one, it toggles between the
+// baseline errors, their envelope and compare views (for two or more curves)
 void CurvesView::_keyPressSpace()
 {
     QModelIndex curvesIdx = _bookModel()->getIndex(rootIndex(),"Curves","Plot");
     int rc = model()->rowCount(curvesIdx);
-    if ( rc != 2 ) return;
+    QString bookPresentation = _bookModel()->getDataString(QModelIndex(),
+                                                           "Presentation");
+    bool isBaseline = _bookModel()->isBaselinePresentation(bookPresentation);
+    if ( rc < 2 || (rc > 2 && !isBaseline) ) return;
 
     QString plotPresentation = _bookModel()->getDataString(rootIndex(),
                                                    "PlotPresentation","Plot");
 
-    if ( plotPresentation == "error" || plotPresentation.isEmpty() ) {
+    if ( isBaseline ) {
+        if ( plotPresentation == "baseline_error" ) {
+            plotPresentation = "baseline_envelope";
+        } else if ( plotPresentation == "baseline_envelope" ) {
+            plotPresentation = "compare";
+        } else {
+            plotPresentation = "baseline_error";
+        }
+    } else if ( plotPresentation == "error" || plotPresentation.isEmpty() ) {
         plotPresentation = "compare";
     } else if ( plotPresentation == "compare" ) {
         plotPresentation = "error+compare";
@@ -11,6 +11,7 @@
 #include <QMouseEvent>
 #include <QRubberBand>
 #include <QFocusEvent>
+#include <QHideEvent>
 #include <QKeyEvent>
 #include <QSizeF>
 #include <QLineF>
@@ -19,6 +20,11 @@
 #include <QImage>
 #include <QFontMetrics>
 #include <QPoint>
+#include <QFont>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include <stdlib.h>
 #include <float.h>
 #include <math.h>
@@ -111,6 +117,47 @@ class CoordArrow
                        const QColor &fg, const QColor &bg) const;
 };
 
+// What it takes to draw a curve, gathered from the book on the gui thread
+// so that it can be drawn on a worker thread (points are shared copies)
+class CurveDrawItem
+{
+  public:
+    QPolygonF points;     // Whole path, the window is [beg,end)
+    int beg;
+    int end;
+    bool isLOD;
+    QPolygonF lodPoints;  // Min/max points per pixel column if isLOD
+    QTransform T;         // Math to pixel with curve scale and bias
+    QColor color;
+    QVector<qreal> pattern;
+    QString lineStyle;
+    QString symbolStyle;
+    QString label;        // e.g. "Flatline=3.14" drawn at labelPos (pixels)
+    QPointF labelPos;
+};
+
+// Curves of a plot to render into an image on a worker thread.
+// A job is cancelled when renderID no longer holds its id.
+class PlotRenderJob
+{
+  public:
+    int id;
+    QSharedPointer<QAtomicInt> renderID;
+    QSize size;
+    QTransform T;
+    QFont font;
+    QList<CurveDrawItem> curves;
+};
+
+class PlotImage
+{
+  public:
+    PlotImage() : id(-1) {}
+    int id;
+    QImage image;   // Null if the job was cancelled
+    QTransform T;   // Math to pixel transform the image was drawn with
+};
+
 class CurvesView : public BookIdxView
 {
     Q_OBJECT
@@ -133,6 +180,7 @@ protected:
     virtual void currentChanged(const QModelIndex& current,
                                 const QModelIndex& previous);
     virtual void resizeEvent(QResizeEvent *event);
+    virtual void hideEvent(QHideEvent *event);
 
 
 private:
@@ -147,21 +195,37 @@ private:
     void _paintErrorplot(const QTransform& T,
                          QPainter& painter, const QPen &pen,
                          const QModelIndex &plotIdx);
+    void _paintBaselineErrorplot(const QTransform& T,
+                                 QPainter& painter, const QPen &pen,
+                                 const QModelIndex &plotIdx,
+                                 const QString& presentation);
     void _paintCurve(const QModelIndex& curveIdx,
                      const QTransform &T, QPainter& painter,
                      bool isHighlight);
+    bool _curveDrawItem(const QModelIndex& curveIdx,
+                        const QTransform &T, bool isHighlight,
+                        CurveDrawItem* item);
+    static void _drawCurve(const CurveDrawItem& item, QPainter& painter);
     void _paintMarkers(QPainter& painter);
 
     QModelIndex _chooseCurveNearMousePoint(const QPoint& pt);
     bool _isErrorCurveNearMousePoint(const QPoint& pt);
 
-    QPixmap* _pixmap;
+    // Curves are rendered into _pixmap off the gui thread.  Until a new
+    // render is done, the last one is drawn moved to the current transform.
+    QPixmap _pixmap;
+    QTransform _pixmapT;
+    bool _isPixmapDirty;
+    QSharedPointer<QAtomicInt> _renderID;
+    QFutureWatcher<PlotImage> _renderWatcher;
     QRectF _lastM;
-    QPixmap* _createLivePixmap();
+    void _invalidatePixmap();
+    void _startRender();
+    static PlotImage _renderPlot(const PlotRenderJob& job);
 
     QString _format(double d);
 
-    int _idxAtTimeBinarySearch(QPainterPath* path,
+    int _idxAtTimeBinarySearch(CurvePath* path,
                                int low, int high, double time);
 
     // Key Events
@@ -178,6 +242,8 @@ protected slots:
                              const QModelIndex &bottomRight);
     virtual void rowsInserted(const QModelIndex &pidx, int start, int end);
 
+private slots:
+    void _renderFinished();
 
 };
 
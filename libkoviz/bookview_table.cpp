@@ -5,11 +5,19 @@ BookTableView::BookTableView(QWidget *parent) :
     _mTop(3),
     _mBot(3),
     _mLft(3),
-    _mRgt(3)
+    _mRgt(3),
+    _cacheBeg(0),
+    _cacheEnd(0),
+    _cacheTopRow(0)
 {
     setFrameShape(QFrame::Box);
 }
 
+BookTableView::~BookTableView()
+{
+    _unmapModels();
+}
+
 void BookTableView::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
@@ -104,39 +112,19 @@ void BookTableView::paintEvent(QPaintEvent *event)
         q = labels.size()-nCols;
     }
 
-    // Make list of values (per column)
-    QHash<int,QStringList> col2svals;
+    // Fetch values of visible columns (if not cached)
+    _moveCacheWindow(p,nRows-1);
     for (int j = 0; j < nCols; ++j) {
-        double sf   = scaleFactors.at(q+j);
-        double bias = biases.at(q+j);
-        CurveModel* curveModel = curveModels.at(q+j);
-        curveModel->map();
-        ModelIterator* it = curveModel->begin();
-        QList<double> vals;
-        for ( int i = 1; i < nRows; ++i ) {
-            double t = _timeStamps.at(p+i-1);
-            if ( j == 0 ) {
-                vals << t*sf + bias;
-            } else {
-                int k = curveModel->indexAtTime(t);
-                if ( it->at(k)->t() == t ) {
-                    vals << it->at(k)->y()*sf + bias;
-                } else {
-                    vals << 0; // place holder for blank data
-                }
-            }
+        if ( _cache.at(q+j).vals.isEmpty() ) {
+            _cacheColumn(q+j,curveModels.at(q+j),
+                         scaleFactors.at(q+j),biases.at(q+j));
         }
-        QStringList svals = _format(vals);
-        col2svals.insert(j,svals);
-        delete it;
-        curveModel->unmap();
     }
 
-    // Draw the table
+    // Draw the table, precision is picked over the visible rows
     for (int j = 0; j < nCols; ++j) {
-        CurveModel* curveModel = curveModels.at(q+j);
-        curveModel->map();
-        ModelIterator* it = curveModel->begin();
+        const CachedColumn& column = _cache.at(q+j);
+        QStringList svals = _format(column.vals.mid(p-_cacheBeg,nRows-1));
         for ( int i = 0; i < nRows; ++i ) {
             int hline = h*(i+1);
             int baseline = hline - _mBot - fm.descent();
@@ -149,16 +137,9 @@ void BookTableView::paintEvent(QPaintEvent *event)
                 int l = fm.width(labels.at(q+j));
                 painter.drawText(w*j+(w-l),baseline,s);
             } else {
-                if ( j == 0 ) {
-                    s = col2svals.value(j).at(i-1);
-                } else {
-                    double t = _timeStamps.at(p+i-1);
-                    int k = curveModel->indexAtTime(t);
-                    if ( it->at(k)->t() == t ) {
-                        s = col2svals.value(j).at(i-1);
-                    } else {
-                        // s is an empty string since no corresponding time
-                    }
+                // s is an empty string if no corresponding time
+                if ( !column.isBlank.at(p+i-1-_cacheBeg) ) {
+                    s = svals.at(i-1);
                 }
                 int l = fm.width(s);
                 painter.drawText(w*j+(w-l),baseline,s);
@@ -167,8 +148,6 @@ void BookTableView::paintEvent(QPaintEvent *event)
         int vline = w*(j+1);
         painter.setPen(penLight);
         painter.drawLine(vline,0,vline,W.height());
-        delete it;
-        curveModel->unmap();
     }
 
     painter.setPen(penOrig);
@@ -176,6 +155,140 @@ void BookTableView::paintEvent(QPaintEvent *event)
     painter.end();
 }
 
+void BookTableView::_clearCache()
+{
+    _cacheBeg = 0;
+    _cacheEnd = 0;
+    _cache.clear();
+}
+
+// Moves the cache window to hold rows [topRow,topRow+nRows) if it doesn't.
+// The new window reaches a couple of pages past them in the scroll
+// direction so that the next scrolls mostly draw cached values.
+void BookTableView::_moveCacheWindow(int topRow, int nRows)
+{
+    int nCols = _columnLabels().size();
+    if ( _cache.size() != nCols ) {
+        _clearCache();
+        _cache.resize(nCols);
+    }
+
+    if ( nRows <= 0 ||
+         (topRow >= _cacheBeg && topRow+nRows <= _cacheEnd) ) {
+        _cacheTopRow = topRow;
+        return;
+    }
+
+    int beg;
+    int end;
+    if ( topRow >= _cacheTopRow ) {
+        beg = topRow-nRows;
+        end = topRow+3*nRows;
+    } else {
+        beg = topRow-2*nRows;
+        end = topRow+2*nRows;
+    }
+    _cacheBeg = qMax(0,beg);
+    _cacheEnd = qMin(_timeStamps.size(),end);
+    _cacheTopRow = topRow;
+
+    _cache.clear();
+    _cache.resize(nCols);
+}
+
+// Caches column values for the rows in the cache window.  Rows are
+// matched to samples with a forward walk over one batch fetch of the
+// samples in the window instead of a time search per row.
+void BookTableView::_cacheColumn(int col, CurveModel *curveModel,
+                                 double scaleFactor, double bias)
+{
+    int nRows = _cacheEnd-_cacheBeg;
+    if ( nRows <= 0 ) {
+        return;
+    }
+
+    CachedColumn column;
+    QList<double>& vals = column.vals;
+    QVector<bool>& isBlank = column.isBlank;
+    isBlank.fill(false,nRows);
+    if ( col == 0 ) {
+        for ( int i = _cacheBeg; i < _cacheEnd; ++i ) {
+            vals << _timeStamps.at(i)*scaleFactor + bias;
+        }
+    } else {
+        // Samples from the last one at or before the first row time
+        // to the last one at or before the last row time
+        double tBeg = _timeStamps.at(_cacheBeg);
+        double tEnd = _timeStamps.at(_cacheEnd-1);
+        int kBeg = curveModel->indexAtTime(tBeg);
+        int kEnd = curveModel->indexAtTime(tEnd)+1;
+        int cnt = qMax(0,kEnd-kBeg);
+        QVector<double> t(cnt);
+        QVector<double> y(cnt);
+        cnt = curveModel->fetch(kBeg,cnt,t.data(),0,y.data());
+
+        int k = 0;
+        for ( int i = 0; i < nRows; ++i ) {
+            double time = _timeStamps.at(_cacheBeg+i);
+            while ( k+1 < cnt && t.at(k+1) <= time ) {
+                ++k;
+            }
+            if ( k < cnt && t.at(k) == time ) {
+                vals << y.at(k)*scaleFactor + bias;
+            } else {
+                vals << 0; // place holder for blank data
+                isBlank[i] = true;
+            }
+        }
+    }
+
+    _cache[col] = column;
+}
+
+void BookTableView::_mapModels()
+{
+    _unmapModels();
+
+    QModelIndex tableVarsIdx = _bookModel()->getIndex(rootIndex(),
+                                                      "TableVars","Table");
+    QModelIndexList tableVarIdxs = _bookModel()->getIndexList(tableVarsIdx,
+                                                        "TableVar","TableVars");
+    foreach (QModelIndex tableVarIdx, tableVarIdxs) {
+        QModelIndex curveIdx = _bookModel()->getDataIndex(tableVarIdx,
+                                                     "TableVarData","TableVar");
+        QVariant v = _bookModel()->data(curveIdx);
+        CurveModel* curveModel = QVariantToPtr<CurveModel>::convert(v);
+        if ( curveModel ) {
+            DataModel* dataModel = curveModel->dataModel();
+            dataModel->map();
+            _mappedModels << dataModel;
+        }
+    }
+}
+
+// Data models belong to the runs and outlive the table's curve models
+void BookTableView::_unmapModels()
+{
+    foreach ( DataModel* dataModel, _mappedModels ) {
+        dataModel->unmap();
+    }
+    _mappedModels.clear();
+}
+
+void BookTableView::showEvent(QShowEvent *event)
+{
+    if ( model() ) {
+        _mapModels();
+    }
+    QAbstractItemView::showEvent(event);
+}
+
+void BookTableView::hideEvent(QHideEvent *event)
+{
+    _unmapModels();
+    QAbstractItemView::hideEvent(event);
+}
+
 QStringList BookTableView::_format(const QList<double> &vals)
 {
     QStringList list;
@@ -350,40 +463,17 @@ void BookTableView::dataChanged(const QModelIndex &topLeft,
             double stopTime = _bookModel()->getDataDouble(QModelIndex(),
                                                           "StopTime");
 
-            curveModel->map();
-            ModelIterator* it = curveModel->begin();
-
-            int i = 0;
-            while ( !it->isDone() ) {
-
-                double t = it->t();
-
-                if ( t < startTime ) {
-                    it->next();
-                    continue;
-                }
-                if ( t > stopTime ) {
-                    break;
-                }
-                if ( i >= _timeStamps.size() ) {
-                    _timeStamps.append(t);
-                    it->next();
-                    ++i;
-                    continue;
-                }
-
-                double timeStamp = _timeStamps.at(i);
-                if ( t == timeStamp ) {
-                    it->next();
-                } else if ( t < timeStamp ) {
-                    _timeStamps.insert(i,t);
-                    it->next();
-                }
-                ++i;
-            }
+            // Merge curve times into time stamps
+            TimeStamps timeStamps;
+            timeStamps.addTimes(_timeStamps);
+            timeStamps.addColumn(curveModel->dataModel(),
+                                 curveModel->tColumn(),startTime,stopTime);
+            _timeStamps = timeStamps.merge();
+        }
 
-            delete it;
-            curveModel->unmap();
+        _clearCache();
+        if ( isVisible() ) {
+            _mapModels();
         }
 
         // Based on number of _timeStamps, set vertical scrollbar range
@@ -394,6 +484,11 @@ void BookTableView::dataChanged(const QModelIndex &topLeft,
         int nCols = _columnLabels().size();
         horizontalScrollBar()->setRange(0,nCols);
 
+    } else if ( tag == "TableVarUnit" || tag == "TableVarScale" ||
+                tag == "TableVarBias" ) {
+
+        _clearCache();
+
     } else if ( tag == "LiveCoordTime" ) {
 
         double liveTime = _bookModel()->getDataDouble(QModelIndex(),
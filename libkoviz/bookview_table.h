@@ -15,6 +15,9 @@
 #include <QString>
 #include <QStringList>
 #include <QKeyEvent>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QVector>
 #include <limits.h>
 
 #include <QtGlobal>
@@ -34,6 +37,7 @@ class BookTableView : public QAbstractItemView
     Q_OBJECT
 public:
     explicit BookTableView(QWidget *parent = 0);
+    ~BookTableView();
 
 public:
     virtual QModelIndex indexAt( const QPoint& point) const;
@@ -45,6 +49,8 @@ protected:
     virtual void paintEvent(QPaintEvent * event);
     virtual QSize minimumSizeHint() const;
     virtual QSize sizeHint() const;
+    virtual void showEvent(QShowEvent* event);
+    virtual void hideEvent(QHideEvent* event);
 
 protected:
     virtual QModelIndex moveCursor(CursorAction cursorAction,
@@ -67,7 +73,7 @@ protected slots:
 
 private:
     PlotBookModel* _bookModel() const;
-    QList<double> _timeStamps;
+    QVector<double> _timeStamps;
     int _mTop;
     int _mBot;
     int _mLft;
@@ -75,6 +81,30 @@ private:
 
     QStringList _columnLabels() const;
 
+    // Data models of the table vars are kept mapped while the table is shown
+    QList<DataModel*> _mappedModels;
+    void _mapModels();
+    void _unmapModels();
+
+    // Values of a window of rows [_cacheBeg,_cacheEnd) per column.
+    // A column is fetched the first time it is drawn in the window.
+    // When a row outside of the window is drawn, the window is moved
+    // (while painting) to reach past the rows drawn in the scroll
+    // direction.  Values are formatted as they are drawn.
+    struct CachedColumn
+    {
+        QList<double> vals;      // 0 for rows without a sample at the time
+        QVector<bool> isBlank;
+    };
+    int _cacheBeg;
+    int _cacheEnd;
+    int _cacheTopRow;  // top row last drawn
+    QVector<CachedColumn> _cache;
+    void _clearCache();
+    void _moveCacheWindow(int topRow, int nRows);
+    void _cacheColumn(int col, CurveModel* curveModel,
+                      double scaleFactor, double bias);
+
     QStringList _format(const QList<double>& vals);
     QStringList __format(const QList<double>& vals, const QString &format);
 
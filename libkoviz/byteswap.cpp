@@ -0,0 +1,64 @@
+#include "byteswap.h"
+
+// The kernel is built with target("ssse3").  Before gcc 4.9 (e.g. the
+// stock gcc 4.8 on CentOS 7) the intrinsic headers refuse to compile
+// without -mssse3, so there the kernel is left out unless the whole build
+// already has SSSE3.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#if defined(__SSSE3__) || defined(__clang__) || \
+    __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define BYTESWAP_HAS_SSSE3_KERNEL
+#include <tmmintrin.h>
+#endif
+#endif
+
+#ifdef BYTESWAP_HAS_SSSE3_KERNEL
+
+// Only this function is compiled for SSSE3, it is called only if the cpu
+// has it (so the binary runs on x86_64 cpus without SSSE3)
+__attribute__((target("ssse3")))
+static int _swapBlockSsse3(void* data, int size, int n)
+{
+    __m128i mask;
+    if ( size == 2 ) {
+        mask = _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+    } else if ( size == 4 ) {
+        mask = _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    } else {
+        mask = _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8);
+    }
+
+    char* p = (char*)data;
+    const int perVec = 16/size;
+    int i = 0;
+    for ( ; i+perVec <= n; i += perVec ) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p+i*size));
+        v = _mm_shuffle_epi8(v,mask);
+        _mm_storeu_si128((__m128i*)(p+i*size),v);
+    }
+
+    return i;
+}
+
+static bool _isSsse3()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+}
+
+#endif
+
+int ByteSwap::_swapBlockSimd(void *data, int size, int n)
+{
+#ifdef BYTESWAP_HAS_SSSE3_KERNEL
+    static const bool isSsse3 = _isSsse3();
+    if ( isSsse3 && (size == 2 || size == 4 || size == 8) ) {
+        return _swapBlockSsse3(data,size,n);
+    }
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    Q_UNUSED(n);
+#endif
+    return 0;
+}
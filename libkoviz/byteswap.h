@@ -0,0 +1,66 @@
+#ifndef BYTESWAP_H
+#define BYTESWAP_H
+
+#include <QtEndian>
+#include <string.h>
+
+//
+// Bulk byte order reversal (e.g. big endian trk data on a little endian
+// host).  On x86 cpus with SSSE3 (checked at run time) a 16 byte block is
+// swapped with one byte shuffle, see byteswap.cpp.  Only that kernel is
+// built for SSSE3, the rest of koviz runs on any x86_64.
+//
+class ByteSwap
+{
+  public:
+
+    // Reverses byte order of n values of size bytes (1,2,4 or 8) in place
+    static inline void swapBlock(void* data, int size, int n)
+    {
+        char* p = (char*)data;
+        int i = 0;
+
+        if ( size > 1 && n*size >= 16 ) {
+            i = _swapBlockSimd(data,size,n);
+        }
+
+        switch (size) {
+        case 2:
+            for ( ; i < n; ++i ) {
+                quint16 v;
+                memcpy(&v,p+i*2,2);
+                v = qbswap(v);
+                memcpy(p+i*2,&v,2);
+            }
+            break;
+        case 4:
+            for ( ; i < n; ++i ) {
+                quint32 v;
+                memcpy(&v,p+i*4,4);
+                v = qbswap(v);
+                memcpy(p+i*4,&v,4);
+            }
+            break;
+        case 8:
+            for ( ; i < n; ++i ) {
+                quint64 v;
+                memcpy(&v,p+i*8,8);
+                v = qbswap(v);
+                memcpy(p+i*8,&v,8);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+  private:
+
+    ByteSwap() {}
+
+    // Swaps whole 16 byte blocks of the n values, returns number of
+    // values swapped (0 without SSSE3)
+    static int _swapBlockSimd(void* data, int size, int n);
+};
+
+#endif // BYTESWAP_H
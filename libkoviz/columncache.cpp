@@ -0,0 +1,95 @@
+#include "columncache.h"
+
+ColumnCache::ColumnCache() :
+    _budget(1024LL*1024LL*1024LL),
+    _size(0)
+{
+}
+
+ColumnCache* ColumnCache::instance()
+{
+    static ColumnCache cache;
+    return &cache;
+}
+
+void ColumnCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&_mutex);
+    _budget = ( bytes > 0 ) ? bytes : 0;
+    _evict(0);
+}
+
+qint64 ColumnCache::budget() const
+{
+    QMutexLocker locker(&_mutex);
+    return _budget;
+}
+
+bool ColumnCache::find(const void *owner, int col, QVector<double> *column)
+{
+    QMutexLocker locker(&_mutex);
+
+    Key key(owner,col);
+    QHash<Key,Entry>::iterator it = _columns.find(key);
+    if ( it == _columns.end() ) {
+        return false;
+    }
+    *column = it.value().column;
+    _lru.splice(_lru.end(),_lru,it.value().lruPos);
+
+    return true;
+}
+
+bool ColumnCache::insert(const void *owner, int col,
+                         const QVector<double> &column)
+{
+    QMutexLocker locker(&_mutex);
+
+    qint64 nbytes = _bytes(column);
+    if ( nbytes > _budget ) {
+        return false;
+    }
+
+    Key key(owner,col);
+    if ( _columns.contains(key) ) {
+        // Another thread beat us to it
+        return true;
+    }
+
+    _evict(nbytes);
+    Entry entry;
+    entry.column = column;
+    entry.lruPos = _lru.insert(_lru.end(),key);
+    _columns.insert(key,entry);
+    _size += nbytes;
+
+    return true;
+}
+
+void ColumnCache::remove(const void *owner)
+{
+    QMutexLocker locker(&_mutex);
+
+    std::list<Key>::iterator it = _lru.begin();
+    while ( it != _lru.end() ) {
+        if ( it->first == owner ) {
+            _size -= _bytes(_columns.value(*it).column);
+            _columns.remove(*it);
+            it = _lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Evict least recently used columns until nbytes more fit in budget
+// Caller must hold _mutex
+void ColumnCache::_evict(qint64 nbytes)
+{
+    while ( !_lru.empty() && _size+nbytes > _budget ) {
+        Key key = _lru.front();
+        _lru.pop_front();
+        _size -= _bytes(_columns.value(key).column);
+        _columns.remove(key);
+    }
+}
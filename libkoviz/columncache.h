@@ -0,0 +1,64 @@
+#ifndef COLUMNCACHE_H
+#define COLUMNCACHE_H
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <list>
+
+//
+// Process wide LRU cache of decoded (column-major) model columns.
+//
+// Columns are keyed by owner (e.g. a TrickModel) and column number.
+// Columns are QVectors, so a column handed out stays valid (implicitly
+// shared) even if it is later evicted.  The cache is thread safe.
+//
+class ColumnCache
+{
+  public:
+
+    static ColumnCache* instance();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    // Returns true if cached (column set and marked most recently used)
+    bool find(const void* owner, int col, QVector<double>* column);
+
+    // Returns false if column is bigger than budget (nothing cached)
+    bool insert(const void* owner, int col, const QVector<double>& column);
+
+    // Drop all columns of owner
+    void remove(const void* owner);
+
+  private:
+
+    ColumnCache();
+
+    typedef QPair<const void*,int> Key;
+
+    mutable QMutex _mutex;
+    qint64 _budget;
+    qint64 _size;
+    // A touch moves the column's node to the back of the lru list (an O(1)
+    // splice through the iterator kept with the column)
+    struct Entry
+    {
+        QVector<double> column;
+        std::list<Key>::iterator lruPos;
+    };
+
+    QHash<Key,Entry> _columns;
+    std::list<Key> _lru;  // least recently used first
+
+    void _evict(qint64 nbytes);
+
+    static qint64 _bytes(const QVector<double>& column)
+    {
+        return (qint64)column.size()*(qint64)sizeof(double);
+    }
+};
+
+#endif // COLUMNCACHE_H
@@ -0,0 +1,538 @@
+#include "csvtotrk.h"
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+CsvTokenizer::CsvTokenizer(QFile *file) :
+    _file(file),
+    _pos(0),
+    _end(0),
+    _bytesRead(0),
+    _line(1),
+    _recordLine(1),
+    _isError(false),
+    _recordSize(0)
+{
+    _buf.resize(1<<20);
+    _record.resize(1024);
+}
+
+void CsvTokenizer::rewind()
+{
+    _file->seek(0);
+    _pos = 0;
+    _end = 0;
+    _bytesRead = 0;
+    _line = 1;
+    _recordLine = 1;
+    _isError = false;
+}
+
+bool CsvTokenizer::_fill()
+{
+    qint64 n = _file->read(_buf.data(),_buf.size());
+    if ( n <= 0 ) {
+        _pos = 0;
+        _end = 0;
+        return false;
+    }
+    _pos = 0;
+    _end = (int)n;
+    _bytesRead += n;
+    return true;
+}
+
+inline void CsvTokenizer::_append(char c)
+{
+    if ( _recordSize == _record.size() ) {
+        _record.resize(2*_record.size());
+    }
+    _record.data()[_recordSize++] = c;
+}
+
+void CsvTokenizer::_endField()
+{
+    _fieldEnds.append(_recordSize);
+    _append('\0');
+    _fieldBegs.append(_recordSize);
+}
+
+bool CsvTokenizer::readRecord()
+{
+    while ( 1 ) {
+
+        _recordSize = 0;
+        _fieldBegs.clear();
+        _fieldEnds.clear();
+        _fieldBegs.append(0);
+        _recordLine = _line;
+
+        State state = FieldStart;
+        bool isEndRecord = false;
+        bool isEof = false;
+        while ( !isEndRecord ) {
+            if ( _pos == _end && !_fill() ) {
+                isEof = true;
+                break;
+            }
+            char c = _buf.constData()[_pos++];
+            switch ( state ) {
+            case FieldStart:
+            case Unquoted:
+            case QuotedQuote:
+                if ( c == ',' ) {
+                    _endField();
+                    state = FieldStart;
+                } else if ( c == '\n' ) {
+                    ++_line;
+                    isEndRecord = true;
+                } else if ( c == '\r' ) {
+                    // Part of \r\n
+                } else if ( c == '"' && state == FieldStart ) {
+                    state = Quoted;
+                } else if ( c == '"' && state == QuotedQuote ) {
+                    _append('"');
+                    state = Quoted;
+                } else {
+                    _append(c);
+                    state = Unquoted;
+                }
+                break;
+            case Quoted:
+                if ( c == '"' ) {
+                    state = QuotedQuote;
+                } else {
+                    if ( c == '\n' ) {
+                        ++_line;
+                    }
+                    _append(c);
+                }
+                break;
+            }
+        }
+
+        if ( isEof && state == Quoted ) {
+            fprintf(stderr,"koviz [error]: Unterminated quoted field "
+                           "starting on line %d in file %s\n",
+                    _recordLine, _file->fileName().toLatin1().constData());
+            _fieldBegs.clear();
+            _fieldEnds.clear();
+            _isError = true;
+            return false;
+        }
+
+        if ( isEof && _recordSize == 0 && _fieldBegs.size() == 1 &&
+             state == FieldStart ) {
+            _fieldBegs.clear();
+            return false;
+        }
+
+        // Last field of record
+        _fieldEnds.append(_recordSize);
+        _append('\0');
+
+        if ( _fieldBegs.size() == 1 && _fieldEnds.at(0) == 0 ) {
+            // Blank line
+            if ( isEof ) {
+                _fieldBegs.clear();
+                _fieldEnds.clear();
+                return false;
+            }
+            continue;
+        }
+
+        return true;
+    }
+}
+
+CsvToTrk::CsvToTrk(const QString &csvFileName, const QString &trkFileName) :
+    _csvFileName(csvFileName),
+    _trkFileName(trkFileName),
+    _nRows(0)
+{
+}
+
+bool CsvToTrk::convert()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(_csvFileName);
+    if (!file.open(QIODevice::ReadOnly)){
+        fprintf(stderr, "koviz [error]: Cannot read file %s!\n",
+                _csvFileName.toLatin1().constData());
+        return false;
+    }
+    CsvTokenizer tokenizer(&file);
+
+    if ( !_readParams(tokenizer) || !_sampleTypes(tokenizer) ) {
+        return false;
+    }
+
+    QFileInfo ftrki(_trkFileName);
+    if ( ftrki.exists() ) {
+        fprintf(stderr, "koviz [error]: Will not overwrite %s\n",
+                _trkFileName.toLatin1().constData());
+        return false;
+    }
+
+    QFile trk(_trkFileName);
+    if (!trk.open(QIODevice::WriteOnly)) {
+        fprintf(stderr,"koviz [error]: could not open %s\n",
+                _trkFileName.toLatin1().constData());
+        return false;
+    }
+
+    WriteResult result = WriteRetry;
+    while ( result == WriteRetry ) {
+
+        // Write trk header with the current column types
+        trk.resize(0);
+        trk.seek(0);
+        for ( int i = 0; i < _params.size(); ++i ) {
+            if ( _isIntColumn.at(i) ) {
+                _params[i].setType(TRICK_07_INTEGER);
+                _params[i].setSize(sizeof(qint32));
+            } else {
+                _params[i].setType(TRICK_07_DOUBLE);
+                _params[i].setSize(sizeof(double));
+            }
+        }
+        QDataStream out(&trk);
+        TrickModel::writeTrkHeader(out,_params);
+
+        // Skip param list and stream records
+        tokenizer.rewind();
+        tokenizer.readRecord();
+        result = _writeRecords(tokenizer,&trk);
+    }
+
+    file.close();
+    if ( result == WriteError ) {
+        trk.remove();
+        return false;
+    }
+    trk.close();
+
+    double secs = qMax((qint64)1,(qint64)timer.elapsed())/1000.0;
+    double mb = tokenizer.bytesRead()/(1024.0*1024.0);
+    fprintf(stderr,"koviz [info]: converted %s to %s (%d rows, "
+                   "%.1f MB in %.1f sec, %.1f MB/s)\n",
+            _csvFileName.toLatin1().constData(),
+            _trkFileName.toLatin1().constData(),
+            _nRows, mb, secs, mb/secs);
+
+    return true;
+}
+
+bool CsvToTrk::_readParams(CsvTokenizer &tokenizer)
+{
+    if ( !tokenizer.readRecord() ) {
+        if ( !tokenizer.isError() ) {
+            fprintf(stderr, "koviz [error]: Empty csv file \"%s\"\n",
+                    _csvFileName.toLatin1().constData());
+        }
+        return false;
+    }
+
+    for ( int i = 0; i < tokenizer.fieldCount(); ++i ) {
+        QString s = QString::fromLatin1(tokenizer.field(i),
+                                        tokenizer.fieldSize(i));
+        TrickParameter p;
+        QStringList plist = s.split(" ", QString::SkipEmptyParts);
+        if ( plist.isEmpty() ) {
+            fprintf(stderr, "koviz [error]: Empty param name in column %d "
+                            "of file %s\n", i,
+                    _csvFileName.toLatin1().constData());
+            return false;
+        }
+        p.setName(plist.at(0));
+        if ( plist.size() > 1 ) {
+            QString unitString = plist.at(1);
+            if ( unitString.startsWith('{') ) {
+                unitString = unitString.remove(0,1);
+            }
+            if ( unitString.endsWith('}') ) {
+                unitString.chop(1);
+            }
+            Unit u;
+            if ( u.isUnit(unitString.toLatin1().constData()) ) {
+                p.setUnit(unitString);
+            }
+        }
+        _params.append(p);
+    }
+
+    return true;
+}
+
+// A column is an int column if the sampled rows of it are all ints.
+// Time (column 0) is always a double.
+bool CsvToTrk::_sampleTypes(CsvTokenizer &tokenizer)
+{
+    int nCols = _params.size();
+    _isIntColumn = QVector<bool>(nCols,true);
+    _isIntColumn[0] = false;
+
+    for ( int row = 0; row < SampleRows; ++row ) {
+        if ( !tokenizer.readRecord() ) {
+            if ( tokenizer.isError() ) {
+                return false;
+            }
+            break;
+        }
+        if ( !_isFieldCountOk(tokenizer) ) {
+            return false;
+        }
+        for ( int j = 1; j < nCols; ++j ) {
+            qint32 ival;
+            if ( _isIntColumn.at(j) &&
+                 !_toInt(tokenizer.field(j),tokenizer.fieldSize(j),&ival) ) {
+                _isIntColumn[j] = false;
+            }
+        }
+    }
+
+    return true;
+}
+
+CsvToTrk::WriteResult CsvToTrk::_writeRecords(CsvTokenizer &tokenizer,
+                                              QFile *trk)
+{
+    int nCols = _params.size();
+    QVector<int> offsets(nCols);
+    int recSize = 0;
+    for ( int j = 0; j < nCols; ++j ) {
+        offsets[j] = recSize;
+        recSize += _params.at(j).size();
+    }
+
+    QByteArray outBuf;
+    outBuf.resize(qMax((int)OutBufSize,recSize));
+    int outSize = 0;
+
+    _nRows = 0;
+    while ( tokenizer.readRecord() ) {
+
+        if ( !_isFieldCountOk(tokenizer) ) {
+            return WriteError;
+        }
+
+        if ( outSize+recSize > outBuf.size() ) {
+            if ( trk->write(outBuf.constData(),outSize) != outSize ) {
+                fprintf(stderr,"koviz [error]: could not write %s\n",
+                        _trkFileName.toLatin1().constData());
+                return WriteError;
+            }
+            outSize = 0;
+        }
+
+        uchar* rec = (uchar*)outBuf.data()+outSize;
+        for ( int j = 0; j < nCols; ++j ) {
+            const char* s = tokenizer.field(j);
+            int n = tokenizer.fieldSize(j);
+            uchar* dst = rec+offsets.at(j);
+            if ( _isIntColumn.at(j) ) {
+                qint32 ival;
+                if ( _toInt(s,n,&ival) ) {
+                    qToLittleEndian<qint32>(ival,dst);
+                    continue;
+                }
+                double val;
+                if ( _toNumber(s,n,&val) ) {
+                    // Not an int after all
+                    _isIntColumn[j] = false;
+                    if ( !_demoteIntColumns(tokenizer,j+1) ) {
+                        return WriteError;
+                    }
+                    return WriteRetry;
+                }
+                _badValue(tokenizer,j);
+                return WriteError;
+            } else {
+                double val;
+                if ( !_toNumber(s,n,&val) ) {
+                    _badValue(tokenizer,j);
+                    return WriteError;
+                }
+                quint64 bits;
+                memcpy(&bits,&val,sizeof(double));
+                qToLittleEndian<quint64>(bits,dst);
+            }
+        }
+        outSize += recSize;
+        ++_nRows;
+    }
+    if ( tokenizer.isError() ) {
+        return WriteError;
+    }
+
+    if ( trk->write(outBuf.constData(),outSize) != outSize ) {
+        fprintf(stderr,"koviz [error]: could not write %s\n",
+                _trkFileName.toLatin1().constData());
+        return WriteError;
+    }
+
+    return WriteOk;
+}
+
+// An int column didn't fit a row.  Instead of starting over for each
+// column that doesn't fit, the rest of the file is read (without output)
+// to find them all, so the conversion starts over once at most.  The
+// current record is checked from column col on.
+bool CsvToTrk::_demoteIntColumns(CsvTokenizer &tokenizer, int col)
+{
+    int nCols = _params.size();
+    do {
+        if ( !_isFieldCountOk(tokenizer) ) {
+            return false;
+        }
+        for ( int j = col; j < nCols; ++j ) {
+            if ( !_isIntColumn.at(j) ) {
+                continue;
+            }
+            const char* s = tokenizer.field(j);
+            int n = tokenizer.fieldSize(j);
+            qint32 ival;
+            double val;
+            if ( _toInt(s,n,&ival) ) {
+                continue;
+            } else if ( _toNumber(s,n,&val) ) {
+                _isIntColumn[j] = false;
+            } else {
+                _badValue(tokenizer,j);
+                return false;
+            }
+        }
+        col = 1;
+    } while ( tokenizer.readRecord() );
+
+    return !tokenizer.isError();
+}
+
+bool CsvToTrk::_isFieldCountOk(const CsvTokenizer &tokenizer) const
+{
+    if ( tokenizer.fieldCount() != _params.size() ) {
+        QFileInfo fi(_csvFileName);
+        fprintf(stderr,
+                "koviz [error]: Line %d in file %s has %d values "
+                "but there are %d params\n",
+                tokenizer.lineNumber(),
+                fi.absoluteFilePath().toLatin1().constData(),
+                tokenizer.fieldCount(), _params.size());
+        return false;
+    }
+    return true;
+}
+
+void CsvToTrk::_badValue(const CsvTokenizer &tokenizer, int col) const
+{
+    QFileInfo fi(_csvFileName);
+    fprintf(stderr,
+            "koviz [error]: Bad value \"%s\" on line %d in file %s\n",
+            tokenizer.field(col),
+            tokenizer.lineNumber(),
+            fi.absoluteFilePath().toLatin1().constData());
+}
+
+static inline bool _isSpace(char c)
+{
+    return ( c == ' ' || c == '\t' || c == '\r' || c == '\n' );
+}
+
+static inline void _trim(const char** s, int* n)
+{
+    while ( *n > 0 && _isSpace(**s) ) {
+        ++(*s);
+        --(*n);
+    }
+    while ( *n > 0 && _isSpace((*s)[*n-1]) ) {
+        --(*n);
+    }
+}
+
+bool CsvToTrk::_toInt(const char *s, int n, qint32 *v)
+{
+    _trim(&s,&n);
+    bool isNeg = false;
+    if ( n > 0 && (*s == '-' || *s == '+') ) {
+        isNeg = ( *s == '-' );
+        ++s;
+        --n;
+    }
+    if ( n <= 0 || n > 10 ) {
+        return false;
+    }
+    qint64 x = 0;
+    for ( int i = 0; i < n; ++i ) {
+        if ( s[i] < '0' || s[i] > '9' ) {
+            return false;
+        }
+        x = 10*x + (s[i]-'0');
+    }
+    if ( isNeg ) {
+        x = -x;
+    }
+    if ( x < -2147483647LL-1 || x > 2147483647LL ) {
+        return false;
+    }
+    *v = (qint32)x;
+    return true;
+}
+
+// Csv numbers always use a '.', strtod() uses the decimal point of the
+// C library locale (which the app sets from the environment)
+bool CsvToTrk::_toDouble(const char *s, int n, double *v)
+{
+    _trim(&s,&n);
+    if ( n <= 0 ) {
+        return false;
+    }
+
+    char local[64];
+    QByteArray big;
+    char* str = local;
+    if ( n >= (int)sizeof(local) ) {
+        big.resize(n+1);
+        str = big.data();
+    }
+    memcpy(str,s,n);
+    str[n] = '\0';
+
+    const char* dp = localeconv()->decimal_point;
+    if ( dp && dp[0] != '.' && dp[0] != '\0' ) {
+        for ( int i = 0; i < n; ++i ) {
+            if ( str[i] == '.' ) {
+                str[i] = dp[0];
+            }
+        }
+    }
+
+    char* end;
+    *v = strtod(str,&end);
+    return ( end == str+n );
+}
+
+// A number or a hh:mm:ss timestamp in seconds
+bool CsvToTrk::_toNumber(const char *s, int n, double *v)
+{
+    if ( _toDouble(s,n,v) ) {
+        return true;
+    }
+
+    const char* c1 = (const char*)memchr(s,':',n);
+    if ( !c1 ) {
+        return false;
+    }
+    const char* c2 = (const char*)memchr(c1+1,':',s+n-(c1+1));
+    if ( !c2 || memchr(c2+1,':',s+n-(c2+1)) ) {
+        return false;
+    }
+    double h, m, sec;
+    if ( !_toDouble(s,c1-s,&h) || !_toDouble(c1+1,c2-(c1+1),&m) ||
+         !_toDouble(c2+1,s+n-(c2+1),&sec) ) {
+        return false;
+    }
+    *v = 3600.0*h + 60.0*m + sec;
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef CSVTOTRK_H
+#define CSVTOTRK_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <stdio.h>
+#include "datamodel_trick.h"
+#include "unit.h"
+
+//
+// Reads csv records through a fixed size buffer
+//
+// A byte at a time state machine handles quoted fields (with "" for a
+// quote and embedded commas/newlines), \n and \r\n line ends and blank
+// lines.  The fields of the current record are kept null terminated in
+// a buffer that is reused for every record.  A quoted field still open
+// at the end of the file is an error (see isError()).
+//
+class CsvTokenizer
+{
+  public:
+    CsvTokenizer(QFile* file);
+
+    void rewind();
+    bool readRecord();   // false at end of file or on error
+    bool isError() const { return _isError; }
+
+    int fieldCount() const { return _fieldBegs.size(); }
+    const char* field(int i) const
+    {
+        return _record.constData()+_fieldBegs.at(i);
+    }
+    int fieldSize(int i) const { return _fieldEnds.at(i)-_fieldBegs.at(i); }
+    int lineNumber() const { return _recordLine; } // line record starts on
+    qint64 bytesRead() const { return _bytesRead; }
+
+  private:
+
+    enum State
+    {
+        FieldStart,
+        Unquoted,
+        Quoted,
+        QuotedQuote     // a quote in a quoted field, "" or end of quotes
+    };
+
+    QFile* _file;
+    QByteArray _buf;
+    int _pos;
+    int _end;
+    qint64 _bytesRead;
+    int _line;
+    int _recordLine;
+    bool _isError;
+
+    QByteArray _record;
+    int _recordSize;
+    QVector<int> _fieldBegs;
+    QVector<int> _fieldEnds;
+
+    bool _fill();
+    inline void _append(char c);
+    void _endField();
+};
+
+//
+// Streaming csv to trk conversion
+//
+// The first line of the csv is the param list e.g. "time {s},x {m}".
+// A first pass over a bounded sample of rows picks the trk type of each
+// column: a column of integers is written as a 4 byte int and anything
+// else as a double (time is always a double).  Then the Trick-07 header
+// is written and the rows are streamed from the tokenizer into fixed
+// size little endian records through a fixed size output buffer, so
+// memory doesn't grow with the file.  Should a row after the sample not
+// fit its column type (e.g. 2.5 in an int column) the rest of the file is
+// read without output to find every int column that doesn't fit, they
+// become doubles and the conversion starts over (once at most).
+//
+// Values are numbers (always with a '.') or hh:mm:ss timestamps.
+//
+class CsvToTrk
+{
+  public:
+    CsvToTrk(const QString& csvFileName, const QString& trkFileName);
+
+    bool convert();
+
+  private:
+
+    enum { SampleRows = 1000 };
+    enum { OutBufSize = 1<<20 };
+
+    enum WriteResult
+    {
+        WriteOk,
+        WriteRetry,     // a column changed type, start over
+        WriteError
+    };
+
+    QString _csvFileName;
+    QString _trkFileName;
+    QList<TrickParameter> _params;
+    QVector<bool> _isIntColumn;
+    int _nRows;
+
+    bool _readParams(CsvTokenizer& tokenizer);
+    bool _sampleTypes(CsvTokenizer& tokenizer);
+    WriteResult _writeRecords(CsvTokenizer& tokenizer, QFile* trk);
+    bool _demoteIntColumns(CsvTokenizer& tokenizer, int col);
+    bool _isFieldCountOk(const CsvTokenizer& tokenizer) const;
+    void _badValue(const CsvTokenizer& tokenizer, int col) const;
+
+    static bool _toInt(const char* s, int n, qint32* v);
+    static bool _toDouble(const char* s, int n, double* v);
+    static bool _toNumber(const char* s, int n, double* v);
+};
+
+#endif // CSVTOTRK_H
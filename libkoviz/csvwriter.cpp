@@ -0,0 +1,263 @@
+#include "csvwriter.h"
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A chunk of output rows and their text
+class CsvRowChunk
+{
+  public:
+    int beg;
+    int cnt;
+    QByteArray text;
+};
+
+// Fetches and formats a chunk (called on worker threads)
+class CsvRowChunkFormatter
+{
+  public:
+    typedef CsvRowChunk result_type;
+
+    CsvRowChunkFormatter(const CsvWriter* writer, int nRows) :
+        _writer(writer), _nRows(nRows) {}
+
+    CsvRowChunk operator()(const CsvRowChunk& chunkIn) const;
+
+  private:
+    const CsvWriter* _writer;
+    int _nRows;
+};
+
+CsvRowChunk CsvRowChunkFormatter::operator()(
+                                       const CsvRowChunk &chunkIn) const
+{
+    CsvRowChunk chunk = chunkIn;
+    int beg = chunk.beg;
+    int cnt = chunk.cnt;
+    int nCols = _writer->_gather.columnCount();
+
+    QVector<double> block(nCols*cnt);
+    _writer->_gather.gather(beg,cnt,block.data());
+
+    // Format rows
+    bool isShortest = ( _writer->_format == CsvWriter::ShortestFormat );
+    const QByteArray& rowEnd = _writer->_rowEnd;
+    chunk.text.reserve(cnt*(nCols*(isShortest ? 18 : 13)+rowEnd.size()));
+    char s[64];
+    for ( int i = 0; i < cnt; ++i ) {
+        for ( int j = 0; j < nCols; ++j ) {
+            double v = block.at(j*cnt+i);
+            int n = isShortest ? CsvWriter::formatShortest(v,s)
+                               : CsvWriter::formatWidth12(v,s);
+            chunk.text.append(s,n);
+            if ( j < nCols-1 ) {
+                chunk.text.append(',');
+            }
+        }
+        if ( beg+i < _nRows-1 || _writer->_isEndLastRow ) {
+            chunk.text.append(rowEnd);
+        }
+    }
+
+    return chunk;
+}
+
+CsvWriter::CsvWriter(NumberFormat format) :
+    _format(format),
+    _rowEnd("\n"),
+    _isEndLastRow(true)
+{
+}
+
+void CsvWriter::addColumn(DataModel *model, int col, const QVector<int> &rows)
+{
+    _gather.addColumn(model,col,rows);
+}
+
+void CsvWriter::addColumn(const QVector<double> &values)
+{
+    _gather.addColumn(values);
+}
+
+void CsvWriter::setRowEnd(const QByteArray &rowEnd, bool isEndLastRow)
+{
+    _rowEnd = rowEnd;
+    _isEndLastRow = isEndLastRow;
+}
+
+bool CsvWriter::write(QFile *file, const QByteArray &header, int nRows) const
+{
+    if ( file->write(header) != header.size() ) {
+        fprintf(stderr,"koviz [error]: could not write %s\n",
+                file->fileName().toLatin1().constData());
+        return false;
+    }
+
+    // Chunks of about 64K values, a batch of chunks per pass over the pool
+    int nCols = qMax(1,_gather.columnCount());
+    int rowsPerChunk = qBound(16,(1<<16)/nCols,4096);
+    int batchSize = 4*qMax(1,QThread::idealThreadCount());
+
+    CsvRowChunkFormatter formatter(this,nRows);
+    int beg = 0;
+    while ( beg < nRows ) {
+        QList<CsvRowChunk> chunks;
+        for ( int i = 0; i < batchSize && beg < nRows; ++i ) {
+            CsvRowChunk chunk;
+            chunk.beg = beg;
+            chunk.cnt = qMin(rowsPerChunk,nRows-beg);
+            chunks.append(chunk);
+            beg += chunk.cnt;
+        }
+        chunks = QtConcurrent::blockingMapped<QList<CsvRowChunk> >(
+                                                          chunks,formatter);
+        foreach ( const CsvRowChunk& chunk, chunks ) {
+            if ( file->write(chunk.text) != chunk.text.size() ) {
+                fprintf(stderr,"koviz [error]: could not write %s\n",
+                        file->fileName().toLatin1().constData());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// The app sets the C library locale from the environment,
+// csv numbers always use a '.'
+static void csvFixDecimalPoint(char* s, int n)
+{
+    const char* dp = localeconv()->decimal_point;
+    if ( !dp || dp[0] == '.' || dp[0] == '\0' ) {
+        return;
+    }
+    for ( int i = 0; i < n; ++i ) {
+        if ( s[i] == dp[0] ) {
+            s[i] = '.';
+        }
+    }
+}
+
+// Writes v the way QVariant(double).toString() does, which is
+// QString::number(v,'g',QLocale::FloatingPointShortest): the fewest
+// digits that read back as v, in exponent form (e.g. 1e+07) when the
+// exponent is below -4 or the exponent form is shorter.
+//
+// The digits are the first of %.15e, %.16e and %.17e that reads back as
+// v with trailing zeros dropped.  Whole numbers skip printf.
+int CsvWriter::formatShortest(double v, char *s)
+{
+    if ( v != v ) {
+        strcpy(s,"nan");
+        return 3;
+    }
+    if ( v == HUGE_VAL || v == -HUGE_VAL ) {
+        strcpy(s, (v < 0.0) ? "-inf" : "inf");
+        return (v < 0.0) ? 4 : 3;
+    }
+
+    int n = 0;
+    if ( v < 0.0 || (v == 0.0 && 1.0/v < 0.0) ) {
+        s[n++] = '-';
+    }
+
+    // Digits (no trailing zeros) and decimal point position of |v|
+    char digits[24];
+    int nDigits = 0;
+    int decpt = 1;
+    if ( v == 0.0 ) {
+        digits[nDigits++] = '0';
+    } else if ( v == floor(v) && fabs(v) < 1.0e15 ) {
+        long long x = (long long) v;
+        unsigned long long u = ( x < 0 ) ? -x : x;
+        char rdigits[24];
+        int nr = 0;
+        while ( u > 0 ) {
+            rdigits[nr++] = '0' + (char)(u%10);
+            u /= 10;
+        }
+        decpt = nr;
+        int lo = 0;
+        while ( lo < nr && rdigits[lo] == '0' ) {
+            ++lo;
+        }
+        while ( nr > lo ) {
+            digits[nDigits++] = rdigits[--nr];
+        }
+    } else {
+        char e[40];
+        for ( int precision = 15; precision <= 17; ++precision ) {
+            snprintf(e,sizeof(e),"%.*e",precision-1,fabs(v));
+            csvFixDecimalPoint(e,strlen(e));
+            if ( precision == 17 || strtod(e,0) == fabs(v) ) {
+                break;
+            }
+        }
+        const char* c = e;
+        for ( ; *c != 'e'; ++c ) {
+            if ( *c >= '0' && *c <= '9' ) {
+                digits[nDigits++] = *c;
+            }
+        }
+        decpt = atoi(c+1)+1;
+        while ( nDigits > 1 && digits[nDigits-1] == '0' ) {
+            --nDigits;
+        }
+    }
+
+    // Qt's choice of form (QLocaleData::doubleToString)
+    int cutoff = 6;
+    if ( decpt > 0 ) {
+        cutoff = nDigits + 4;
+        if ( decpt <= 10 ) {
+            ++cutoff;
+        } else {
+            cutoff += decpt > 100 ? 2 : 1;
+        }
+        if ( nDigits > decpt ) {
+            ++cutoff;
+        }
+    }
+
+    if ( decpt-1 < -4 || decpt-1 >= cutoff ) {
+        s[n++] = digits[0];
+        if ( nDigits > 1 ) {
+            s[n++] = '.';
+            memcpy(s+n,digits+1,nDigits-1);
+            n += nDigits-1;
+        }
+        int exp = decpt-1;
+        n += sprintf(s+n,"e%c%02d",(exp < 0) ? '-' : '+',abs(exp));
+    } else if ( decpt <= 0 ) {
+        s[n++] = '0';
+        s[n++] = '.';
+        for ( int i = decpt; i < 0; ++i ) {
+            s[n++] = '0';
+        }
+        memcpy(s+n,digits,nDigits);
+        n += nDigits;
+    } else {
+        for ( int i = 0; i < decpt || i < nDigits; ++i ) {
+            if ( i == decpt ) {
+                s[n++] = '.';
+            }
+            s[n++] = ( i < nDigits ) ? digits[i] : '0';
+        }
+    }
+    s[n] = '\0';
+
+    return n;
+}
+
+int CsvWriter::formatWidth12(double v, char *s)
+{
+    int n;
+    if ( v != v ) {
+        n = snprintf(s,32,"%12s","nan");
+    } else {
+        n = snprintf(s,32,"%12.8g",v);
+        csvFixDecimalPoint(s,n);
+    }
+    return n;
+}
@@ -0,0 +1,58 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <stdio.h>
+#include "datamodel.h"
+#include "rowgather.h"
+
+//
+// Parallel csv export
+//
+// Columns are added as model columns (optionally at a list of model rows
+// per output row e.g. the sample at or before each table time) or as a
+// list of values.  write() splits the output rows into chunks.  A batch
+// of chunks is gathered (see RowGather) and formatted on the thread pool,
+// then the chunk texts are written in order with one write per chunk.
+// Models must be mapped while writing.
+//
+class CsvWriter
+{
+  public:
+
+    enum NumberFormat
+    {
+        ShortestFormat,   // What QVariant(double).toString() writes
+        Width12Format     // %12.8g (what a 12 wide QTextStream writes)
+    };
+
+    CsvWriter(NumberFormat format);
+
+    void addColumn(DataModel* model, int col,
+                   const QVector<int>& rows=QVector<int>());
+    void addColumn(const QVector<double>& values);
+
+    // Text ending each row, the last row isn't ended if !isEndLastRow
+    void setRowEnd(const QByteArray& rowEnd, bool isEndLastRow);
+
+    bool write(QFile* file, const QByteArray& header, int nRows) const;
+
+    static int formatShortest(double v, char* s);
+    static int formatWidth12(double v, char* s);
+
+  private:
+
+    friend class CsvRowChunkFormatter;
+
+    NumberFormat _format;
+    QByteArray _rowEnd;
+    bool _isEndLastRow;
+    RowGather _gather;
+};
+
+#endif // CSVWRITER_H
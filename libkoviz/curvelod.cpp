@@ -0,0 +1,187 @@
+#include "curvelod.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Orders points by x for searching a curve with nondecreasing x
+struct CurveLODLessX
+{
+    bool operator()(const QPointF& p, double x) const { return p.x() < x; }
+    bool operator()(double x, const QPointF& p) const { return x < p.x(); }
+};
+
+CurveLOD::CurveLOD(const CurvePath &path) :
+    _isValid(false),
+    _points(path.allPoints())
+{
+    int n = _points.size();
+    const QPointF* p = _points.constData();
+    for ( int i = 1; i < n; ++i ) {
+        if ( !(p[i].x() >= p[i-1].x()) ) {
+            // Not monotone in x (or nan), can't bucket by pixel column
+            _points = QPolygonF();
+            return;
+        }
+    }
+
+    if ( n == 0 ) {
+        return;
+    }
+
+    _buildLevels();
+    _isValid = true;
+}
+
+void CurveLOD::_buildLevels()
+{
+    int n = _points.size();
+    const QPointF* p = _points.constData();
+
+    // Finest level from the points
+    int blockSize = BaseBlockSize;
+    int nblocks = (n+blockSize-1)/blockSize;
+    QVector<Extrema> level(nblocks);
+    for ( int b = 0; b < nblocks; ++b ) {
+        int beg = b*blockSize;
+        int end = qMin(n,beg+blockSize);
+        Extrema e;
+        e.iMin = beg;
+        e.iMax = beg;
+        for ( int i = beg+1; i < end; ++i ) {
+            if ( p[i].y() < p[e.iMin].y() ) e.iMin = i;
+            if ( p[i].y() > p[e.iMax].y() ) e.iMax = i;
+        }
+        level[b] = e;
+    }
+    _levels.append(level);
+    _blockSizes.append(blockSize);
+
+    // Coarser levels from the level below
+    while ( nblocks > MinLevelBlocks ) {
+        const QVector<Extrema>& prev = _levels.last();
+        blockSize *= LevelFactor;
+        nblocks = (nblocks+LevelFactor-1)/LevelFactor;
+        QVector<Extrema> next(nblocks);
+        for ( int b = 0; b < nblocks; ++b ) {
+            int beg = b*LevelFactor;
+            int end = qMin(prev.size(),beg+LevelFactor);
+            Extrema e = prev.at(beg);
+            for ( int j = beg+1; j < end; ++j ) {
+                const Extrema& q = prev.at(j);
+                if ( p[q.iMin].y() < p[e.iMin].y() ) e.iMin = q.iMin;
+                if ( p[q.iMax].y() > p[e.iMax].y() ) e.iMax = q.iMax;
+            }
+            next[b] = e;
+        }
+        _levels.append(next);
+        _blockSizes.append(blockSize);
+    }
+}
+
+QPolygonF CurveLOD::polyline(int beg, int end,
+                             double xmin, double xmax, int nPixels) const
+{
+    QPolygonF points;
+
+    int n = _points.size();
+    beg = qMax(0,beg);
+    end = qMin(n,end);
+    if ( !_isValid || beg >= end ) {
+        return points;
+    }
+
+    // Visible rows plus one on each side so the line runs off the edges
+    const QPointF* p = _points.constData();
+    int i0 = std::lower_bound(p+beg,p+end,xmin,CurveLODLessX()) - p;
+    int i1 = std::upper_bound(p+beg,p+end,xmax,CurveLODLessX()) - p;
+    i0 = qMax(beg,i0-1);
+    i1 = qMin(end-1,i1);
+    if ( i1 < i0 ) {
+        return points;
+    }
+    int nVisible = i1-i0+1;
+
+    double dx = (xmax-xmin)/nPixels;
+    if ( nPixels <= 0 || !(dx > 0.0) || nVisible <= 4*nPixels ) {
+        // Few enough points to draw them all
+        points.reserve(nVisible);
+        for ( int i = i0; i <= i1; ++i ) {
+            points.append(p[i]);
+        }
+        return points;
+    }
+
+    // Coarsest level with at least two blocks per pixel column,
+    // or the points themselves (level -1) if no level is fine enough
+    int level = -1;
+    for ( int k = 0; k < _blockSizes.size(); ++k ) {
+        if ( nVisible/_blockSizes.at(k) >= 2*nPixels ) {
+            level = k;
+        }
+    }
+    int blockSize = ( level < 0 ) ? 1 : _blockSizes.at(level);
+
+    // Bucket blocks into pixel columns keeping min/max of each column
+    points.reserve(2*nPixels+4);
+    int bBeg = i0/blockSize;
+    int bEnd = i1/blockSize;
+    bool isColumn = false;
+    int column = 0;
+    int cMin = 0;
+    int cMax = 0;
+    for ( int b = bBeg; b <= bEnd; ++b ) {
+        int bFirst = qMax(i0,b*blockSize);
+        int bLast = qMin(i1,(b+1)*blockSize-1);
+        int iMin = bFirst;
+        int iMax = bFirst;
+        if ( bFirst == b*blockSize && bLast == (b+1)*blockSize-1 ) {
+            if ( level >= 0 ) {
+                const Extrema& e = _levels.at(level).at(b);
+                iMin = e.iMin;
+                iMax = e.iMax;
+            }
+        } else {
+            // Block cut by the ends, its extrema may be outside them
+            for ( int i = bFirst+1; i <= bLast; ++i ) {
+                if ( p[i].y() < p[iMin].y() ) iMin = i;
+                if ( p[i].y() > p[iMax].y() ) iMax = i;
+            }
+        }
+
+        double c = floor((p[bFirst].x()-xmin)/dx);
+        if ( c < -1.0 ) {
+            c = -1.0;
+        } else if ( c > nPixels ) {
+            c = nPixels;
+        }
+
+        if ( !isColumn || (int)c != column ) {
+            if ( isColumn ) {
+                _appendColumn(points,cMin,cMax);
+            }
+            isColumn = true;
+            column = (int)c;
+            cMin = iMin;
+            cMax = iMax;
+        } else {
+            if ( p[iMin].y() < p[cMin].y() ) cMin = iMin;
+            if ( p[iMax].y() > p[cMax].y() ) cMax = iMax;
+        }
+    }
+    if ( isColumn ) {
+        _appendColumn(points,cMin,cMax);
+    }
+
+    return points;
+}
+
+// Min and max of a pixel column in the order they were logged
+void CurveLOD::_appendColumn(QPolygonF &points, int iMin, int iMax) const
+{
+    int a = qMin(iMin,iMax);
+    int b = qMax(iMin,iMax);
+    points.append(_points.at(a));
+    if ( b != a ) {
+        points.append(_points.at(b));
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef CURVELOD_H
+#define CURVELOD_H
+
+#include <QVector>
+#include <QList>
+#include <QPolygonF>
+#include "curvepath.h"
+
+//
+// Level of detail (min/max pyramid) for drawing big curves
+//
+// Level k splits the curve points into blocks of BaseBlockSize*LevelFactor^k
+// and keeps the index of the min and max y in each block.  polyline()
+// picks the coarsest level that still has a couple of blocks per pixel
+// column and emits the min and max of each pixel column in index order,
+// so the number of points drawn is bounded by the viewport width and
+// no spike is lost at any zoom.
+//
+// Only curves whose x is nondecreasing (e.g. x is time) can be bucketed
+// into pixel columns.  Others are not valid (see isValid()) and are
+// drawn from their path.
+//
+// The curve points are shared with the CurvePath (QPolygonF is
+// implicitly shared) so the pyramid costs about a byte a point.  It is
+// built over the whole path so it stays good when the time window moves.
+//
+class CurveLOD
+{
+  public:
+
+    CurveLOD(const CurvePath& path);
+
+    bool isValid() const { return _isValid; }
+    int pointCount() const { return _points.size(); }
+
+    // Points in [beg,end) covering [xmin,xmax] which is nPixels wide
+    // on screen (beg/end are the path's time window)
+    QPolygonF polyline(int beg, int end,
+                       double xmin, double xmax, int nPixels) const;
+
+    // Curves with fewer points are drawn from their path directly
+    enum { MinPoints = 16384 };
+
+  private:
+
+    enum { BaseBlockSize = 8, LevelFactor = 4, MinLevelBlocks = 64 };
+
+    struct Extrema
+    {
+        int iMin;
+        int iMax;
+    };
+
+    bool _isValid;
+    QPolygonF _points;
+    QList<QVector<Extrema> > _levels;
+    QList<int> _blockSizes;
+
+    void _buildLevels();
+    void _appendColumn(QPolygonF& points, int iMin, int iMax) const;
+};
+
+#endif // CURVELOD_H
@@ -3,6 +3,7 @@
 
 #include <QAbstractTableModel>
 #include <QString>
+#include <QVector>
 #include "parameter.h"
 #include "datamodel.h"
 #include "curvemodelparameter.h"
@@ -24,11 +25,23 @@ class CurveModel : public QAbstractTableModel
     CurveModelParameter* y() { return _y; }
 
     QString fileName() const { return _datamodel->fileName(); }
+    DataModel* dataModel() const { return _datamodel; }
+    int tColumn() const { return _tcol; }
+    int xColumn() const { return _xcol; }
+    int yColumn() const { return _ycol; }
 
     void map() { _datamodel->map(); }
     void unmap() { _datamodel->unmap(); }
     ModelIterator* begin() const { return _datamodel->begin(_tcol,_xcol,_ycol);}
     int indexAtTime(double time) { return _datamodel->indexAtTime(time); }
+    int indexAtTime(double time, int* cursor)
+    {
+        return _datamodel->indexAtTime(time,cursor);
+    }
+    int fetch(int beg, int cnt, double* t, double* x, double* y) const
+    {
+        return _datamodel->fetch(_tcol,_xcol,_ycol,beg,cnt,t,x,y);
+    }
 
     virtual int rowCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual int columnCount(const QModelIndex & pidx = QModelIndex() ) const;
@@ -47,4 +60,87 @@ class CurveModel : public QAbstractTableModel
 
 };
 
+//
+// Forward cursor over curve samples that fetches a block at a time.
+// Unlike ModelIterator there are no per-sample virtual calls, so use it
+// in hot loops that cannot be written as a plain block loop
+// e.g. merge joins of two curves.  Set isFetchX false to skip x.
+// If the model has the whole columns decoded (see DataModel::column())
+// they are held for the life of the cursor instead of fetched per block.
+//
+class CurveCursor
+{
+  public:
+
+    CurveCursor(const CurveModel* curve, bool isFetchX=true) :
+        _curve(curve),
+        _nrows(curve->rowCount()),
+        _beg(0), _cnt(0), _i(0)
+    {
+        const DataModel* model = curve->dataModel();
+        _tBlock = model->column(curve->tColumn());
+        _yBlock = model->column(curve->yColumn());
+        if ( isFetchX ) {
+            _xBlock = model->column(curve->xColumn());
+        }
+        if ( _tBlock.size() == _nrows && _yBlock.size() == _nrows &&
+             (!isFetchX || _xBlock.size() == _nrows) ) {
+            // Whole columns
+            _cnt = _nrows;
+            _t = _tBlock.constData();
+            _x = isFetchX ? _xBlock.constData() : 0;
+            _y = _yBlock.constData();
+            return;
+        }
+
+        _tBlock.resize(DataModel::FetchBlockSize);
+        _xBlock.resize(isFetchX ? (int)DataModel::FetchBlockSize : 0);
+        _yBlock.resize(DataModel::FetchBlockSize);
+        _fetch();
+    }
+
+    inline bool isDone() const { return _i >= _cnt; }
+
+    inline void next()
+    {
+        ++_i;
+        if ( _i >= _cnt && _beg+_cnt < _nrows ) {
+            _beg += _cnt;
+            _fetch();
+        }
+    }
+
+    inline int row() const { return _beg+_i; }
+    inline double t() const { return _t[_i]; }
+    inline double x() const { return _x[_i]; }
+    inline double y() const { return _y[_i]; }
+
+  private:
+
+    Q_DISABLE_COPY(CurveCursor)
+
+    const CurveModel* _curve;
+    int _nrows;
+    int _beg;
+    int _cnt;
+    int _i;
+    QVector<double> _tBlock;
+    QVector<double> _xBlock;
+    QVector<double> _yBlock;
+    const double* _t;
+    const double* _x;
+    const double* _y;
+
+    void _fetch()
+    {
+        double* x = _xBlock.isEmpty() ? 0 : _xBlock.data();
+        _cnt = _curve->fetch(_beg,DataModel::FetchBlockSize,
+                             _tBlock.data(),x,_yBlock.data());
+        _t = _tBlock.constData();
+        _x = x;
+        _y = _yBlock.constData();
+        _i = 0;
+    }
+};
+
 #endif // CURVE_MODEL_H
@@ -0,0 +1,563 @@
+#include "curvepath.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+// Orders points by x for searching a path with nondecreasing x
+struct CurvePathLessX
+{
+    bool operator()(const QPointF& p, double x) const { return p.x() < x; }
+    bool operator()(double x, const QPointF& p) const { return x < p.x(); }
+};
+
+CurvePath::CurvePath() :
+    _isWholeRun(true),
+    _isXSorted(true),
+    _beg(0), _end(0),
+    _xmin(0.0), _xmax(0.0), _ymin(0.0), _ymax(0.0),
+    _treeLeaf(0)
+{
+}
+
+void CurvePath::reserve(int n)
+{
+    _points.reserve(n);
+}
+
+void CurvePath::squeeze()
+{
+    _points.squeeze();
+    _rows.squeeze();
+}
+
+void CurvePath::append(double x, double y)
+{
+    if ( _points.isEmpty() ) {
+        _xmin = _xmax = x;
+        _ymin = _ymax = y;
+    } else {
+        if ( x < _xmin ) _xmin = x;
+        if ( x > _xmax ) _xmax = x;
+        if ( y < _ymin ) _ymin = y;
+        if ( y > _ymax ) _ymax = y;
+        if ( !(x >= _points.last().x()) ) _isXSorted = false;
+    }
+    _points.append(QPointF(x,y));
+    _beg = 0;
+    _end = _points.size();
+}
+
+void CurvePath::append(double x, double y, int row)
+{
+    int n = _points.size();
+    if ( _rows.isEmpty() && row != n ) {
+        // First skipped row, keep rows from here on
+        _rows.reserve(_points.capacity());
+        for ( int i = 0; i < n; ++i ) {
+            _rows.append(i);
+        }
+    }
+    if ( !_rows.isEmpty() || row != n ) {
+        _rows.append(row);
+    }
+    append(x,y);
+}
+
+void CurvePath::setWindow(int beg, int end)
+{
+    int n = _points.size();
+    _beg = qBound(0,beg,n);
+    _end = qBound(_beg,end,n);
+
+    if ( _tree.isEmpty() ) {
+        _buildBBoxTree();
+    }
+    _calcBBox();
+}
+
+// Rows are increasing along the path
+void CurvePath::setRowWindow(int rowBeg, int rowEnd)
+{
+    if ( _rows.isEmpty() ) {
+        setWindow(rowBeg,rowEnd);
+    } else {
+        const int* r = _rows.constData();
+        int n = _rows.size();
+        setWindow(std::lower_bound(r,r+n,rowBeg) - r,
+                  std::lower_bound(r,r+n,rowEnd) - r);
+    }
+}
+
+void CurvePath::setXWindow(double xmin, double xmax)
+{
+    const QPointF* p = _points.constData();
+    int n = _points.size();
+    setWindow(std::lower_bound(p,p+n,xmin,CurvePathLessX()) - p,
+              std::upper_bound(p,p+n,xmax,CurvePathLessX()) - p);
+}
+
+// Copy of the points in the window (shared if window is the whole path)
+QPolygonF CurvePath::points() const
+{
+    if ( _beg == 0 && _end == _points.size() ) {
+        return _points;
+    }
+    return _points.mid(_beg,_end-_beg);
+}
+
+QRectF CurvePath::boundingRect() const
+{
+    if ( isEmpty() ) {
+        return QRectF();
+    }
+    return QRectF(QPointF(_xmin,_ymin),QPointF(_xmax,_ymax));
+}
+
+bool CurvePath::intersects(const QRectF &R) const
+{
+    if ( isEmpty() ) {
+        return false;
+    }
+    QRectF N = R.normalized();
+    return ( _xmin <= N.right() && _xmax >= N.left() &&
+             _ymin <= N.bottom() && _ymax >= N.top() );
+}
+
+double CurvePath::distanceTo(const QPointF &pt, double radius,
+                             const QTransform &T) const
+{
+    if ( isEmpty() ) {
+        return -1.0;
+    }
+
+    bool isInvertible = false;
+    QTransform Tinv = T.inverted(&isInvertible);
+    if ( !isInvertible ) {
+        return -1.0;
+    }
+
+    // Pick square a pixel bigger so round off doesn't lose edge segments
+    double r = radius+1.0;
+    NearQuery q;
+    q.pt = pt;
+    q.M = Tinv.mapRect(QRectF(pt.x()-r,pt.y()-r,2.0*r,2.0*r));
+    q.T = T;
+    q.dMin = DBL_MAX;
+    q.iMin = -1;
+
+    if ( count() == 1 ) {
+        QPointF d = T.map(at(0))-pt;
+        q.dMin = sqrt(d.x()*d.x()+d.y()*d.y());
+    } else if ( _tree.isEmpty() ) {
+        _searchSegments(_beg,_end-1,&q);
+    } else {
+        _searchNode(1,0,_treeLeaf,&q);
+    }
+
+    return ( q.dMin <= radius ) ? q.dMin : -1.0;
+}
+
+// Node covers blocks [bLo,bHi).  Its box holds all its segments but the
+// last, which goes to the first point of the next node.  So if the box
+// misses the pick square, only that segment is checked.
+void CurvePath::_searchNode(int node, int bLo, int bHi, NearQuery *q) const
+{
+    int n = _points.size();
+    int p0 = bLo*BBoxBlockSize;
+    int p1 = qMin(n,bHi*BBoxBlockSize);
+    if ( p0 >= n || p0 >= _end-1 || p1 <= _beg ) {
+        return;
+    }
+
+    const Extents& e = _tree.at(node);
+    const QRectF& M = q->M;
+    if ( !(e.xmin <= M.right() && e.xmax >= M.left() &&
+           e.ymin <= M.bottom() && e.ymax >= M.top()) ) {
+        if ( p1 < n ) {
+            _searchSegments(p1-1,p1,q);
+        }
+    } else if ( node >= _treeLeaf ) {
+        _searchSegments(p0,p1,q);
+    } else {
+        int bMid = (bLo+bHi)/2;
+        _searchNode(2*node,bLo,bMid,q);
+        _searchNode(2*node+1,bMid,bHi,q);
+    }
+}
+
+// Segments (i,i+1) for i in [beg,end) that are in the window
+void CurvePath::_searchSegments(int beg, int end, NearQuery *q) const
+{
+    beg = qMax(beg,_beg);
+    end = qMin(end,_end-1);
+    const QPointF* p = _points.constData();
+    const QRectF& M = q->M;
+    for ( int i = beg; i < end; ++i ) {
+        const QPointF& a = p[i];
+        const QPointF& b = p[i+1];
+        if ( qMax(a.x(),b.x()) < M.left() || qMin(a.x(),b.x()) > M.right() ||
+             qMax(a.y(),b.y()) < M.top() || qMin(a.y(),b.y()) > M.bottom() ) {
+            continue;
+        }
+
+        // Distance in pixels from pt to segment ab
+        QPointF u = q->T.map(a);
+        QPointF v = q->T.map(b);
+        double dx = v.x()-u.x();
+        double dy = v.y()-u.y();
+        double wx = q->pt.x()-u.x();
+        double wy = q->pt.y()-u.y();
+        double ll = dx*dx+dy*dy;
+        double k = ( ll > 0.0 ) ? (wx*dx+wy*dy)/ll : 0.0;
+        if ( k < 0.0 ) {
+            k = 0.0;
+        } else if ( k > 1.0 ) {
+            k = 1.0;
+        }
+        double ex = wx-k*dx;
+        double ey = wy-k*dy;
+        double d = sqrt(ex*ex+ey*ey);
+        if ( d < q->dMin ) {
+            q->dMin = d;
+        }
+    }
+}
+
+int CurvePath::nearestPoint(const QPointF &pt, const QTransform &T) const
+{
+    if ( isEmpty() ) {
+        return -1;
+    }
+
+    NearQuery q;
+    q.pt = pt;
+    q.T = T;
+    q.dMin = DBL_MAX;
+    q.iMin = -1;
+
+    if ( _tree.isEmpty() ) {
+        _searchPoints(_beg,_end,&q);
+    } else {
+        _searchNearest(1,0,_treeLeaf,&q);
+    }
+
+    return ( q.iMin < 0 ) ? -1 : q.iMin-_beg;
+}
+
+// Branch and bound, the nearer child first.  A node whose box is
+// farther (in pixels) than the nearest point so far is skipped.
+void CurvePath::_searchNearest(int node, int bLo, int bHi, NearQuery *q) const
+{
+    int n = _points.size();
+    int p0 = bLo*BBoxBlockSize;
+    int p1 = qMin(n,bHi*BBoxBlockSize);
+    if ( p0 >= n || p0 >= _end || p1 <= _beg ) {
+        return;
+    }
+    if ( !(_pixelDistance(_tree.at(node),q) < q->dMin) ) {
+        return;
+    }
+
+    if ( node >= _treeLeaf ) {
+        _searchPoints(p0,p1,q);
+    } else {
+        int bMid = (bLo+bHi)/2;
+        double dl = _pixelDistance(_tree.at(2*node),q);
+        double dr = _pixelDistance(_tree.at(2*node+1),q);
+        if ( dl <= dr ) {
+            _searchNearest(2*node,bLo,bMid,q);
+            _searchNearest(2*node+1,bMid,bHi,q);
+        } else {
+            _searchNearest(2*node+1,bMid,bHi,q);
+            _searchNearest(2*node,bLo,bMid,q);
+        }
+    }
+}
+
+void CurvePath::_searchPoints(int beg, int end, NearQuery *q) const
+{
+    beg = qMax(beg,_beg);
+    end = qMin(end,_end);
+    const QPointF* p = _points.constData();
+    for ( int i = beg; i < end; ++i ) {
+        QPointF u = q->T.map(p[i]);
+        double dx = u.x()-q->pt.x();
+        double dy = u.y()-q->pt.y();
+        double d = sqrt(dx*dx+dy*dy);
+        if ( d < q->dMin ) {
+            q->dMin = d;
+            q->iMin = i;
+        }
+    }
+}
+
+// Pixel distance from the query point to a box (0 if inside it)
+double CurvePath::_pixelDistance(const Extents &e, const NearQuery *q) const
+{
+    if ( !(e.xmin <= e.xmax && e.ymin <= e.ymax) ) {
+        return DBL_MAX;  // no points
+    }
+    QRectF B = q->T.mapRect(QRectF(QPointF(e.xmin,e.ymin),
+                                   QPointF(e.xmax,e.ymax)));
+    double dx = qMax(0.0,qMax(B.left()-q->pt.x(),q->pt.x()-B.right()));
+    double dy = qMax(0.0,qMax(B.top()-q->pt.y(),q->pt.y()-B.bottom()));
+    return sqrt(dx*dx+dy*dy);
+}
+
+int CurvePath::lowerBoundX(double x) const
+{
+    const QPointF* p = _points.constData();
+    return std::lower_bound(p+_beg,p+_end,x,CurvePathLessX()) - (p+_beg);
+}
+
+int CurvePath::upperBoundX(double x) const
+{
+    const QPointF* p = _points.constData();
+    return std::upper_bound(p+_beg,p+_end,x,CurvePathLessX()) - (p+_beg);
+}
+
+int CurvePath::indexOfMinY(int beg, int end) const
+{
+    beg = qMax(0,beg);
+    end = qMin(count(),end);
+    if ( beg >= end ) {
+        return -1;
+    }
+    int i = _rangeExtents(_beg+beg,_beg+end).iymin;
+    return ( i < 0 ) ? -1 : i-_beg;
+}
+
+int CurvePath::indexOfMaxY(int beg, int end) const
+{
+    beg = qMax(0,beg);
+    end = qMin(count(),end);
+    if ( beg >= end ) {
+        return -1;
+    }
+    int i = _rangeExtents(_beg+beg,_beg+end).iymax;
+    return ( i < 0 ) ? -1 : i-_beg;
+}
+
+int CurvePath::indexOfLocalMaxY(int beg, int end) const
+{
+    return _indexOfPeak(beg,end,1.0);
+}
+
+int CurvePath::indexOfLocalMinY(int beg, int end) const
+{
+    return _indexOfPeak(beg,end,-1.0);
+}
+
+// Peaks of sign*y.  The highest point of the range is the answer if it
+// is a peak, else the tree is searched.
+int CurvePath::_indexOfPeak(int beg, int end, double sign) const
+{
+    beg = qMax(1,beg);
+    end = qMin(count()-1,end);
+    if ( beg >= end ) {
+        return -1;
+    }
+
+    Extents e = _rangeExtents(_beg+beg,_beg+end);
+    int i = ( sign > 0.0 ) ? e.iymax : e.iymin;
+    if ( i >= 0 && _isPeak(i,sign) ) {
+        return i-_beg;
+    }
+
+    PeakQuery q;
+    q.beg = _beg+beg;
+    q.end = _beg+end;
+    q.sign = sign;
+    q.iBest = -1;
+    q.vBest = -DBL_MAX;
+    if ( _tree.isEmpty() ) {
+        _scanPeaks(q.beg,q.end,&q);
+    } else {
+        _searchPeak(1,0,_treeLeaf,&q);
+    }
+
+    return ( q.iBest < 0 ) ? -1 : q.iBest-_beg;
+}
+
+// A node's max y bounds the peaks in it, so a node that can't beat (or
+// tie at a lower index) the best peak so far is skipped
+void CurvePath::_searchPeak(int node, int bLo, int bHi, PeakQuery *q) const
+{
+    int n = _points.size();
+    int beg = qMax(q->beg,bLo*BBoxBlockSize);
+    int end = qMin(q->end,qMin(n,bHi*BBoxBlockSize));
+    if ( beg >= end ) {
+        return;
+    }
+
+    const Extents& e = _tree.at(node);
+    double bound = ( q->sign > 0.0 ) ? e.ymax : -e.ymin;
+    if ( q->iBest >= 0 &&
+         (bound < q->vBest || (bound == q->vBest && beg > q->iBest)) ) {
+        return;
+    }
+
+    if ( node >= _treeLeaf ) {
+        _scanPeaks(beg,end,q);
+    } else {
+        int bMid = (bLo+bHi)/2;
+        const Extents& l = _tree.at(2*node);
+        const Extents& r = _tree.at(2*node+1);
+        double bl = ( q->sign > 0.0 ) ? l.ymax : -l.ymin;
+        double br = ( q->sign > 0.0 ) ? r.ymax : -r.ymin;
+        if ( !(br > bl) ) {
+            _searchPeak(2*node,bLo,bMid,q);
+            _searchPeak(2*node+1,bMid,bHi,q);
+        } else {
+            _searchPeak(2*node+1,bMid,bHi,q);
+            _searchPeak(2*node,bLo,bMid,q);
+        }
+    }
+}
+
+void CurvePath::_scanPeaks(int beg, int end, PeakQuery *q) const
+{
+    for ( int i = beg; i < end; ++i ) {
+        if ( _isPeak(i,q->sign) ) {
+            double v = q->sign*_points.at(i).y();
+            if ( q->iBest < 0 || v > q->vBest ||
+                 (v == q->vBest && i < q->iBest) ) {
+                q->iBest = i;
+                q->vBest = v;
+            }
+        }
+    }
+}
+
+bool CurvePath::_isPeak(int i, double sign) const
+{
+    const QPointF* p = _points.constData();
+    double v = sign*p[i].y();
+    return ( v > sign*p[i-1].y() && v > sign*p[i+1].y() );
+}
+
+void CurvePath::_buildBBoxTree()
+{
+    int n = _points.size();
+    int nblocks = (n+BBoxBlockSize-1)/BBoxBlockSize;
+    if ( nblocks < 2 ) {
+        _tree.clear();
+        _treeLeaf = 0;
+        return;
+    }
+
+    _treeLeaf = 1;
+    while ( _treeLeaf < nblocks ) {
+        _treeLeaf *= 2;
+    }
+
+    Extents none;
+    none.xmin = DBL_MAX;
+    none.xmax = -DBL_MAX;
+    none.ymin = DBL_MAX;
+    none.ymax = -DBL_MAX;
+    none.iymin = -1;
+    none.iymax = -1;
+    _tree.resize(2*_treeLeaf);
+    for ( int i = 0; i < 2*_treeLeaf; ++i ) {
+        _tree[i] = none;
+    }
+
+    for ( int b = 0; b < nblocks; ++b ) {
+        int beg = b*BBoxBlockSize;
+        int end = qMin(n,beg+BBoxBlockSize);
+        _scanBBox(beg,end,&_tree[_treeLeaf+b]);
+    }
+    for ( int i = _treeLeaf-1; i > 0; --i ) {
+        Extents e = _tree.at(2*i);
+        _unite(&e,_tree.at(2*i+1));
+        _tree[i] = e;
+    }
+}
+
+void CurvePath::_calcBBox()
+{
+    _xmin = _xmax = _ymin = _ymax = 0.0;
+    if ( isEmpty() ) {
+        return;
+    }
+
+    Extents e = _rangeExtents(_beg,_end);
+    if ( e.xmin <= e.xmax && e.ymin <= e.ymax ) {
+        _xmin = e.xmin;
+        _xmax = e.xmax;
+        _ymin = e.ymin;
+        _ymax = e.ymax;
+    }
+}
+
+// Extents of points [beg,end).  Partial blocks at the ends are scanned,
+// whole blocks in between come from the tree.
+CurvePath::Extents CurvePath::_rangeExtents(int beg, int end) const
+{
+    Extents e;
+    e.xmin = DBL_MAX;
+    e.xmax = -DBL_MAX;
+    e.ymin = DBL_MAX;
+    e.ymax = -DBL_MAX;
+    e.iymin = -1;
+    e.iymax = -1;
+
+    int b0 = (beg+BBoxBlockSize-1)/BBoxBlockSize;  // first whole block
+    int b1 = end/BBoxBlockSize;                    // past last whole block
+    if ( _tree.isEmpty() || b0 >= b1 ) {
+        _scanBBox(beg,end,&e);
+    } else {
+        _scanBBox(beg,b0*BBoxBlockSize,&e);
+        _scanBBox(b1*BBoxBlockSize,end,&e);
+        int lo = _treeLeaf+b0;
+        int hi = _treeLeaf+b1;
+        while ( lo < hi ) {
+            if ( lo & 1 ) {
+                _unite(&e,_tree.at(lo++));
+            }
+            if ( hi & 1 ) {
+                _unite(&e,_tree.at(--hi));
+            }
+            lo /= 2;
+            hi /= 2;
+        }
+    }
+
+    return e;
+}
+
+void CurvePath::_scanBBox(int beg, int end, Extents *e) const
+{
+    const QPointF* p = _points.constData();
+    for ( int i = beg; i < end; ++i ) {
+        double x = p[i].x();
+        double y = p[i].y();
+        if ( x < e->xmin ) e->xmin = x;
+        if ( x > e->xmax ) e->xmax = x;
+        if ( y < e->ymin || (y == e->ymin && i < e->iymin) ) {
+            e->ymin = y;
+            e->iymin = i;
+        }
+        if ( y > e->ymax || (y == e->ymax && i < e->iymax) ) {
+            e->ymax = y;
+            e->iymax = i;
+        }
+    }
+}
+
+// Ties go to the lower index, so min/max indices are the first ones
+void CurvePath::_unite(Extents *e, const Extents &f)
+{
+    if ( f.xmin < e->xmin ) e->xmin = f.xmin;
+    if ( f.xmax > e->xmax ) e->xmax = f.xmax;
+    if ( f.ymin < e->ymin || (f.ymin == e->ymin && f.iymin < e->iymin) ) {
+        e->ymin = f.ymin;
+        e->iymin = f.iymin;
+    }
+    if ( f.ymax > e->ymax || (f.ymax == e->ymax && f.iymax < e->iymax) ) {
+        e->ymax = f.ymax;
+        e->iymax = f.iymax;
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef CURVEPATH_H
+#define CURVEPATH_H
+
+#include <QPolygonF>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <QTransform>
+
+//
+// Compact cached geometry of a curve (what used to be a QPainterPath)
+//
+// Points are kept in a single contiguous QPolygonF which
+// QPainter::drawPolyline() draws without conversion.  A QPainterPath
+// element also carries a type tag and is converted to a polygon on every
+// draw.  The bounding box is kept as points are added.
+//
+// A path keeps the whole run and shows a window of it, so a new
+// start/stop time doesn't mean a new path.  count(), at() etc. and the
+// bounding box are for the points in the window.  Times are not kept in
+// the path.  The window is set on x when x is time (see setXWindow()) or
+// else on the data model rows of the start/stop times (see
+// setRowWindow()).  A point keeps its row only if points were skipped
+// (e.g. log(0) or frequency), otherwise point i is row i.  A curve whose
+// time goes backwards (e.g. a restarted sim) can't be windowed, its path
+// is built with only the points in the time range instead (see
+// isWholeRun()).  Build the path, then set its window.
+//
+// The window bounding box comes from a min/max segment tree over blocks
+// of points (built on the first setWindow()), so it costs a couple
+// of partial blocks plus log(n) tree nodes instead of a walk of the
+// window.  The tree is about a byte a point.  The same tree is the
+// spatial index for hit testing (see distanceTo()), subtrees whose box
+// misses the pick square are skipped.  It also answers nearest point
+// and min/max y range queries for the live coordinate, so a mouse move
+// is a couple of tree walks on any curve, x sorted or not.  Local min/max
+// queries descend the tree highest (lowest) block first and skip blocks
+// that can't beat the best peak so far.
+//
+class CurvePath
+{
+  public:
+
+    CurvePath();
+
+    void reserve(int n);
+    void squeeze();
+    void append(double x, double y);
+    void append(double x, double y, int row);  // row in the data model
+
+    void setWindow(int beg, int end);          // whole path indices
+    void setRowWindow(int rowBeg, int rowEnd); // rows [rowBeg,rowEnd)
+    void setXWindow(double xmin, double xmax); // if isXSorted()
+
+    // False if the path was built with only the points in a time range
+    void setWholeRun(bool isWholeRun) { _isWholeRun = isWholeRun; }
+    bool isWholeRun() const { return _isWholeRun; }
+    bool isXSorted() const { return _isXSorted; }
+
+    int count() const { return _end-_beg; }
+    bool isEmpty() const { return _end == _beg; }
+    const QPointF& at(int i) const { return _points.at(_beg+i); }
+    double x(int i) const { return _points.at(_beg+i).x(); }
+    double y(int i) const { return _points.at(_beg+i).y(); }
+    int row(int i) const
+    {
+        return _rows.isEmpty() ? _beg+i : _rows.at(_beg+i);
+    }
+    const QPointF* constData() const { return _points.constData()+_beg; }
+    QPolygonF points() const;
+
+    // Whole path and where the window is in it
+    const QPolygonF& allPoints() const { return _points; }
+    int windowBegin() const { return _beg; }
+    int windowEnd() const { return _end; }
+
+    QRectF boundingRect() const;
+
+    // True if rect R touches the bounding box (flat curves included)
+    bool intersects(const QRectF& R) const;
+
+    // Pixel distance from pt to the nearest segment in the window within
+    // radius pixels of pt (T maps the path to pixels), -1 if none is
+    double distanceTo(const QPointF& pt, double radius,
+                      const QTransform& T) const;
+
+    // Index of the window point nearest pt in pixels, -1 if none
+    int nearestPoint(const QPointF& pt, const QTransform& T) const;
+
+    // Window indices of first x >= x and first x > x (see isXSorted())
+    int lowerBoundX(double x) const;
+    int upperBoundX(double x) const;
+
+    // Index of (first) min/max y in window indices [beg,end), -1 if none
+    int indexOfMinY(int beg, int end) const;
+    int indexOfMaxY(int beg, int end) const;
+
+    // Index of the highest strict local max y (above both neighbors) in
+    // window indices [beg,end), the first if several, -1 if none.  The
+    // lowest strict local min for min.  Points at the ends of the window
+    // have one neighbor so they are not looked at.
+    int indexOfLocalMaxY(int beg, int end) const;
+    int indexOfLocalMinY(int beg, int end) const;
+
+  private:
+
+    enum { BBoxBlockSize = 64 };
+
+    struct Extents
+    {
+        double xmin;
+        double xmax;
+        double ymin;
+        double ymax;
+        int iymin;  // point index of ymin
+        int iymax;
+    };
+
+    QPolygonF _points;
+    QVector<int> _rows;  // empty if point i is row i
+    bool _isWholeRun;
+    bool _isXSorted;
+    int _beg;
+    int _end;
+    double _xmin;
+    double _xmax;
+    double _ymin;
+    double _ymax;
+
+    // Segment tree over blocks, leaves start at _treeLeaf (a power of two)
+    QVector<Extents> _tree;
+    int _treeLeaf;
+
+    // Nearest segment/point search state
+    struct NearQuery
+    {
+        QPointF pt;
+        QRectF M;        // pick square in path coordinates
+        QTransform T;
+        double dMin;
+        int iMin;
+    };
+
+    // Local min/max search state (value is y, or -y for a min)
+    struct PeakQuery
+    {
+        int beg;
+        int end;
+        double sign;
+        int iBest;
+        double vBest;
+    };
+
+    void _buildBBoxTree();
+    void _calcBBox();
+    Extents _rangeExtents(int beg, int end) const;
+    void _searchNode(int node, int bLo, int bHi, NearQuery* q) const;
+    void _searchSegments(int beg, int end, NearQuery* q) const;
+    void _searchNearest(int node, int bLo, int bHi, NearQuery* q) const;
+    void _searchPoints(int beg, int end, NearQuery* q) const;
+    double _pixelDistance(const Extents& e, const NearQuery* q) const;
+    int _indexOfPeak(int beg, int end, double sign) const;
+    void _searchPeak(int node, int bLo, int bHi, PeakQuery* q) const;
+    void _scanPeaks(int beg, int end, PeakQuery* q) const;
+    bool _isPeak(int i, double sign) const;
+    void _scanBBox(int beg, int end, Extents* e) const;
+    static void _unite(Extents* e, const Extents& f);
+};
+
+#endif // CURVEPATH_H
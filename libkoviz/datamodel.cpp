@@ -1,4 +1,5 @@
 #include <QFileInfo>
+#include <string.h>
 #include "datamodel.h"
 #include "datamodel_trick.h"
 #include "datamodel_csv.h"
@@ -23,3 +24,101 @@ DataModel *DataModel::createDataModel(const QStringList &timeNames,
 
     return dataModel;
 }
+
+DataModel::~DataModel()
+{
+    delete _timeIndex;
+}
+
+void DataModel::map()
+{
+    QMutexLocker locker(&_mapMutex);
+    if ( _mapCount == 0 ) {
+        _map();
+    }
+    ++_mapCount;
+}
+
+void DataModel::unmap()
+{
+    QMutexLocker locker(&_mapMutex);
+    if ( _mapCount == 0 ) {
+        return;
+    }
+    --_mapCount;
+    if ( _mapCount == 0 ) {
+        _unmap();
+    }
+}
+
+int DataModel::fetchColumn(int col, int beg, int cnt, double *buf) const
+{
+    cnt = _fetchCount(beg,cnt);
+    if ( cnt == 0 ) {
+        return 0;
+    }
+
+    ModelIterator* it = begin(col,col,col);
+    it->at(beg);
+    for ( int i = 0; i < cnt; ++i ) {
+        buf[i] = it->y();
+        it->next();
+    }
+    delete it;
+
+    return cnt;
+}
+
+int DataModel::fetchRows(int beg, int cnt,
+                         const QVector<int>& cols, double** bufs) const
+{
+    cnt = _fetchCount(beg,cnt);
+    for ( int i = 0; i < cols.size(); ++i ) {
+        fetchColumn(cols.at(i),beg,cnt,bufs[i]);
+    }
+
+    return cnt;
+}
+
+int DataModel::fetch(int tcol, int xcol, int ycol, int beg, int cnt,
+                     double *t, double *x, double *y) const
+{
+    cnt = _fetchCount(beg,cnt);
+    if ( cnt == 0 ) {
+        return 0;
+    }
+
+    if ( t ) fetchColumn(tcol,beg,cnt,t);
+    if ( x ) {
+        if ( t && xcol == tcol ) {
+            memcpy(x,t,cnt*sizeof(double));
+        } else {
+            fetchColumn(xcol,beg,cnt,x);
+        }
+    }
+    if ( y ) fetchColumn(ycol,beg,cnt,y);
+
+    return cnt;
+}
+
+int DataModel::indexAtTime(double time)
+{
+    return _getTimeIndex()->indexAtTime(time);
+}
+
+int DataModel::indexAtTime(double time, int *cursor)
+{
+    return _getTimeIndex()->indexAtTime(time,cursor);
+}
+
+// Built on first lookup, the time column is read once with a batch fetch
+const TimeIndex *DataModel::_getTimeIndex()
+{
+    QMutexLocker locker(&_timeIndexMutex);
+    if ( !_timeIndex ) {
+        QVector<double> times(rowCount());
+        fetchColumn(timeCol(),0,times.size(),times.data());
+        _timeIndex = new TimeIndex(times);
+    }
+    return _timeIndex;
+}
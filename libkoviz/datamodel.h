@@ -8,7 +8,10 @@
 #include <QAbstractTableModel>
 #include <QString>
 #include <QStringList>
+#include <QVector>
+#include <QMutex>
 #include "parameter.h"
+#include "timeindex.h"
 
 class DataModel;
 class ModelIterator;
@@ -24,32 +27,93 @@ class DataModel : public QAbstractTableModel
                        QObject *parent = 0) :
         QAbstractTableModel(parent),
         _timeNames(timeNames),
-        _fileName(fileName)
+        _fileName(fileName),
+        _mapCount(0),
+        _timeIndex(0)
     {}
 
-    ~DataModel() {}
+    ~DataModel();
 
     static DataModel* createDataModel(const QStringList& timeNames,
                                       const QString& fileName);
 
     QString fileName() const { return _fileName; }
 
-    virtual void map() = 0;
-    virtual void unmap() = 0;
+    // Maps are counted so nested map()/unmap() pairs, e.g. from curves
+    // sharing this model on worker threads, leave the file mapped until
+    // the last unmap()
+    void map();
+    void unmap();
+
     virtual const Parameter* param(int col) const = 0;
     virtual int paramColumn(const QString& param) const = 0;
     virtual ModelIterator* begin(int tcol, int xcol, int ycol) const = 0;
-    virtual int indexAtTime(double time) = 0 ;
+    virtual int timeCol() const = 0;
+
+    // Largest row with time <= time (see TimeIndex).  The cursor version
+    // is for monotone sequential lookups, start the cursor at 0.
+    int indexAtTime(double time);
+    int indexAtTime(double time, int* cursor);
+
+    // Batch fetch:  copies rows [beg,beg+cnt) of col into buf.
+    // The count is clamped to the rows available.  Returns number copied.
+    // The default walks an iterator, backends override with tight loops.
+    virtual int fetchColumn(int col, int beg, int cnt, double* buf) const;
+
+    // Row block fetch of many columns (e.g. for exporting rows), bufs[i]
+    // gets rows [beg,beg+cnt) of cols[i].  The default fetches a column
+    // at a time, trk models decode the rows straight from the mapping.
+    virtual int fetchRows(int beg, int cnt,
+                          const QVector<int>& cols, double** bufs) const;
+
+    // Whole decoded column, for readers that walk a column in blocks
+    // (e.g. CurveCursor) so the column is looked up once instead of per
+    // block.  Empty if the model doesn't keep decoded columns (or the
+    // column can't be decoded), then use fetchColumn().
+    virtual QVector<double> column(int col) const
+    {
+        Q_UNUSED(col);
+        return QVector<double>();
+    }
+
+    // Fetch of a curve triple, null t, x or y skips that column
+    int fetch(int tcol, int xcol, int ycol, int beg, int cnt,
+              double* t, double* x, double* y) const;
+
+    // Rows per fetch used by hot loops that walk a model in blocks
+    enum { FetchBlockSize = 8192 };
 
     virtual int rowCount(const QModelIndex& pidx=QModelIndex()) const = 0;
     virtual int columnCount(const QModelIndex& pidx=QModelIndex()) const = 0;
     virtual QVariant data(const QModelIndex& idx,
                           int role=Qt::DisplayRole) const = 0;
 
+  protected:
+
+    virtual void _map() = 0;
+    virtual void _unmap() = 0;
+
+    // Number of rows fetchable starting at beg (0 if beg out of range)
+    int _fetchCount(int beg, int cnt) const
+    {
+        int nrows = rowCount();
+        if ( beg < 0 || beg >= nrows || cnt <= 0 ) {
+            return 0;
+        }
+        return ( cnt > nrows-beg ) ? nrows-beg : cnt;
+    }
+
   private:
 
     QStringList _timeNames;
     QString _fileName;
+
+    int _mapCount;
+    QMutex _mapMutex;
+
+    TimeIndex* _timeIndex;
+    QMutex _timeIndexMutex;
+    const TimeIndex* _getTimeIndex();
 };
 
 class ModelIterator
@@ -1,32 +1,162 @@
 #include "datamodel_csv.h"
 
-QString CsvModel::_err_string;
-QTextStream CsvModel::_err_stream(&CsvModel::_err_string);
-
 CsvModel::CsvModel(const QStringList& timeNames,
                    const QString& csvfile,
                    QObject *parent) :
     DataModel(timeNames, csvfile, parent),
     _timeNames(timeNames),_csvfile(csvfile),
-    _nrows(0), _ncols(0),_iteratorTimeIndex(0),
-    _data(0)
+    _nrows(0), _ncols(0),
+    _file(csvfile), _mem(0), _memSize(0)
 {
     _init();
 }
 
-void CsvModel::_init()
+// Newline aligned piece of the csv body indexed by one thread
+struct CsvChunk
 {
-    QFile file(_csvfile);
+    const char* beg;
+    const char* end;
+    int row;        // first row of chunk
+    int nrows;      // non-blank lines in chunk
+    bool isIndexed;
+};
+
+static inline bool _isBlankLine(const char* beg, const char* end)
+{
+    return ( beg == end || (end-beg == 1 && *beg == '\r') );
+}
+
+// Finds field col of the line that starts at p.
+// A missing field is returned as an empty field.
+static inline void _csvField(const char* p, const char* memEnd, int col,
+                             const char** fbeg, const char** fend)
+{
+    for ( int c = 0; c < col; ++c ) {
+        while ( p < memEnd && *p != ',' && *p != '\n' ) ++p;
+        if ( p == memEnd || *p == '\n' ) {
+            *fbeg = p;
+            *fend = p;
+            return;
+        }
+        ++p;
+    }
+    const char* e = p;
+    while ( e < memEnd && *e != ',' && *e != '\n' ) ++e;
+    *fbeg = p;
+    *fend = e;
+}
+
+class CsvChunkCounter
+{
+  public:
+    void operator()(CsvChunk& chunk) const
+    {
+        int nrows = 0;
+        const char* p = chunk.beg;
+        while ( p < chunk.end ) {
+            const char* e = (const char*)memchr(p,'\n',chunk.end-p);
+            if ( !e ) e = chunk.end;
+            if ( !_isBlankLine(p,e) ) {
+                ++nrows;
+            }
+            p = e+1;
+        }
+        chunk.nrows = nrows;
+    }
+};
+
+// Records row offsets and parses the time column
+class CsvChunkIndexer
+{
+  public:
+    CsvChunkIndexer(const char* mem, const char* memEnd, int timeCol,
+                    qint64* rowOffsets, double* timeColumn) :
+        _mem(mem), _memEnd(memEnd), _timeCol(timeCol),
+        _rowOffsets(rowOffsets), _timeColumn(timeColumn)
+    {}
+
+    void operator()(CsvChunk& chunk) const
+    {
+        int row = chunk.row;
+        const char* p = chunk.beg;
+        while ( p < chunk.end ) {
+            const char* e = (const char*)memchr(p,'\n',chunk.end-p);
+            if ( !e ) e = chunk.end;
+            if ( !_isBlankLine(p,e) ) {
+                const char* fbeg;
+                const char* fend;
+                _csvField(p,_memEnd,_timeCol,&fbeg,&fend);
+                _rowOffsets[row] = p-_mem;
+                _timeColumn[row] = CsvModel::convertField(fbeg,fend);
+                ++row;
+            }
+            p = e+1;
+        }
+        chunk.isIndexed = true;
+    }
+
+  private:
+    const char* _mem;
+    const char* _memEnd;
+    int _timeCol;
+    qint64* _rowOffsets;
+    double* _timeColumn;
+};
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        _err_stream << "koviz [error]: could not open "
-                    << _csvfile << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+// Rows [beg,end) of a column parsed by one thread
+struct CsvRowBlock
+{
+    int beg;
+    int end;
+};
+
+// Parses rows of col into buf, buf[0] is row firstRow
+class CsvColumnParser
+{
+  public:
+    CsvColumnParser(const char* mem, const char* memEnd,
+                    const qint64* rowOffsets, int col,
+                    int firstRow, double* buf) :
+        _mem(mem), _memEnd(memEnd), _rowOffsets(rowOffsets),
+        _col(col), _firstRow(firstRow), _buf(buf)
+    {}
+
+    void operator()(const CsvRowBlock& block) const
+    {
+        for ( int row = block.beg; row < block.end; ++row ) {
+            const char* fbeg;
+            const char* fend;
+            _csvField(_mem+_rowOffsets[row],_memEnd,_col,&fbeg,&fend);
+            _buf[row-_firstRow] = CsvModel::convertField(fbeg,fend);
+        }
     }
-    QTextStream in(&file);
-    in.setCodec("UTF-8");
 
-    QString line0 = in.readLine();
+  private:
+    const char* _mem;
+    const char* _memEnd;
+    const qint64* _rowOffsets;
+    int _col;
+    int _firstRow;
+    double* _buf;
+};
+
+void CsvModel::_init()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    map();
+    const char* mem = _mem;
+    qint64 fileSize = _memSize;
+    const char* memEnd = mem + fileSize;
+
+    // Header line
+    const char* bodyBeg = mem;
+    if ( mem ) {
+        bodyBeg = (const char*)memchr(mem,'\n',fileSize);
+        bodyBeg = bodyBeg ? bodyBeg+1 : memEnd;
+    }
+    QString line0 = QString::fromUtf8(mem,(int)(bodyBeg-mem)).trimmed();
     QStringList items = line0.split(',',QString::SkipEmptyParts);
     int col = 0;
     foreach ( QString item, items ) {
@@ -76,88 +206,247 @@ void CsvModel::_init()
         }
     }
     if ( ! isFoundTime ) {
-        _err_stream << "koviz [error]: couldn't find time param \""
-                    << _timeNames.join("=") << "\" in file=" << _csvfile
-                    << ".  Try setting -timeName on commandline option.";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        unmap();
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: couldn't find time param \""
+                  << _timeNames.join("=") << "\" in file=" << _csvfile
+                  << ".  Try setting -timeName on commandline option.";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
-    _iteratorTimeIndex = new CsvModelIterator(0,this,
-                                              _timeCol,_timeCol,_timeCol);
-
-#ifdef __linux
-    TimeItLinux timer;
-    timer.start();
-#endif
+    //
+    // Split body into newline aligned chunks (about 4MB each)
+    //
+    QList<CsvChunk> chunks;
+    qint64 bodySize = memEnd-bodyBeg;
+    qint64 chunkSize = 4*1024*1024;
+    int nChunks = (int)((bodySize+chunkSize-1)/chunkSize);
+    const char* p = bodyBeg;
+    for ( int i = 0; i < nChunks && p < memEnd; ++i ) {
+        const char* e = bodyBeg + (i+1)*chunkSize;
+        if ( e >= memEnd ) {
+            e = memEnd;
+        } else {
+            e = (const char*)memchr(e,'\n',memEnd-e);
+            e = e ? e+1 : memEnd;
+        }
+        if ( e <= p ) continue;
+        CsvChunk chunk;
+        chunk.beg = p;
+        chunk.end = e;
+        chunk.row = 0;
+        chunk.nrows = 0;
+        chunk.isIndexed = false;
+        chunks.append(chunk);
+        p = e;
+    }
 
-    // Get number of data rows in csv file
-    while ( !in.atEnd() ) {
-        in.readLine();
-        ++_nrows;
+    // Count rows per chunk (a memchr scan, no parsing)
+    QtConcurrent::blockingMap(chunks,CsvChunkCounter());
+    _nrows = 0;
+    for ( int i = 0; i < chunks.size(); ++i ) {
+        chunks[i].row = _nrows;
+        _nrows += chunks.at(i).nrows;
     }
 
-    // Allocate to hold *all* parsed data
-    _data = (double*)malloc(_nrows*_ncols*sizeof(double));
-
-    // Begin Progress Dialog
-    QString msg("Loading ");
-    msg += QFileInfo(fileName()).fileName();
-    msg += "...";
-    QProgressDialog progress(msg, "Abort", 0, _nrows-1, 0);
-    progress.setWindowModality(Qt::WindowModal);
-    int row = 0;
-
-    // Read in data
-    in.seek(0);
-    in.readLine(); // csv header line
-    int i = 0;
-    while ( !in.atEnd() ) {
-        if (progress.wasCanceled()) {
-             break;
-        }
-        if ( row % 10000 == 0 ) {
-            progress.setValue(row);
+    // Index rows and parse time column in parallel.
+    // Other columns are parsed on demand (see _column())
+    _rowOffsets.resize(_nrows);
+    _timeColumn.resize(_nrows);
+    QFuture<void> future = QtConcurrent::map(chunks,
+                                    CsvChunkIndexer(mem,memEnd,_timeCol,
+                                                    _rowOffsets.data(),
+                                                    _timeColumn.data()));
+
+    // Progress dialog
+    // Widgets can only be made on the gui thread and
+    // Runs may load models on its thread pool
+    if ( QCoreApplication::instance() &&
+         QThread::currentThread() == QCoreApplication::instance()->thread() &&
+         chunks.size() > 1 ) {
+        QString msg("Loading ");
+        msg += QFileInfo(fileName()).fileName();
+        msg += "...";
+        QProgressDialog progress(msg, "Abort", 0, chunks.size(), 0);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(500);
+
+        QFutureWatcher<void> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        QObject::connect(&watcher, SIGNAL(progressValueChanged(int)),
+                         &progress, SLOT(setValue(int)));
+        QObject::connect(&progress, SIGNAL(canceled()),
+                         &watcher, SLOT(cancel()));
+        watcher.setFuture(future);
+        if ( !future.isFinished() ) {
+            loop.exec();
         }
-        ++row;
-
-        QString line = in.readLine();
-        int from = 0;
-        while (1) {
-            int j = line.indexOf(',',from);
-            if ( j < 0 ) {
-                _data[i] = _convert(line.mid(from,line.size()-from));
-                ++i;
-                break;
-            }
-            _data[i] = _convert(line.mid(from,j-from));
-            from = j+1;
-            ++i;
+        future.waitForFinished();
+        progress.setValue(chunks.size());
+    } else {
+        future.waitForFinished();
+    }
+
+    // If aborted, keep rows up to first unindexed chunk
+    for ( int i = 0; i < chunks.size(); ++i ) {
+        if ( !chunks.at(i).isIndexed ) {
+            _nrows = chunks.at(i).row;
+            _rowOffsets.resize(_nrows);
+            _timeColumn.resize(_nrows);
+            break;
         }
+    }
+
+    // Report throughput for slow loads
+    double secs = timer.elapsed()/1000.0;
+    if ( secs > 1.0 ) {
+        double mb = fileSize/(1024.0*1024.0);
+        fprintf(stderr,"koviz [info]: loaded %s (%.1f MB in %.1f sec, "
+                       "%.1f MB/s)\n",
+                _csvfile.toLatin1().constData(), mb, secs, mb/secs);
+    }
+}
+
+void CsvModel::_map()
+{
+    QMutexLocker locker(&_memMutex);
+
+    if ( _file.isOpen() ) return; // already mapped
+
+    if (!_file.open(QIODevice::ReadOnly)) {
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: could not open "
+                  << _csvfile << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
+    }
 
-#ifdef __linux
-        if ( row % 10000 == 0 ) {
-            int secs = qRound(timer.stop()/1000000.0);
-            div_t d = div(secs,60);
-            QString msg = QString("Loaded %1 of %2 lines "
-                                  "(%3 min %4 sec)")
-                    .arg(row).arg(_nrows).arg(d.quot).arg(d.rem);
-            progress.setLabelText(msg);
+    _memSize = _file.size();
+    if ( _memSize > 0 ) {
+        _mem = (const char*)_file.map(0,_memSize);
+        if ( !_mem ) {
+            _file.close();
+            QString err;
+            QTextStream errStream(&err);
+            errStream << "koviz [error]: CsvModel couldn't map : "
+                      << _csvfile << "\n";
+            throw std::runtime_error(err.toLatin1().constData());
         }
-#endif
     }
+}
+
+void CsvModel::_unmap()
+{
+    QMutexLocker locker(&_memMutex);
 
-    // End Progress Dialog
-    progress.setValue(_nrows-1);
+    if ( _mem ) {
+        _file.unmap((uchar*)_mem);
+        _mem = 0;
+    }
+    _file.close();
+}
 
-    file.close();
+// Returns parsed column from the column cache, parsing it on first use.
+// A column the cache won't take (e.g. -cacheSize 0) is still returned
+// whole, but readers of part of a column should use fetchColumn() which
+// then parses just the rows asked for.
+QVector<double> CsvModel::_column(int col) const
+{
+    QVector<double> column;
+    if ( _findColumn(col,&column) ) {
+        return column;
+    }
+
+    column.resize(_nrows);
+    _parseRows(col,0,_nrows,column.data());
+    ColumnCache::instance()->insert(this,col,column);
+
+    return column;
+}
+
+// True (and the column) if col is parsed already
+bool CsvModel::_findColumn(int col, QVector<double> *column) const
+{
+    if ( col == _timeCol ) {
+        *column = _timeColumn;
+        return true;
+    }
+    return ColumnCache::instance()->find(this,col,column);
 }
 
-void CsvModel::map()
+// True if col is (or could be) kept whole
+bool CsvModel::_isColumnCacheable(int col) const
 {
+    qint64 nbytes = (qint64)_nrows*(qint64)sizeof(double);
+    return ( col == _timeCol || nbytes <= ColumnCache::instance()->budget() );
+}
+
+// Parses rows [beg,beg+cnt) of col into buf using the row offset index.
+// A small range is parsed from the model's mapping under _memMutex, so it
+// can't be unmapped (e.g. by the gui thread) under the reader.  A big
+// range (or any range of an unmapped model) is parsed in parallel from a
+// mapping of the file made just for the parse, so no lock is held while
+// the thread pool works and other readers aren't held up.
+void CsvModel::_parseRows(int col, int beg, int cnt, double *buf) const
+{
+    if ( cnt <= 0 ) {
+        return;
+    }
+
+    QList<CsvRowBlock> blocks;
+    const int blockSize = 65536;
+    for ( int row = beg; row < beg+cnt; row += blockSize ) {
+        CsvRowBlock block;
+        block.beg = row;
+        block.end = qMin(row+blockSize,beg+cnt);
+        blocks.append(block);
+    }
+
+    if ( blocks.size() == 1 ) {
+        QMutexLocker locker(&_memMutex);
+        if ( _mem ) {
+            CsvColumnParser parser(_mem,_mem+_memSize,
+                                   _rowOffsets.constData(),col,beg,buf);
+            parser(blocks.first());
+            return;
+        }
+    }
+
+    QFile file(_csvfile);
+    const char* mem = 0;
+    qint64 memSize = 0;
+    if ( file.open(QIODevice::ReadOnly) ) {
+        memSize = file.size();
+        mem = (const char*)file.map(0,memSize);
+    }
+    if ( !mem ) {
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: CsvModel couldn't map : "
+                  << _csvfile << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
+    }
+
+    CsvColumnParser parser(mem,mem+memSize,_rowOffsets.constData(),
+                           col,beg,buf);
+    if ( blocks.size() == 1 ) {
+        parser(blocks.first());
+    } else {
+        QtConcurrent::blockingMap(blocks,parser);
+    }
+
+    file.unmap((uchar*)mem);
+    file.close();
 }
 
-void CsvModel::unmap()
+// Value of col at row, parsed from the file unless the column is parsed
+double CsvModel::_parseRow(int col, int row) const
 {
+    double v;
+    _parseRows(col,row,1,&v);
+    return v;
 }
 
 int CsvModel::paramColumn(const QString &paramName) const
@@ -175,15 +464,8 @@ CsvModel::~CsvModel()
     foreach ( Parameter* param, _col2param.values() ) {
         delete param;
     }
-    if ( _data ) {
-        free(_data);
-        _data = 0;
-    }
-
-    if ( _iteratorTimeIndex ) {
-        delete _iteratorTimeIndex;
-        _iteratorTimeIndex = 0;
-    }
+    ColumnCache::instance()->remove(this);
+    _unmap();
 }
 
 const Parameter* CsvModel::param(int col) const
@@ -191,50 +473,35 @@ const Parameter* CsvModel::param(int col) const
     return _col2param.value(col);
 }
 
-int CsvModel::indexAtTime(double time)
-{
-    return _idxAtTimeBinarySearch(_iteratorTimeIndex,0,rowCount()-1,time);
-}
-
-int CsvModel::_idxAtTimeBinarySearch (CsvModelIterator* it,
-                                       int low, int high, double time)
+int CsvModel::fetchColumn(int col, int beg, int cnt, double *buf) const
 {
-        if (high <= 0 ) {
-                return 0;
-        }
-        if (low >= high) {
-                return ( it->at(high)->t() > time ) ? high-1 : high;
+    cnt = _fetchCount(beg,cnt);
+    if ( cnt > 0 ) {
+        QVector<double> column;
+        if ( _findColumn(col,&column) ) {
+            memcpy(buf,column.constData()+beg,cnt*sizeof(double));
+        } else if ( cnt >= FetchBlockSize && _isColumnCacheable(col) ) {
+            // A bulk read (e.g. of a curve) parses and caches the column
+            column = _column(col);
+            memcpy(buf,column.constData()+beg,cnt*sizeof(double));
         } else {
-                int mid = (low + high)/2;
-                if (time == it->at(mid)->t()) {
-                        return mid;
-                } else if ( time < it->at(mid)->t() ) {
-                        return _idxAtTimeBinarySearch(it,
-                                                      low, mid-1, time);
-                } else {
-                        return _idxAtTimeBinarySearch(it,
-                                                      mid+1, high, time);
-                }
+            // A few rows (e.g. table cells) are parsed on their own
+            _parseRows(col,beg,cnt,buf);
         }
+    }
+    return cnt;
 }
 
-double CsvModel::_convert(const QString &s)
+// Locale free conversion of a csv field.
+// A field that is not a number may be a utc timestamp hh:mm:ss
+double CsvModel::convertField(const char* beg, const char* end)
 {
-    double val = 0.0;
-
     bool ok;
-    val = s.toDouble(&ok);
+    double val = NumParse::toDouble(beg,end,&ok);
     if ( !ok ) {
-        QStringList vals = s.split(":");
-        if (vals.length() == 3 ) {
-            // Try converting to a utc timestamp
-            val = 3600.0*vals.at(0).toDouble(&ok);
-            if ( ok ) {
-                val += 60.0*vals.at(1).toDouble(&ok);
-                if ( ok ) {
-                    val += vals.at(2).toDouble(&ok);
-                }
-            }
+        val = NumParse::hmsToDouble(beg,end,&ok);
+        if ( !ok ) {
+            val = 0.0;
         }
     }
 
@@ -265,10 +532,12 @@ QVariant CsvModel::data(const QModelIndex &idx, int role) const
     Q_UNUSED(role);
     QVariant val;
 
-    if ( idx.isValid() && _data ) {
+    if ( idx.isValid() && idx.row() < _nrows ) {
         int row = idx.row();
         int col = idx.column();
-        val = _data[row*_ncols+col];
+        double v;
+        fetchColumn(col,row,1,&v);
+        val = v;
     }
 
     return val;
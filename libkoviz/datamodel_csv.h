@@ -9,12 +9,27 @@
 #include <QTextStream>
 #include <QProgressDialog>
 #include <QFileInfo>
+#include <QThread>
+#include <QCoreApplication>
+#include <QFile>
+#include <QList>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrentMap>
+#include <string.h>
 #include <stdexcept>
 
 #include "datamodel.h"
 #include "parameter.h"
 #include "unit.h"
 #include "timeit_linux.h"
+#include "numparse.h"
+#include "columncache.h"
 
 class CsvModel;
 class CsvModelIterator;
@@ -33,17 +48,24 @@ class CsvModel : public DataModel
     ~CsvModel();
 
     virtual const Parameter* param(int col) const ;
-    virtual void map();
-    virtual void unmap();
     virtual int paramColumn(const QString& paramName) const ;
     virtual ModelIterator* begin(int tcol, int xcol, int ycol) const ;
-    int indexAtTime(double time);
+    virtual int timeCol() const { return _timeCol; }
+    virtual int fetchColumn(int col, int beg, int cnt, double* buf) const;
+    virtual QVector<double> column(int col) const { return _column(col); }
 
     virtual int rowCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual int columnCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual QVariant data (const QModelIndex & index,
                            int role = Qt::DisplayRole ) const;
 
+    static double convertField(const char* beg, const char* end);
+
+  protected:
+
+    virtual void _map();
+    virtual void _unmap();
+
   private:
 
     QStringList _timeNames;
@@ -55,18 +77,20 @@ class CsvModel : public DataModel
 
     QHash<int,Parameter*> _col2param;
     QHash<QString,int> _paramName2col;
-    CsvModelIterator* _iteratorTimeIndex;
 
-    double* _data;
-
-    static QString _err_string;
-    static QTextStream _err_stream;
+    QFile _file;
+    const char* _mem;           // file mapping (0 if unmapped)
+    qint64 _memSize;
+    mutable QMutex _memMutex;   // guards _mem/_memSize for readers
+    QVector<qint64> _rowOffsets; // file offset of each data row
+    QVector<double> _timeColumn; // time is always parsed
 
     void _init();
-    int _idxAtTimeBinarySearch (CsvModelIterator *it,
-                               int low, int high, double time);
-
-    inline double _convert(const QString& s);
+    QVector<double> _column(int col) const;
+    bool _findColumn(int col, QVector<double>* column) const;
+    bool _isColumnCacheable(int col) const;
+    void _parseRows(int col, int beg, int cnt, double* buf) const;
+    double _parseRow(int col, int row) const;
 };
 
 class CsvModelIterator : public ModelIterator
@@ -75,13 +99,19 @@ class CsvModelIterator : public ModelIterator
 
     inline CsvModelIterator(): i(0) {}
 
+    // Columns already parsed (time and cached columns) are read from
+    // memory, others are parsed a row at a time from the file mapping
     inline CsvModelIterator(int row, // iterator pos
                             const CsvModel* model,
                             int tcol, int xcol, int ycol):
         i(row),
         _model(model),
-        _tcol(tcol), _xcol(xcol), _ycol(ycol)
+        _tcol(tcol), _xcol(xcol), _ycol(ycol),
+        _tc(0), _xc(0), _yc(0)
     {
+        if ( model->_findColumn(tcol,&_tcolumn) ) _tc = _tcolumn.constData();
+        if ( model->_findColumn(xcol,&_xcolumn) ) _xc = _xcolumn.constData();
+        if ( model->_findColumn(ycol,&_ycolumn) ) _yc = _ycolumn.constData();
     }
 
     virtual ~CsvModelIterator() {}
@@ -109,17 +139,17 @@ class CsvModelIterator : public ModelIterator
 
     inline double t() const
     {
-        return _model->_data[i*_model->_ncols+_tcol];
+        return _tc ? _tc[i] : _model->_parseRow(_tcol,i);
     }
 
     inline double x() const
     {
-        return _model->_data[i*_model->_ncols+_xcol];
+        return _xc ? _xc[i] : _model->_parseRow(_xcol,i);
     }
 
     inline double y() const
     {
-        return _model->_data[i*_model->_ncols+_ycol];
+        return _yc ? _yc[i] : _model->_parseRow(_ycol,i);
     }
 
   private:
@@ -129,6 +159,12 @@ class CsvModelIterator : public ModelIterator
     int _tcol;
     int _xcol;
     int _ycol;
+    QVector<double> _tcolumn;
+    QVector<double> _xcolumn;
+    QVector<double> _ycolumn;
+    const double* _tc;
+    const double* _xc;
+    const double* _yc;
 };
 
 
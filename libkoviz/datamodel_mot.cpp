@@ -1,14 +1,11 @@
 #include "datamodel_mot.h"
 
-QString MotModel::_err_string;
-QTextStream MotModel::_err_stream(&MotModel::_err_string);
-
 MotModel::MotModel(const QStringList& timeNames,
                    const QString& motfile,
                    QObject *parent) :
     DataModel(timeNames, motfile, parent),
     _timeNames(timeNames),_motfile(motfile),
-    _nrows(0), _ncols(0),_iteratorTimeIndex(0),
+    _nrows(0), _ncols(0),
     _data(0)
 {
     _init();
@@ -19,9 +16,11 @@ void MotModel::_init()
     QFile file(_motfile);
 
     if (!file.open(QIODevice::ReadOnly)) {
-        _err_stream << "koviz [error]: could not open "
-                    << _motfile << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: could not open "
+                  << _motfile << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
     QTextStream in(&file);
     in.setCodec("UTF-8");
@@ -89,9 +88,6 @@ void MotModel::_init()
         exit(-1);
     }
 
-    _iteratorTimeIndex = new MotModelIterator(0,this,
-                                              _timeCol,_timeCol,_timeCol);
-
     // Get number of data rows in mot file
     while ( !in.atEnd() ) {
         in.readLine();
@@ -135,11 +131,11 @@ void MotModel::_init()
     file.close();
 }
 
-void MotModel::map()
+void MotModel::_map()
 {
 }
 
-void MotModel::unmap()
+void MotModel::_unmap()
 {
 }
 
@@ -166,11 +162,6 @@ MotModel::~MotModel()
         free(_data);
         _data = 0;
     }
-
-    if ( _iteratorTimeIndex ) {
-        delete _iteratorTimeIndex;
-        _iteratorTimeIndex = 0;
-    }
 }
 
 const Parameter* MotModel::param(int col) const
@@ -178,31 +169,15 @@ const Parameter* MotModel::param(int col) const
     return _col2param.value(col);
 }
 
-int MotModel::indexAtTime(double time)
-{
-    return _idxAtTimeBinarySearch(_iteratorTimeIndex,0,rowCount()-1,time);
-}
-
-int MotModel::_idxAtTimeBinarySearch (MotModelIterator* it,
-                                       int low, int high, double time)
+int MotModel::fetchColumn(int col, int beg, int cnt, double *buf) const
 {
-        if (high <= 0 ) {
-                return 0;
-        }
-        if (low >= high) {
-                return ( it->at(high)->t() > time ) ? high-1 : high;
-        } else {
-                int mid = (low + high)/2;
-                if (time == it->at(mid)->t()) {
-                        return mid;
-                } else if ( time < it->at(mid)->t() ) {
-                        return _idxAtTimeBinarySearch(it,
-                                                      low, mid-1, time);
-                } else {
-                        return _idxAtTimeBinarySearch(it,
-                                                      mid+1, high, time);
-                }
-        }
+    cnt = _fetchCount(beg,cnt);
+    const double* d = _data + (qint64)beg*_ncols + col;
+    for ( int i = 0; i < cnt; ++i ) {
+        buf[i] = *d;
+        d += _ncols;
+    }
+    return cnt;
 }
 
 double MotModel::_convert(const QString &s)
@@ -33,17 +33,21 @@ class MotModel : public DataModel
     ~MotModel();
 
     virtual const Parameter* param(int col) const ;
-    virtual void map();
-    virtual void unmap();
     virtual int paramColumn(const QString& paramName) const ;
     virtual ModelIterator* begin(int tcol, int xcol, int ycol) const ;
-    int indexAtTime(double time);
+    virtual int timeCol() const { return _timeCol; }
+    virtual int fetchColumn(int col, int beg, int cnt, double* buf) const;
 
     virtual int rowCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual int columnCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual QVariant data (const QModelIndex & index,
                            int role = Qt::DisplayRole ) const;
 
+  protected:
+
+    virtual void _map();
+    virtual void _unmap();
+
   private:
 
     QStringList _timeNames;
@@ -55,16 +59,10 @@ class MotModel : public DataModel
 
     QHash<int,Parameter*> _col2param;
     QHash<QString,int> _paramName2col;
-    MotModelIterator* _iteratorTimeIndex;
 
     double* _data;
 
-    static QString _err_string;
-    static QTextStream _err_stream;
-
     void _init();
-    int _idxAtTimeBinarySearch (MotModelIterator *it,
-                               int low, int high, double time);
 
     inline double _convert(const QString& s);
 };
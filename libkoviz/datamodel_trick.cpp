@@ -1,31 +1,47 @@
 #include "datamodel_trick.h"
+#include "trkcatalog.h"
+#include "byteswap.h"
 #include <QStringList>
 #include <stdio.h>
 #include <stdexcept>
 #include <unistd.h>
-
-QString TrickModel::_err_string;
-QTextStream TrickModel::_err_stream(&TrickModel::_err_string);
+#include <string.h>
 
 TrickModel::TrickModel(const QStringList& timeNames,
                        const QString& trkfile, QObject *parent) :
     DataModel(timeNames, trkfile, parent),
     _timeNames(timeNames),_trkfile(trkfile),
+    _byteOrder(QDataStream::LittleEndian),
     _nrows(0), _row_size(0), _ncols(0), _timeCol(0),_pos_beg_data(0),
-    _mem(0), _data(0), _fd(-1), _file(_trkfile),_iteratorTimeIndex(0)
+    _mem(0), _data(0), _fd(-1), _file(_trkfile), _isSwap(false)
 {
     _load_trick_header();
     map();
 }
 
+TrickModel::TrickModel(const QStringList& timeNames,
+                       const QString& trkfile,
+                       const TrkCatalogEntry& entry,
+                       QObject *parent) :
+    DataModel(timeNames, trkfile, parent),
+    _timeNames(timeNames),_trkfile(trkfile),
+    _byteOrder(QDataStream::LittleEndian),
+    _nrows(0), _row_size(0), _ncols(0), _timeCol(0),_pos_beg_data(0),
+    _mem(0), _data(0), _fd(-1), _file(_trkfile), _isSwap(false)
+{
+    _load_catalog_entry(entry);
+}
+
 bool TrickModel::_load_trick_header()
 {
     bool ret = true;
 
     if (!_file.open(QIODevice::ReadOnly)) {
-        _err_stream << "koviz [error]: could not open "
-                    << _trkfile << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: could not open "
+                  << _trkfile << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
     QDataStream in(&_file);
 
@@ -40,18 +56,21 @@ bool TrickModel::_load_trick_header()
     } else if ( data[0] == '0' && data[1] == '7' ) {
         _trick_version = TrickVersion07;
     } else {
-        _err_stream << "koviz [error]: unrecognized file or Trick version: "
-                    << _trkfile << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: unrecognized file or Trick version: "
+                  << _trkfile << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
     in.readRawData(data,1) ; // -
     in.readRawData(data,1) ; // L or B (endian)
     if ( data[0] == 'L' ) {
-        in.setByteOrder(QDataStream::LittleEndian);
+        _byteOrder = QDataStream::LittleEndian;
     } else {
-        in.setByteOrder(QDataStream::BigEndian);
+        _byteOrder = QDataStream::BigEndian;
     }
+    in.setByteOrder(_byteOrder);
 
     //
     // Number of parameters (4 byte integer)
@@ -69,20 +88,41 @@ bool TrickModel::_load_trick_header()
         _paramtypes.push_back(p->type());
     }
     if ( _row_size == 0 ) {
-        _err_stream << "koviz [error]: trk file \""
-                    << _file.fileName() << "\" is corrupt!\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: trk file \""
+                  << _file.fileName() << "\" is corrupt!\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
     // Sanity check. Bytes remaining should be a multiple of the record size
     qint64 nbytes = _file.bytesAvailable();
     if ( nbytes % _row_size != 0 ) {
-        _err_stream << "koviz [error]: trk file \""
-                    << _file.fileName() << "\" is corrupt!\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: trk file \""
+                  << _file.fileName() << "\" is corrupt!\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
+    _setDecoders();
+
     // Make sure time param exists in model and set time column
+    _setTimeCol();
+
+    // Save address of begin location of data for map()
+    _pos_beg_data = _file.pos();
+
+    // Calculate number of timestamped records in file
+    _nrows = nbytes/(qint64)_row_size;
+
+    _file.close();
+
+    return ret;
+}
+
+void TrickModel::_setTimeCol()
+{
     bool isFoundTime = false;
     foreach (QString timeName, _timeNames) {
         if ( _param2column.contains(timeName)) {
@@ -92,21 +132,62 @@ bool TrickModel::_load_trick_header()
         }
     }
     if ( ! isFoundTime ) {
-        _err_stream << "koviz [error]: couldn't find time param \""
-                    << _timeNames.join("=") << "\" in trkfile=" << _trkfile
-                    << ".  Try setting -timeName on commandline option.";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: couldn't find time param \""
+                  << _timeNames.join("=") << "\" in trkfile=" << _trkfile
+                  << ".  Try setting -timeName on commandline option.";
+        throw std::runtime_error(err.toLatin1().constData());
     }
+}
 
-    // Save address of begin location of data for map()
-    _pos_beg_data = _file.pos();
-
-    // Calculate number of timestamped records in file
-    _nrows = nbytes/(qint64)_row_size;
+void TrickModel::_load_catalog_entry(const TrkCatalogEntry &entry)
+{
+    _trick_version = ( entry.trickVersion == 10 ) ? TrickVersion10
+                                                  : TrickVersion07;
+    _byteOrder = ( entry.byteOrder == 'B' ) ? QDataStream::BigEndian
+                                            : QDataStream::LittleEndian;
+    _ncols = entry.params.size();
+    _row_size = 0;
+    for ( int cc = 0; cc < _ncols; ++cc ) {
+        TrickParameter* param = new TrickParameter(entry.params.at(cc));
+        _col2offset[cc] = _row_size;
+        _row_size += param->size();
+        _col2param.insert(cc,param);
+        _param2column.insert(param->name(),cc);
+        _paramtypes.push_back(param->type());
+    }
+    if ( _row_size != entry.rowSize ) {
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: catalog entry for trk file \""
+                  << _trkfile << "\" is corrupt!\n";
+        throw std::runtime_error(err.toLatin1().constData());
+    }
+    _setDecoders();
+    _setTimeCol();
+    _pos_beg_data = entry.posBegData;
+    _nrows = entry.nrows;
+}
 
-    _file.close();
+TrkCatalogEntry TrickModel::catalogEntry() const
+{
+    TrkCatalogEntry entry;
+
+    QFileInfo fi(_trkfile);
+    entry.fileName = fi.fileName();
+    entry.fileSize = fi.size();
+    entry.mtime = fi.lastModified().toMSecsSinceEpoch();
+    entry.trickVersion = ( _trick_version == TrickVersion10 ) ? 10 : 7;
+    entry.byteOrder = ( _byteOrder == QDataStream::BigEndian ) ? 'B' : 'L';
+    entry.posBegData = _pos_beg_data;
+    entry.rowSize = _row_size;
+    entry.nrows = _nrows;
+    for ( int cc = 0; cc < _ncols; ++cc ) {
+        entry.params.append(*(_col2param.value(cc)));
+    }
 
-    return ret;
+    return entry;
 }
 
 // Returns byte size of parameter
@@ -148,44 +229,38 @@ qint32 TrickModel::_load_binary_param(QDataStream& in, int col)
     return sz;
 }
 
-void TrickModel::map()
+void TrickModel::_map()
 {
     if ( _data ) return; // already mapped
 
     if (!_file.open(QIODevice::ReadOnly)) {
-        _err_stream << "koviz [error]: could not open "
-                    << _file.fileName() << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: could not open "
+                  << _file.fileName() << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
     _mem = (ptrdiff_t) _file.map(0,_file.size());
 
     if ( _mem == 0 ) {
-        _err_stream << "koviz [error]: TrickModel couldn't allocate memory for : "
-                    << _file.fileName() << "\n";
-        throw std::runtime_error(_err_string.toLatin1().constData());
+        QString err;
+        QTextStream errStream(&err);
+        errStream << "koviz [error]: TrickModel couldn't allocate memory for : "
+                  << _file.fileName() << "\n";
+        throw std::runtime_error(err.toLatin1().constData());
     }
 
     _data = _mem + _pos_beg_data;
-
-    if ( _iteratorTimeIndex ) {
-        delete _iteratorTimeIndex;
-    }
-    _iteratorTimeIndex = new TrickModelIterator(0,this,
-                                                _timeCol,_timeCol,_timeCol);
 }
 
-void TrickModel::unmap()
+void TrickModel::_unmap()
 {
     if ( _data ) {
         _file.unmap((uchar*)_mem);
         _file.close();
         _data = 0 ;
     }
-    if ( _iteratorTimeIndex ) {
-        delete _iteratorTimeIndex;
-        _iteratorTimeIndex = 0;
-    }
 }
 
 ModelIterator *TrickModel::begin(int tcol, int xcol, int ycol) const
@@ -195,20 +270,274 @@ ModelIterator *TrickModel::begin(int tcol, int xcol, int ycol) const
 
 TrickModel::~TrickModel()
 {
-    unmap();
+    ColumnCache::instance()->remove(this);
+    _unmap();
     foreach ( Parameter* param, _col2param.values() ) {
         delete param;
     }
 }
 
-const Parameter* TrickModel::param(int col) const
+//
+// Column decode kernels, one per logged C type.  The column loop is a
+// plain strided load and convert so the compiler can unroll/vectorize it.
+//
+template <typename T>
+static void _decodeColumn(ptrdiff_t addr, qint64 stride,
+                          int cnt, double* buf)
 {
-    return _col2param.value(col);
+    const char* p = (const char*)addr;
+    for ( int i = 0; i < cnt; ++i ) {
+        buf[i] = (double) *((const T*)(p+i*stride));
+    }
+}
+
+// Gathers a block of raw values, swaps the block in bulk, then converts
+template <typename T>
+static void _decodeColumnSwapped(ptrdiff_t addr, qint64 stride,
+                                 int cnt, double* buf)
+{
+    const int blockSize = 512;
+    T raw[blockSize];
+    const char* p = (const char*)addr;
+    for ( int beg = 0; beg < cnt; beg += blockSize ) {
+        int n = qMin(blockSize,cnt-beg);
+        for ( int i = 0; i < n; ++i ) {
+            memcpy(&raw[i],p+(beg+i)*stride,sizeof(T));
+        }
+        ByteSwap::swapBlock(raw,sizeof(T),n);
+        for ( int i = 0; i < n; ++i ) {
+            buf[beg+i] = (double) raw[i];
+        }
+    }
+}
+
+template <typename T>
+static TrickColumnDecoder _columnDecoderOf(bool isSwap)
+{
+    if ( isSwap && sizeof(T) > 1 ) {
+        return _decodeColumnSwapped<T>;
+    } else {
+        return _decodeColumn<T>;
+    }
+}
+
+static TrickValueType _trick07ValueType(int paramtype)
+{
+    switch (paramtype) {
+    case TRICK_07_DOUBLE: return TrickValueDouble;
+    case TRICK_07_UNSIGNED_LONG_LONG: return TrickValueULongLong;
+    case TRICK_07_LONG_LONG: return TrickValueLongLong;
+    case TRICK_07_FLOAT: return TrickValueFloat;
+    case TRICK_07_INTEGER:
+    case TRICK_07_ENUMERATED:
+    case TRICK_07_UNSIGNED_BITFIELD:
+    case TRICK_07_BITFIELD: return TrickValueInt;
+    case TRICK_07_UNSIGNED_CHARACTER: return TrickValueUChar;
+    case TRICK_07_SHORT: return TrickValueShort;
+    case TRICK_07_UNSIGNED_SHORT: return TrickValueUShort;
+    case TRICK_07_UNSIGNED_INTEGER: return TrickValueUInt;
+    case TRICK_07_LONG: return TrickValueLong;
+    case TRICK_07_BOOLEAN: return TrickValueBool;
+    default: return TrickValueUnhandled;
+    }
+}
+
+static TrickValueType _trick10ValueType(int paramtype)
+{
+    switch (paramtype) {
+    case TRICK_10_DOUBLE: return TrickValueDouble;
+    case TRICK_10_UNSIGNED_LONG_LONG: return TrickValueULongLong;
+    case TRICK_10_LONG_LONG: return TrickValueLongLong;
+    case TRICK_10_FLOAT: return TrickValueFloat;
+    case TRICK_10_INTEGER:
+    case TRICK_10_ENUMERATED:
+    case TRICK_10_UNSIGNED_BITFIELD:
+    case TRICK_10_BITFIELD: return TrickValueInt;
+    case TRICK_10_UNSIGNED_CHARACTER: return TrickValueUChar;
+    case TRICK_10_SHORT: return TrickValueShort;
+    case TRICK_10_UNSIGNED_SHORT: return TrickValueUShort;
+    case TRICK_10_UNSIGNED_INTEGER: return TrickValueUInt;
+    case TRICK_10_LONG: return TrickValueLong;
+    case TRICK_10_BOOLEAN: return TrickValueBool;
+    case TRICK_10_CHARACTER: return TrickValueChar;
+    default: return TrickValueUnhandled;
+    }
+}
+
+// Select value type and column kernel for each column from trick version
+// and param type.  Unhandled types get null kernels and error out only
+// if read.
+void TrickModel::_setDecoders()
+{
+    _valueTypes.assign(_ncols,TrickValueUnhandled);
+    _columnDecoders.assign(_ncols,(TrickColumnDecoder)0);
+
+    // Swap if data was logged on a host with the other byte order
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    _isSwap = ( _byteOrder == QDataStream::LittleEndian );
+#else
+    _isSwap = ( _byteOrder == QDataStream::BigEndian );
+#endif
+
+    for ( int cc = 0; cc < _ncols; ++cc ) {
+        int paramtype = _paramtypes.at(cc);
+        TrickValueType type = ( _trick_version == TrickVersion07 ) ?
+                              _trick07ValueType(paramtype) :
+                              _trick10ValueType(paramtype);
+        TrickColumnDecoder decoder = 0;
+        switch (type) {
+        case TrickValueDouble:
+            decoder = _columnDecoderOf<double>(_isSwap); break;
+        case TrickValueFloat:
+            decoder = _columnDecoderOf<float>(_isSwap); break;
+        case TrickValueLongLong:
+            decoder = _columnDecoderOf<long long>(_isSwap); break;
+        case TrickValueULongLong:
+            decoder = _columnDecoderOf<unsigned long long>(_isSwap); break;
+        case TrickValueLong:
+            decoder = _columnDecoderOf<long int>(_isSwap); break;
+        case TrickValueInt:
+            decoder = _columnDecoderOf<int>(_isSwap); break;
+        case TrickValueUInt:
+            decoder = _columnDecoderOf<unsigned int>(_isSwap); break;
+        case TrickValueShort:
+            decoder = _columnDecoderOf<short int>(_isSwap); break;
+        case TrickValueUShort:
+            decoder = _columnDecoderOf<unsigned short int>(_isSwap); break;
+        case TrickValueChar:
+            decoder = _columnDecoderOf<char>(_isSwap); break;
+        case TrickValueUChar:
+            decoder = _columnDecoderOf<unsigned char>(_isSwap); break;
+        case TrickValueBool:
+            decoder = _columnDecoderOf<bool>(_isSwap); break;
+        default:
+            break;
+        }
+        _valueTypes[cc] = type;
+        _columnDecoders[cc] = decoder;
+    }
+}
+
+TrickValueType TrickModel::_valueType(int col) const
+{
+    TrickValueType type = _valueTypes.at(col);
+    if ( type == TrickValueUnhandled ) {
+        _unhandledType(col);
+    }
+    return type;
+}
+
+TrickColumnDecoder TrickModel::_columnDecoder(int col) const
+{
+    TrickColumnDecoder decoder = _columnDecoders.at(col);
+    if ( !decoder ) {
+        _unhandledType(col);
+    }
+    return decoder;
+}
+
+void TrickModel::_unhandledType(int col) const
+{
+    if ( _trick_version == TrickVersion07 ) {
+        fprintf(stderr,
+                "koviz [error]: can't handle trick 07 type \"%d\"\n"
+                "              Look in trick_types.h for type.\n",
+                _paramtypes.at(col));
+    } else {
+        fprintf(stderr,
+                "koviz [error]: can't handle trick 10 type \"%d\"\n"
+                "              Look in trick_types.h for type.\n",
+                _paramtypes.at(col));
+    }
+    exit(-1);
+}
+
+int TrickModel::fetchColumn(int col, int beg, int cnt, double *buf) const
+{
+    cnt = _fetchCount(beg,cnt);
+    if ( cnt == 0 ) {
+        return 0;
+    }
+
+    QVector<double> column = _column(col);
+    if ( !column.isEmpty() ) {
+        memcpy(buf,column.constData()+beg,cnt*sizeof(double));
+    } else {
+        ptrdiff_t addr = _data + beg*_row_size + _col2offset.value(col);
+        _columnDecoder(col)(addr,_row_size,cnt,buf);
+    }
+
+    return cnt;
 }
 
-int TrickModel::indexAtTime(double time)
+// Rows of a trk file are contiguous, so a block of rows is decoded from
+// the mapping instead of caching every column (an export of a wide file
+// would otherwise decode each column whole and evict the rest)
+int TrickModel::fetchRows(int beg, int cnt,
+                          const QVector<int>& cols, double** bufs) const
 {
-    return _idxAtTimeBinarySearch(_iteratorTimeIndex,0,rowCount()-1,time);
+    cnt = _fetchCount(beg,cnt);
+    if ( cnt == 0 || !_data ) {
+        return DataModel::fetchRows(beg,cnt,cols,bufs);
+    }
+
+    ptrdiff_t row = _data + beg*_row_size;
+    for ( int i = 0; i < cols.size(); ++i ) {
+        int col = cols.at(i);
+        ptrdiff_t addr = row + _col2offset.value(col);
+        _columnDecoder(col)(addr,_row_size,cnt,bufs[i]);
+    }
+
+    return cnt;
+}
+
+// Returns column as a column-major array of doubles from the column cache.
+// A trk file is row-major, so reading a single column from the mapping
+// touches every page of the file.  The first read decodes the column into
+// the cache so reads after that are a scan of a compact array.
+// Returns an empty vector if the column can't be cached (too big for
+// the cache budget, or not cached and unmapped).
+QVector<double> TrickModel::_column(int col) const
+{
+    QVector<double> column;
+
+    ColumnCache* cache = ColumnCache::instance();
+    if ( cache->find(this,col,&column) ) {
+        return column;
+    }
+
+    qint64 nbytes = _nrows*(qint64)sizeof(double);
+    if ( !_data || _nrows == 0 || nbytes > cache->budget() ) {
+        return column;
+    }
+
+    column.resize(_nrows);
+    ptrdiff_t addr = _data + _col2offset.value(col);
+    _columnDecoder(col)(addr,_row_size,_nrows,column.data());
+    if ( !cache->insert(this,col,column) ) {
+        column.clear();
+    }
+
+    return column;
+}
+
+// Iterators only use a column that is already decoded, an iterator made
+// for a single at(k) shouldn't decode whole columns
+QVector<double> TrickModel::_cachedColumn(int col) const
+{
+    QVector<double> column;
+    ColumnCache::instance()->find(this,col,&column);
+    return column;
+}
+
+QVector<double> TrickModel::column(int col) const
+{
+    return _column(col);
+}
+
+const Parameter* TrickModel::param(int col) const
+{
+    return _col2param.value(col);
 }
 
 void TrickModel::writeTrkHeader(QDataStream &out,
@@ -256,28 +585,6 @@ void TrickModel::_write_binary_qstring(QDataStream& out, const QString &str)
     out.writeRawData(str.toLatin1().constData(),str.size());
 }
 
-int TrickModel::_idxAtTimeBinarySearch (TrickModelIterator* it,
-                                       int low, int high, double time)
-{
-        if (high <= 0 ) {
-                return 0;
-        }
-        if (low >= high) {
-                return ( it->at(high)->t() > time ) ? high-1 : high;
-        } else {
-                int mid = (low + high)/2;
-                if (time == it->at(mid)->t()) {
-                        return mid;
-                } else if ( time < it->at(mid)->t() ) {
-                        return _idxAtTimeBinarySearch(it,
-                                                      low, mid-1, time);
-                } else {
-                        return _idxAtTimeBinarySearch(it,
-                                                      mid+1, high, time);
-                }
-        }
-}
-
 int TrickModel::rowCount(const QModelIndex &pidx) const
 {
     if ( ! pidx.isValid() ) {
@@ -297,9 +604,6 @@ int TrickModel::columnCount(const QModelIndex &pidx) const
 }
 
 
-// TODO: byteswap like
-//      dp = (double *)(address) ;
-//      value = _swap ? trick_byteswap_double(*dp) : *dp ;
 QVariant TrickModel::data(const QModelIndex &idx, int role) const
 {
     QVariant val;
@@ -311,8 +615,7 @@ QVariant TrickModel::data(const QModelIndex &idx, int role) const
         if ( role == Qt::DisplayRole ) {
             qint64 _pos_data = row*_row_size + _col2offset.value(col);
             ptrdiff_t addr = _data+_pos_data;
-            int paramtype =  _paramtypes.at(col);
-            val = _toDouble(addr,paramtype);
+            val = trickValue(_valueType(col),_isSwap,addr);
         }
     }
 
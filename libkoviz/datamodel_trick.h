@@ -16,16 +16,75 @@
 #include <QAbstractTableModel>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 #include <vector>
 
 #include "datamodel.h"
 #include "snaptable.h"
 #include "trick_types.h"
 #include "parameter.h"
+#include "columncache.h"
+#include "byteswap.h"
 using namespace std;
 
 class TrickModel;
 class TrickModelIterator;
+class TrkCatalogEntry;
+
+// C type of a column's values (selected once from trick version & type)
+enum TrickValueType
+{
+    TrickValueUnhandled,
+    TrickValueDouble,
+    TrickValueFloat,
+    TrickValueLongLong,
+    TrickValueULongLong,
+    TrickValueLong,
+    TrickValueInt,
+    TrickValueUInt,
+    TrickValueShort,
+    TrickValueUShort,
+    TrickValueChar,
+    TrickValueUChar,
+    TrickValueBool
+};
+
+template <typename T>
+inline double trickValue(ptrdiff_t addr, bool isSwap)
+{
+    T v;
+    memcpy(&v,(const void*)addr,sizeof(T));
+    if ( isSwap && sizeof(T) > 1 ) {
+        ByteSwap::swapBlock(&v,sizeof(T),1);
+    }
+    return (double) v;
+}
+
+// Decodes the value at addr to a double (0.0 if type is unhandled)
+inline double trickValue(TrickValueType type, bool isSwap, ptrdiff_t addr)
+{
+    switch (type) {
+    case TrickValueDouble:    return trickValue<double>(addr,isSwap);
+    case TrickValueFloat:     return trickValue<float>(addr,isSwap);
+    case TrickValueLongLong:  return trickValue<long long>(addr,isSwap);
+    case TrickValueULongLong: return trickValue<unsigned long long>(addr,
+                                                                  isSwap);
+    case TrickValueLong:      return trickValue<long int>(addr,isSwap);
+    case TrickValueInt:       return trickValue<int>(addr,isSwap);
+    case TrickValueUInt:      return trickValue<unsigned int>(addr,isSwap);
+    case TrickValueShort:     return trickValue<short int>(addr,isSwap);
+    case TrickValueUShort:    return trickValue<unsigned short int>(addr,
+                                                                  isSwap);
+    case TrickValueChar:      return trickValue<char>(addr,isSwap);
+    case TrickValueUChar:     return trickValue<unsigned char>(addr,isSwap);
+    case TrickValueBool:      return trickValue<bool>(addr,isSwap);
+    default:                  return 0.0;
+    }
+}
+
+// Decodes cnt values, stride bytes apart, starting at addr into buf
+typedef void (*TrickColumnDecoder)(ptrdiff_t addr, qint64 stride,
+                                   int cnt, double* buf);
 
 class TrickParameter : public Parameter
 {
@@ -73,20 +132,28 @@ class TrickModel : public DataModel
     explicit TrickModel(const QStringList &timeNames,
                         const QString &trkfile,
                        QObject *parent = 0);
+    // Model made from a cataloged header (the trk file is not read)
+    explicit TrickModel(const QStringList &timeNames,
+                        const QString &trkfile,
+                        const TrkCatalogEntry& entry,
+                        QObject *parent = 0);
     ~TrickModel();
 
     QString trkFile() const { return _trkfile; }
+    TrkCatalogEntry catalogEntry() const;
 
     virtual const Parameter* param(int col) const ;
 
-    virtual void map();
-    virtual void unmap();
     virtual int paramColumn(const QString& param) const
     {
         return _param2column.value(param,-1);
     }
     virtual ModelIterator* begin(int tcol, int xcol, int ycol) const ;
-    int indexAtTime(double time);
+    virtual int timeCol() const { return _timeCol; }
+    virtual int fetchColumn(int col, int beg, int cnt, double* buf) const;
+    virtual int fetchRows(int beg, int cnt,
+                          const QVector<int>& cols, double** bufs) const;
+    virtual QVector<double> column(int col) const;
 
     static void writeTrkHeader(QDataStream &out, const QList<TrickParameter> &params);
 
@@ -95,6 +162,11 @@ class TrickModel : public DataModel
     virtual QVariant data (const QModelIndex & index,
                            int role = Qt::DisplayRole ) const;
 
+  protected:
+
+    virtual void _map();
+    virtual void _unmap();
+
   private:
 
     QStringList _timeNames;
@@ -103,6 +175,7 @@ class TrickModel : public DataModel
     QHash<int,TrickParameter*> _col2param;   // ordered by column
 
     TrickVersion _trick_version;
+    QDataStream::ByteOrder _byteOrder;
     vector<int> _paramtypes;
     QHash<QString,int> _param2column;
 
@@ -119,152 +192,25 @@ class TrickModel : public DataModel
     struct stat _fstat;
     QFile _file;
 
-    TrickModelIterator* _iteratorTimeIndex;
-
-    static QString _err_string;
-    static QTextStream _err_stream;
+    // Value types and column decode kernels by column
+    bool _isSwap;  // data logged with the other byte order
+    vector<TrickValueType> _valueTypes;
+    vector<TrickColumnDecoder> _columnDecoders;
 
     bool _load_trick_header();
+    void _load_catalog_entry(const TrkCatalogEntry& entry);
+    void _setTimeCol();
+    void _setDecoders();
+    QVector<double> _column(int col) const;
+    QVector<double> _cachedColumn(int col) const;
+    TrickValueType _valueType(int col) const;
+    TrickColumnDecoder _columnDecoder(int col) const;
+    void _unhandledType(int col) const;
     qint32 _load_binary_param(QDataStream& in, int col);
-    int _idxAtTimeBinarySearch (TrickModelIterator *it,
-                               int low, int high, double time);
 
     static void _write_binary_param(QDataStream& out, const TrickParameter &p);
     static void _write_binary_qstring(QDataStream& out, const QString& str);
 
-  private:
-
-    inline double _toDouble(ptrdiff_t addr, int paramtype) const
-    {
-        if ( _trick_version == TrickVersion07 ) {
-            switch (paramtype) {
-            case TRICK_07_DOUBLE:
-            {
-                return *((double*)(addr));
-            }
-            case TRICK_07_UNSIGNED_LONG_LONG:
-            {
-                return (double) *((unsigned long long*)(addr));
-            }
-            case TRICK_07_LONG_LONG:
-            {
-                return (double) *((long long*)(addr));
-            }
-            case TRICK_07_FLOAT:
-            {
-                return (double) *((float*)(addr));
-            }
-            case TRICK_07_INTEGER:
-            case TRICK_07_ENUMERATED:
-            case TRICK_07_UNSIGNED_BITFIELD:
-            {
-                return (double) *((int*)(addr));
-            }
-            case TRICK_07_UNSIGNED_CHARACTER:
-            {
-                return (double) *((unsigned char*)(addr));
-            }
-            case TRICK_07_SHORT:
-            {
-                return (double) *((short int*)(addr));
-            }
-            case TRICK_07_UNSIGNED_SHORT:
-            {
-                return (double) *((unsigned short int*)(addr));
-            }
-            case TRICK_07_UNSIGNED_INTEGER:
-            {
-                return (double) *((unsigned int*)(addr));
-            }
-            case TRICK_07_LONG:
-            {
-                return (double) *((long int*)(addr));
-            }
-            case TRICK_07_BOOLEAN:
-            {
-                return (double) *((bool *)(addr));
-            }
-            case TRICK_07_BITFIELD:
-            {
-                return (double) *((int *)(addr));
-            }
-            default:
-            {
-                fprintf(stderr,
-                        "koviz [error]: can't handle trick 07 type \"%d\"\n"
-                        "              Look in trick_types.h for type.\n",
-                        paramtype);
-                exit(-1);
-            }
-            }
-        } else {
-            switch (paramtype) {
-            case TRICK_10_DOUBLE:
-            {
-                return *((double*)(addr));
-            }
-            case TRICK_10_UNSIGNED_LONG_LONG:
-            {
-                return (double) *((unsigned long long*)(addr));
-            }
-            case TRICK_10_LONG_LONG:
-            {
-                return (double) *((long long*)(addr));
-            }
-            case TRICK_10_FLOAT:
-            {
-                return (double) *((float*)(addr));
-            }
-            case TRICK_10_INTEGER:
-            case TRICK_10_ENUMERATED:
-            case TRICK_10_UNSIGNED_BITFIELD:
-            {
-                return (double) *((int*)(addr));
-            }
-            case TRICK_10_UNSIGNED_CHARACTER:
-            {
-                return (double) *((unsigned char*)(addr));
-            }
-            case TRICK_10_SHORT:
-            {
-                return (double) *((short int*)(addr));
-            }
-            case TRICK_10_UNSIGNED_SHORT:
-            {
-                return (double) *((unsigned short int*)(addr));
-            }
-            case TRICK_10_UNSIGNED_INTEGER:
-            {
-                return (double) *((unsigned int*)(addr));
-            }
-            case TRICK_10_LONG:
-            {
-                return (double) *((long int*)(addr));
-            }
-            case TRICK_10_BOOLEAN:
-            {
-                return (double) *((bool *)(addr));
-            }
-            case TRICK_10_BITFIELD:
-            {
-                return (double) *((int *)(addr));
-            }
-            case TRICK_10_CHARACTER:
-            {
-                return (double) *((char *)(addr));
-            }
-            default:
-            {
-                fprintf(stderr,
-                        "koviz [error]: can't handle trick 10 type \"%d\"\n"
-                        "              Look in trick_types.h for type\n.",
-                        paramtype);
-                exit(-1);
-            }
-            }
-        }
-    }
-
 signals:
     
 public slots:
@@ -291,9 +237,16 @@ class TrickModelIterator : public ModelIterator
         _tco(_model->_col2offset.value(tcol)),
         _xco(_model->_col2offset.value(xcol)),
         _yco(_model->_col2offset.value(ycol)),
-        _ttype(_model->_paramtypes.at(tcol)),
-        _xtype(_model->_paramtypes.at(xcol)),
-        _ytype(_model->_paramtypes.at(ycol))
+        _isSwap(model->_isSwap),
+        _ttype(_model->_valueTypes.at(tcol)),
+        _xtype(_model->_valueTypes.at(xcol)),
+        _ytype(_model->_valueTypes.at(ycol)),
+        _tcolumn(_model->_cachedColumn(tcol)),
+        _xcolumn(_model->_cachedColumn(xcol)),
+        _ycolumn(_model->_cachedColumn(ycol)),
+        _tc(_tcolumn.isEmpty() ? 0 : _tcolumn.constData()),
+        _xc(_xcolumn.isEmpty() ? 0 : _xcolumn.constData()),
+        _yc(_ycolumn.isEmpty() ? 0 : _ycolumn.constData())
     {
     }
 
@@ -323,17 +276,17 @@ class TrickModelIterator : public ModelIterator
 
     inline double t() const
     {
-        return _model->_toDouble(_data+i*_row_size+_tco,_ttype);
+        return _tc ? _tc[i] : _value(_tcol,_ttype,_tco);
     }
 
     inline double x() const
     {
-        return _model->_toDouble(_data+i*_row_size+_xco,_xtype);
+        return _xc ? _xc[i] : _value(_xcol,_xtype,_xco);
     }
 
     inline double y() const
     {
-        return _model->_toDouble(_data+i*_row_size+_yco,_ytype);
+        return _yc ? _yc[i] : _value(_ycol,_ytype,_yco);
     }
 
   private:
@@ -349,9 +302,28 @@ class TrickModelIterator : public ModelIterator
     qint64 _tco ;
     qint64 _xco ;
     qint64 _yco ;
-    int _ttype ;
-    int _xtype ;
-    int _ytype ;
+    bool _isSwap ;
+    TrickValueType _ttype ;
+    TrickValueType _xtype ;
+    TrickValueType _ytype ;
+
+    // Column cache copies (empty if not cached, then read from mapping)
+    QVector<double> _tcolumn ;
+    QVector<double> _xcolumn ;
+    QVector<double> _ycolumn ;
+    const double* _tc ;
+    const double* _xc ;
+    const double* _yc ;
+
+    // Reads the value from the mapping (an unhandled type errors out only
+    // if its column is read)
+    inline double _value(int col, TrickValueType type, qint64 co) const
+    {
+        if ( type == TrickValueUnhandled ) {
+            _model->_unhandledType(col);
+        }
+        return trickValue(type,_isSwap,_data+i*_row_size+co);
+    }
 };
 
 
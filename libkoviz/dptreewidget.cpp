@@ -331,9 +331,11 @@ void DPTreeWidget::_createDPPages(const QString& dpfile)
             _addChild(plotItem, "PlotXMaxRange",  plot->xMaxRange());
             _addChild(plotItem, "PlotYMinRange",  plot->yMinRange());
             _addChild(plotItem, "PlotYMaxRange",  plot->yMaxRange());
-            if ( rc == 2 && plot->curves().size() == 1 ) {
-                QString presentation = _bookModel->getDataString(QModelIndex(),
-                                                               "Presentation");
+            QString presentation = _bookModel->getDataString(QModelIndex(),
+                                                             "Presentation");
+            bool isBaseline = _bookModel->isBaselinePresentation(presentation);
+            if ( plot->curves().size() == 1 &&
+                 (rc == 2 || (rc > 2 && isBaseline)) ) {
                 _addChild(plotItem, "PlotPresentation", presentation);
             } else {
                 _addChild(plotItem, "PlotPresentation", "compare");
@@ -63,12 +63,12 @@ inline void Job::_do_stats()
     long sum_squares = 0 ;
     long sum_rt = 0 ;
     long max_rt = 0 ;
-    ModelIterator* it = _curve->begin();
+    CurveCursor it(_curve,false);
     int cnt = 0;
-    while ( !it->isDone() ) {
+    while ( !it.isDone() ) {
 
-        double time = it->t();
-        long rt = (long)it->y();
+        double time = it.t();
+        long rt = (long)it.y();
 
         if ( rt < 0 ) {
             rt =  0.0;
@@ -95,9 +95,8 @@ inline void Job::_do_stats()
         sum_rt += rt;
 
         ++cnt;
-        it->next();
+        it.next();
     }
-    delete it;
 
     double ss = (double)sum_squares;
     double s = (double)sum_rt;
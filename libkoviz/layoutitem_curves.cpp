@@ -64,9 +64,12 @@ void CurvesLayoutItem::paint(QPainter *painter,
     int nCurves = _bookModel->rowCount(curvesIdx);
 
     // Print!
-    if ( nCurves == 2 ) {
-        QString plotPresentation = _bookModel->getDataString(_plotIdx,
+    QString plotPresentation = _bookModel->getDataString(_plotIdx,
                                                      "PlotPresentation","Plot");
+    if ( nCurves >= 2 &&
+         _bookModel->isBaselinePresentation(plotPresentation) ) {
+        _printBaselineErrorplot(T,painter,_plotIdx,plotPresentation);
+    } else if ( nCurves == 2 ) {
         if ( plotPresentation == "compare" ) {
             _printCoplot(R,T,painter,_plotIdx);
         } else if (plotPresentation == "error" || plotPresentation.isEmpty()) {
@@ -85,8 +88,8 @@ void CurvesLayoutItem::paint(QPainter *painter,
         int nElements = 0;
         for ( int i = 0; i < nCurves; ++i ) {
             QModelIndex curveIdx = _bookModel->index(i,0,curvesIdx);
-            QPainterPath* path = _bookModel->getPainterPath(curveIdx);
-            nElements += path->elementCount();
+            CurvePath* path = _bookModel->getCurvePath(curveIdx);
+            nElements += path->count();
         }
 
         if ( nElements > 100000 || nCurves > 64 ) {
@@ -118,7 +121,7 @@ void CurvesLayoutItem::paint(QPainter *painter,
 
             for ( int i = 0; i < nCurves; ++i ) {
                 QModelIndex curveIdx = _bookModel->index(i,0,curvesIdx);
-                QPainterPath* path =_bookModel->getPainterPath(curveIdx);
+                CurvePath* path =_bookModel->getCurvePath(curveIdx);
                 if ( path ) {
                     // Line color
                     QColor color(_bookModel->getDataString(curveIdx,
@@ -159,9 +162,8 @@ void CurvesLayoutItem::paint(QPainter *painter,
                         }
                         pixmapPainter.setPen(pen);
                         QPointF pLast;
-                        for ( int i = 0; i < path->elementCount(); ++i ) {
-                            QPainterPath::Element el = path->elementAt(i);
-                            QPointF p(el.x,el.y);
+                        for ( int i = 0; i < path->count(); ++i ) {
+                            QPointF p = path->at(i);
                             p = Tscaled.map(p);
                             if  ( i > 0 ) {
                                 pixmapPainter.drawLine(pLast,p);
@@ -182,9 +184,8 @@ void CurvesLayoutItem::paint(QPainter *painter,
                         brush.setColor(color);
                         pixmapPainter.setBrush(brush);
                         double r = pen.widthF();
-                        for ( int i = 0; i < path->elementCount(); ++i ) {
-                            QPainterPath::Element el = path->elementAt(i);
-                            QPointF p(el.x,el.y);
+                        for ( int i = 0; i < path->count(); ++i ) {
+                            QPointF p = path->at(i);
                             p = Tscaled.map(p);
                             pixmapPainter.drawEllipse(p,r,r);
                         }
@@ -193,7 +194,7 @@ void CurvesLayoutItem::paint(QPainter *painter,
                         pixmapPainter.setBrush(origBrush);
                         pixmapPainter.setTransform(Tscaled);
                     } else {
-                        pixmapPainter.drawPath(*path);
+                        pixmapPainter.drawPolyline(path->constData(),path->count());
                     }
                 }
             }
@@ -250,18 +251,18 @@ void CurvesLayoutItem::_printCoplot(const QRect& R, const QTransform& T,
             paths << path;
 
             curveModel->map();
-            ModelIterator* it = curveModel->begin();
 
             bool isFirst = true;
-            while ( !it->isDone() ) {
+            CurveCursor it(curveModel);
+            while ( !it.isDone() ) {
 
-                if ( it->t() < start || it->t() > stop ) {
-                    it->next();
+                if ( it.t() < start || it.t() > stop ) {
+                    it.next();
                     continue;
                 }
 
-                double x = it->x()*xs+xb;
-                double y = it->y()*ys+yb;
+                double x = it.x()*xs+xb;
+                double y = it.y()*ys+yb;
                 if ( isXLogScale ) x = log10(x);
                 if ( isYLogScale ) y = log10(y);
                 QPointF p(x,y);
@@ -274,16 +275,15 @@ void CurvesLayoutItem::_printCoplot(const QRect& R, const QTransform& T,
                     path->lineTo(p);
                 }
 
-                it->next();
+                it.next();
             }
-            delete it;
 
             // If curve is flat (constant), label with "Flatline=#"
             QRectF curveBBox = path->boundingRect();
             if ( curveBBox.height() == 0.0 ) {
-                it = curveModel->begin();
-                double y = it->y()*ys+yb;  // y is constant, so use first point
-                delete it;
+                double y0 = 0.0;
+                curveModel->fetch(0,1,0,0,&y0);
+                double y = y0*ys+yb;  // y is constant, so use first point
                 QString s;
                 s = s.sprintf("%.9g",y);
                 QVariant v(s);
@@ -591,31 +591,29 @@ void CurvesLayoutItem::_printErrorplot(const QRect& R,
     double ys1 = (k1/k0)*_bookModel->yScale(curveIdx1);
     c0->map();
     c1->map();
-    ModelIterator* i0 = c0->begin();
-    ModelIterator* i1 = c1->begin();
-    while ( !i0->isDone() && !i1->isDone() ) {
-        double t0 = i0->t();
-        double t1 = i1->t();
+    CurveCursor i0(c0,false);
+    CurveCursor i1(c1,false);
+    while ( !i0.isDone() && !i1.isDone() ) {
+        double t0 = i0.t();
+        double t1 = i1.t();
         if ( qAbs(t1-t0) < tolerance ) {
             if ( t0 >= start && t0 <= stop ) {
-                double d = ys0*i0->y() - ys1*i1->y();
+                double d = ys0*i0.y() - ys1*i1.y();
                 pts << QPointF(t0,d);
             }
-            i0->next();
-            i1->next();
+            i0.next();
+            i1.next();
         } else {
             if ( t0 < t1 ) {
-                i0->next();
+                i0.next();
             } else if ( t1 < t0 ) {
-                i1->next();
+                i1.next();
             } else {
                 fprintf(stderr,"koviz [bad scoobs]:2: _printErrorplot()\n");
                 exit(-1);
             }
         }
     }
-    delete i0;
-    delete i1;
     c0->unmap();
     c1->unmap();
 
@@ -669,6 +667,63 @@ void CurvesLayoutItem::_printErrorplot(const QRect& R,
     painter->restore();
 }
 
+// Errors of all runs against the baseline run (or their envelope)
+// from the book's error paths
+void CurvesLayoutItem::_printBaselineErrorplot(const QTransform& T,
+                                               QPainter *painter,
+                                               const QModelIndex &plotIdx,
+                                               const QString& presentation)
+{
+    QModelIndex curvesIdx = _bookModel->getIndex(plotIdx,"Curves","Plot");
+
+    QList<CurvePath*> paths;
+    QList<QColor> colors;
+    if ( presentation == "baseline_envelope" ) {
+        paths = _bookModel->getCurvesBaselineErrorEnvelope(curvesIdx);
+        for ( int i = 0; i < paths.size(); ++i ) {
+            colors << _bookModel->errorLineColor();
+        }
+    } else {
+        QList<CurvePath*> errorPaths =
+                          _bookModel->getCurvesBaselineErrorPaths(curvesIdx);
+        for ( int i = 0; i < errorPaths.size(); ++i ) {
+            if ( errorPaths.at(i) ) {
+                QModelIndex curveIdx = _bookModel->index(i,0,curvesIdx);
+                paths << errorPaths.at(i);
+                colors << QColor(_bookModel->getDataString(curveIdx,
+                                                     "CurveColor","Curve"));
+            }
+        }
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+
+    QPen pen = painter->pen();
+    double xHeight = painter->fontMetrics().xHeight();
+    if ( paths.size() > 20 ) {
+        pen.setWidthF(xHeight/11.0);// smaller point size if many curves
+    } else {
+        pen.setWidthF(xHeight/5.0);
+    }
+    if (pen.widthF() < 1.0 ) {
+        pen.setWidthF(0.0); // cosmetic
+    }
+
+    for ( int i = 0; i < paths.size(); ++i ) {
+        CurvePath* path = paths.at(i);
+        QPolygonF pts(path->count());
+        for ( int j = 0; j < path->count(); ++j ) {
+            pts[j] = T.map(path->at(j));
+        }
+        pen.setColor(colors.at(i));
+        painter->setPen(pen);
+        painter->drawPolyline(pts);  // print!
+    }
+
+    painter->restore();
+}
+
 void CurvesLayoutItem::_paintGrid(QPainter* painter,
                                   const QRect &R,const QRect &RG,
                                   const QRect &C, const QRectF &M)
@@ -771,7 +826,7 @@ void CurvesLayoutItem::_paintCurvesLegend(const QRect& R,
 
     QString pres = _bookModel->getDataString(curvesIdx.parent(),
                                              "PlotPresentation","Plot");
-    if ( pres == "error" ) {
+    if ( pres == "error" || pres == "baseline_envelope" ) {
         return;
     }
 
@@ -34,6 +34,9 @@ private:
                       QPainter *painter, const QModelIndex &plotIdx);
     void _printErrorplot(const QRect& R, const QTransform& T,
                       QPainter *painter, const QModelIndex &plotIdx);
+    void _printBaselineErrorplot(const QTransform& T, QPainter *painter,
+                                 const QModelIndex &plotIdx,
+                                 const QString& presentation);
     void __paintSymbol(const QPointF &p,
                        const QString &symbol, QPainter* painter);
     void _paintGrid(QPainter* painter,
@@ -397,7 +397,7 @@ void PageTitleLayoutItem::_paintPageLegend(const QRect &R,
     QModelIndex plotIdx = curvesIdx.parent();
     QString pres = _bookModel->getDataString(plotIdx,
                                              "PlotPresentation","Plot");
-    if ( pres == "error" ) {
+    if ( pres == "error" || pres == "baseline_envelope" ) {
         return;
     }
 
@@ -61,6 +61,11 @@ SOURCES += bookmodel.cpp \
            unit.cpp \
            versionnumber.cpp \
            csv.cpp \
+           csvwriter.cpp \
+           byteswap.cpp \
+           csvtotrk.cpp \
+           trkwriter.cpp \
+           rowgather.cpp \
            monte.cpp \
            parameter.cpp \
            runs.cpp \
@@ -93,7 +98,13 @@ SOURCES += bookmodel.cpp \
            layoutitem_paintable.cpp \
            mapvalue.cpp \
            curvemodelparameter.cpp \
-           datamodel_mot.cpp
+           datamodel_mot.cpp \
+           trkcatalog.cpp \
+           columncache.cpp \
+           numparse.cpp \
+           timeindex.cpp \
+           curvelod.cpp \
+           curvepath.cpp
 
 HEADERS  += bookmodel.h \
             bookidxview.h \
@@ -126,6 +137,10 @@ HEADERS  += bookmodel.h \
             unit.h \
             versionnumber.h \
             csv.h \
+            csvwriter.h \
+            csvtotrk.h \
+            trkwriter.h \
+            rowgather.h \
             monte.h \
             numsortitem.h \
             parameter.h \
@@ -162,7 +177,14 @@ HEADERS  += bookmodel.h \
             layoutitem_paintable.h \
             mapvalue.h \
             curvemodelparameter.h \
-            datamodel_mot.h
+            datamodel_mot.h \
+            trkcatalog.h \
+            columncache.h \
+            numparse.h \
+            byteswap.h \
+            timeindex.h \
+            curvelod.h \
+            curvepath.h
 
 FLEXSOURCES = product_lexer.l
 BISONSOURCES = product_parser.y
@@ -0,0 +1,124 @@
+#include "numparse.h"
+
+const double NumParse::_pow10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool _isBlank(char c)
+{
+    return ( c == ' ' || c == '\t' || c == '\r' || c == '\n' );
+}
+
+double NumParse::toDouble(const char *beg, const char *end, bool *ok)
+{
+    const char* p = beg;
+    while ( p < end && _isBlank(*p) ) ++p;
+    while ( end > p && _isBlank(*(end-1)) ) --end;
+
+    bool isNeg = false;
+    if ( p < end && (*p == '-' || *p == '+') ) {
+        isNeg = ( *p == '-' );
+        ++p;
+    }
+
+    uint64_t mant = 0;
+    int nDigits = 0;        // significant digits in mant
+    int exp10 = 0;
+    bool isDigits = false;
+    bool isTruncated = false;
+
+    while ( p < end && *p >= '0' && *p <= '9' ) {
+        isDigits = true;
+        if ( nDigits < 19 ) {
+            mant = mant*10 + (*p-'0');
+            if ( mant ) ++nDigits;
+        } else {
+            ++exp10;
+            isTruncated = true;
+        }
+        ++p;
+    }
+    if ( p < end && *p == '.' ) {
+        ++p;
+        while ( p < end && *p >= '0' && *p <= '9' ) {
+            isDigits = true;
+            if ( nDigits < 19 ) {
+                mant = mant*10 + (*p-'0');
+                if ( mant ) ++nDigits;
+                --exp10;
+            } else {
+                isTruncated = true;
+            }
+            ++p;
+        }
+    }
+    if ( isDigits && p < end && (*p == 'e' || *p == 'E') ) {
+        ++p;
+        bool isNegExp = false;
+        if ( p < end && (*p == '-' || *p == '+') ) {
+            isNegExp = ( *p == '-' );
+            ++p;
+        }
+        if ( p == end || *p < '0' || *p > '9' ) {
+            return _fallback(beg,end,ok);
+        }
+        int e = 0;
+        while ( p < end && *p >= '0' && *p <= '9' ) {
+            if ( e < 100000 ) {
+                e = e*10 + (*p-'0');
+            }
+            ++p;
+        }
+        exp10 += isNegExp ? -e : e;
+    }
+
+    if ( !isDigits || p != end ) {
+        return _fallback(beg,end,ok);
+    }
+
+    if ( isTruncated || mant > (1ULL << 53) || exp10 < -22 || exp10 > 22 ) {
+        return _fallback(beg,end,ok);
+    }
+
+    double val = (double) mant;
+    if ( exp10 < 0 ) {
+        val /= _pow10[-exp10];
+    } else {
+        val *= _pow10[exp10];
+    }
+
+    if ( ok ) *ok = true;
+
+    return isNeg ? -val : val;
+}
+
+double NumParse::_fallback(const char *beg, const char *end, bool *ok)
+{
+    QByteArray s(beg,(int)(end-beg));
+    return s.trimmed().toDouble(ok);
+}
+
+double NumParse::hmsToDouble(const char *beg, const char *end, bool *ok)
+{
+    const char* c1 = beg;
+    while ( c1 < end && *c1 != ':' ) ++c1;
+    const char* c2 = ( c1 < end ) ? c1+1 : end;
+    while ( c2 < end && *c2 != ':' ) ++c2;
+    if ( c1 >= end || c2 >= end ) {
+        if ( ok ) *ok = false;
+        return 0.0;
+    }
+
+    bool isOk = false;
+    double val = 3600.0*toDouble(beg,c1,&isOk);
+    if ( isOk ) {
+        val += 60.0*toDouble(c1+1,c2,&isOk);
+        if ( isOk ) {
+            val += toDouble(c2+1,end,&isOk);
+        }
+    }
+    if ( ok ) *ok = isOk;
+
+    return val;
+}
@@ -0,0 +1,30 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <QByteArray>
+#include <stdint.h>
+
+//
+// Locale free text to double conversion for data files (csv etc.)
+//
+// Decimal numbers with at most 19 significant digits and a power of ten
+// exponent within +/-22 convert exactly with one multiply or divide
+// (Clinger's fast path).  Anything else (long mantissas, big exponents,
+// nan, inf) falls back to QByteArray::toDouble() which is also locale free.
+// Leading and trailing blanks are allowed as with QString::toDouble().
+//
+class NumParse
+{
+  public:
+    static double toDouble(const char* beg, const char* end, bool* ok);
+
+    // Converts hh:mm:ss[.sss] to seconds
+    static double hmsToDouble(const char* beg, const char* end, bool* ok);
+
+  private:
+    NumParse() {}
+    static const double _pow10[23];
+    static double _fallback(const char* beg, const char* end, bool* ok);
+};
+
+#endif // NUMPARSE_H
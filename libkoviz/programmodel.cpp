@@ -11,7 +11,7 @@ ProgramModel::ProgramModel(const QList<CurveModel *> &inputCurves,
                            QObject *parent) :
     DataModel(timeNames, programfile, parent),
     _timeNames(timeNames),_programfile(programfile),
-    _nrows(0), _ncols(0),_iteratorTimeIndex(0),
+    _nrows(0), _ncols(0),
     _data(0), _library(0)
 {
     _init(inputCurves,inputParams,outputNames);
@@ -85,37 +85,33 @@ void ProgramModel::_init(const QList<CurveModel*>& inputCurves,
 
     _ncols = col;
 
-    _iteratorTimeIndex = new ProgramModelIterator(0,this,
-                                                  _timeCol,_timeCol,_timeCol);
-
     // Get number of data rows in program file
     foreach ( CurveModel* curveModel, inputCurves ) {
         curveModel->map();
-        ModelIterator* it = curveModel->begin();
+        CurveCursor it(curveModel,false);
 
         int i = 0;
-        while ( !it->isDone() ) {
+        while ( !it.isDone() ) {
 
-            double t = it->t();
+            double t = it.t();
 
             if ( i >= _timeStamps.size() ) {
                 _timeStamps.append(t);
-                it->next();
+                it.next();
                 ++i;
                 continue;
             }
 
             double timeStamp = _timeStamps.at(i);
             if ( t == timeStamp ) {
-                it->next();
+                it.next();
             } else if ( t < timeStamp ) {
                 _timeStamps.insert(i,t);
-                it->next();
+                it.next();
             }
             ++i;
         }
 
-        delete it;
         curveModel->unmap();
     }
     _nrows = _timeStamps.size();
@@ -154,16 +150,16 @@ void ProgramModel::_init(const QList<CurveModel*>& inputCurves,
             bias = Unit::bias(curveModel->y()->unit(), inputParam.unit());
         }
         curveModel->map();
-        ModelIterator* it = curveModel->begin();
+        CurveCursor it(curveModel,false);
         row = 0;
-        while ( !it->isDone() ) {
+        while ( !it.isDone() ) {
 
             double timeStamp = _data[row*_ncols];
 
-            double t = it->t();
+            double t = it.t();
 
             if ( t == timeStamp ) {
-                input_data[row*nInputs+col] = it->y()*sf+bias;
+                input_data[row*nInputs+col] = it.y()*sf+bias;
             } else if ( timeStamp < t ) {
                 // Interpolate
             } else {
@@ -174,11 +170,10 @@ void ProgramModel::_init(const QList<CurveModel*>& inputCurves,
                 exit(-1);
             }
 
-            it->next();
+            it.next();
             ++row;
         }
 
-        delete it;
         curveModel->unmap();
         ++col;
     }
@@ -199,11 +194,11 @@ void ProgramModel::_init(const QList<CurveModel*>& inputCurves,
     free(input_data);
 }
 
-void ProgramModel::map()
+void ProgramModel::_map()
 {
 }
 
-void ProgramModel::unmap()
+void ProgramModel::_unmap()
 {
 }
 
@@ -226,11 +221,6 @@ ProgramModel::~ProgramModel()
         free(_data);
         _data = 0;
     }
-
-    if ( _iteratorTimeIndex ) {
-        delete _iteratorTimeIndex;
-        _iteratorTimeIndex = 0;
-    }
 }
 
 const Parameter* ProgramModel::param(int col) const
@@ -238,31 +228,15 @@ const Parameter* ProgramModel::param(int col) const
     return _col2param.value(col);
 }
 
-int ProgramModel::indexAtTime(double time)
-{
-    return _idxAtTimeBinarySearch(_iteratorTimeIndex,0,rowCount()-1,time);
-}
-
-int ProgramModel::_idxAtTimeBinarySearch (ProgramModelIterator* it,
-                                       int low, int high, double time)
+int ProgramModel::fetchColumn(int col, int beg, int cnt, double *buf) const
 {
-        if (high <= 0 ) {
-                return 0;
-        }
-        if (low >= high) {
-                return ( it->at(high)->t() > time ) ? high-1 : high;
-        } else {
-                int mid = (low + high)/2;
-                if (time == it->at(mid)->t()) {
-                        return mid;
-                } else if ( time < it->at(mid)->t() ) {
-                        return _idxAtTimeBinarySearch(it,
-                                                      low, mid-1, time);
-                } else {
-                        return _idxAtTimeBinarySearch(it,
-                                                      mid+1, high, time);
-                }
-        }
+    cnt = _fetchCount(beg,cnt);
+    const double* d = _data + (qint64)beg*_ncols + col;
+    for ( int i = 0; i < cnt; ++i ) {
+        buf[i] = *d;
+        d += _ncols;
+    }
+    return cnt;
 }
 
 int ProgramModel::rowCount(const QModelIndex &pidx) const
@@ -41,17 +41,21 @@ class ProgramModel : public DataModel
     ~ProgramModel();
 
     virtual const Parameter* param(int col) const ;
-    virtual void map();
-    virtual void unmap();
     virtual int paramColumn(const QString& paramName) const ;
     virtual ModelIterator* begin(int tcol, int xcol, int ycol) const ;
-    int indexAtTime(double time);
+    virtual int timeCol() const { return _timeCol; }
+    virtual int fetchColumn(int col, int beg, int cnt, double* buf) const;
 
     virtual int rowCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual int columnCount(const QModelIndex & pidx = QModelIndex() ) const;
     virtual QVariant data (const QModelIndex & index,
                            int role = Qt::DisplayRole ) const;
 
+  protected:
+
+    virtual void _map();
+    virtual void _unmap();
+
   private:
 
     QStringList _timeNames;
@@ -63,7 +67,6 @@ class ProgramModel : public DataModel
 
     QHash<int,Parameter*> _col2param;
     QHash<QString,int> _paramName2col;
-    ProgramModelIterator* _iteratorTimeIndex;
 
     QList<double> _timeStamps;
 
@@ -78,8 +81,6 @@ class ProgramModel : public DataModel
     void _init(const QList<CurveModel *> &inputCurves,
                const QList<Parameter> &inputParams,
                const QStringList &outputNames);
-    int _idxAtTimeBinarySearch (ProgramModelIterator *it,
-                               int low, int high, double time);
 };
 
 class ProgramModelIterator : public ModelIterator
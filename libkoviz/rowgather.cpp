@@ -0,0 +1,102 @@
+#include "rowgather.h"
+
+RowGather::RowGather()
+{
+}
+
+// Columns of a model with the same rows (a copy of the rows vector
+// passed with an earlier column) are fetched together
+void RowGather::addColumn(DataModel *model, int col, const QVector<int> &rows)
+{
+    int g = 0;
+    for ( ; g < _groups.size(); ++g ) {
+        const Group& group = _groups.at(g);
+        if ( group.model == model &&
+             group.rows.size() == rows.size() &&
+             group.rows.constData() == rows.constData() ) {
+            break;
+        }
+    }
+    if ( g == _groups.size() ) {
+        Group group;
+        group.model = model;
+        group.rows = rows;
+        _groups.append(group);
+    }
+
+    Column column;
+    column.group = g;
+    column.groupCol = _groups.at(g).cols.size();
+    _groups[g].cols.append(col);
+    _columns.append(column);
+}
+
+void RowGather::addColumn(const QVector<double> &values)
+{
+    Column column;
+    column.group = -1;
+    column.groupCol = -1;
+    column.values = values;
+    _columns.append(column);
+}
+
+void RowGather::gather(int beg, int cnt, double *block) const
+{
+    if ( cnt <= 0 ) {
+        return;
+    }
+
+    // Fetch the model rows of each group that the chunk rows need
+    int nGroups = _groups.size();
+    QVector<QVector<double> > fetched(nGroups);
+    QVector<int> firstRows(nGroups);
+    QVector<int> spans(nGroups);
+    for ( int g = 0; g < nGroups; ++g ) {
+        const Group& group = _groups.at(g);
+        int lo = beg;
+        int n = cnt;
+        if ( !group.rows.isEmpty() ) {
+            const int* rows = group.rows.constData()+beg;
+            int hi = rows[0];
+            lo = rows[0];
+            for ( int i = 1; i < cnt; ++i ) {
+                if ( rows[i] < lo ) lo = rows[i];
+                if ( rows[i] > hi ) hi = rows[i];
+            }
+            n = hi-lo+1;
+        }
+        int nGroupCols = group.cols.size();
+        QVector<double>& buf = fetched[g];
+        buf.fill(0.0,nGroupCols*n);
+        QVector<double*> bufs(nGroupCols);
+        for ( int k = 0; k < nGroupCols; ++k ) {
+            bufs[k] = buf.data()+k*n;
+        }
+        group.model->fetchRows(lo,n,group.cols,bufs.data());
+        firstRows[g] = lo;
+        spans[g] = n;
+    }
+
+    // Gather column-major block of chunk values
+    int nCols = _columns.size();
+    for ( int j = 0; j < nCols; ++j ) {
+        const Column& column = _columns.at(j);
+        double* dst = block+j*cnt;
+        if ( column.group < 0 ) {
+            memcpy(dst,column.values.constData()+beg,cnt*sizeof(double));
+            continue;
+        }
+        const Group& group = _groups.at(column.group);
+        const double* src = fetched.at(column.group).constData() +
+                            column.groupCol*spans.at(column.group);
+        if ( group.rows.isEmpty() ) {
+            memcpy(dst,src,cnt*sizeof(double));
+        } else {
+            const int* rows = group.rows.constData()+beg;
+            int lo = firstRows.at(column.group);
+            for ( int i = 0; i < cnt; ++i ) {
+                dst[i] = src[rows[i]-lo];
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ROWGATHER_H
+#define ROWGATHER_H
+
+#include <QList>
+#include <QVector>
+#include <string.h>
+#include "datamodel.h"
+
+//
+// Gathers chunks of output rows of a list of columns
+//
+// Columns are added as model columns (optionally at a list of model rows
+// per output row e.g. the sample at or before each table time) or as a
+// list of values.  gather() fills a column major block of output rows
+// [beg,beg+cnt) with one DataModel::fetchRows() per group of columns that
+// share a model and rows.  A group fetches the min to max span of the
+// chunk's model rows, so the rows needn't be increasing.  Rows past the
+// end of a model gather as zero.
+//
+// gather() is const and keeps nothing between calls, so chunks can be
+// gathered on worker threads.  Models must be mapped while gathering.
+//
+class RowGather
+{
+  public:
+
+    RowGather();
+
+    void addColumn(DataModel* model, int col,
+                   const QVector<int>& rows=QVector<int>());
+    void addColumn(const QVector<double>& values);
+
+    int columnCount() const { return _columns.size(); }
+
+    // block[j*cnt+i] is column j of output row beg+i
+    void gather(int beg, int cnt, double* block) const;
+
+  private:
+
+    // Columns of a model that share rows are fetched together
+    struct Group
+    {
+        DataModel* model;
+        QVector<int> cols;
+        QVector<int> rows;  // empty if output row i is model row i
+    };
+
+    struct Column
+    {
+        int group;          // -1 if values
+        int groupCol;
+        QVector<double> values;
+    };
+
+    QList<Group> _groups;
+    QList<Column> _columns;
+};
+
+#endif // ROWGATHER_H
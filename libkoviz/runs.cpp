@@ -39,21 +39,33 @@ Runs::~Runs()
     }
 }
 
-void Runs::_init()
+// Scan run dir for *.trk, *.csv and *.mot files (called on worker threads)
+class RunDirScanner
 {
-    QStringList filter;
-    filter << "*.trk" << "*.csv" << "*.mot";
-    QStringList files;
-    QHash<QString,QStringList> runToFiles;
-    QHash<QString,QString> fileToRun;
-    QRegExp filterRgx(_filterPattern);
-    QRegExp excludeRgx(_excludePattern);
-    foreach ( QString run, _runDirs ) {
+  public:
+    typedef RunDirScan result_type;
+
+    RunDirScanner(const QString& filterPattern,
+                  const QString& excludePattern) :
+        _filterPattern(filterPattern),
+        _excludePattern(excludePattern)
+    {}
+
+    RunDirScan operator()(const QString& run) const
+    {
+        RunDirScan scan;
+        scan.run = run;
+
         if ( ! QFileInfo(run).exists() ) {
-            _err_stream << "koviz [error]: couldn't find run directory: "
-                        << run << "\n";
-            throw std::invalid_argument(_err_string.toLatin1().constData());
+            scan.err = QString("koviz [error]: couldn't find run directory: "
+                               "%1\n").arg(run);
+            return scan;
         }
+
+        QStringList filter;
+        filter << "*.trk" << "*.csv" << "*.mot";
+        QRegExp filterRgx(_filterPattern);
+        QRegExp excludeRgx(_excludePattern);
         QDir runDir(run);
         QStringList lfiles = runDir.entryList(filter, QDir::Files);
         if ( lfiles.contains("log_timeline.csv") ) {
@@ -81,61 +93,84 @@ void Runs::_init()
         }
 
         if ( lfiles.empty() ) {
-            _err_stream << "koviz [error]: Either no *.trk/csv/mot files "
-                           "in run dir: " << run << "\n"
-                        << "               or log files were filtered out.\n";
-            throw std::invalid_argument(_err_string.toLatin1().constData());
+            scan.err = QString("koviz [error]: Either no *.trk/csv/mot files "
+                               "in run dir: %1\n"
+                               "               or log files were "
+                               "filtered out.\n").arg(run);
+            return scan;
         }
 
-        QStringList fullPathFiles;
         foreach (QString file, lfiles) {
-            QString ffile = run + '/' + file;
-            fullPathFiles.append(ffile);
-            if ( !files.contains(ffile) ) {
-                files << ffile;
-                fileToRun.insert(ffile,run);
-            }
+            scan.files.append(run + '/' + file);
         }
-        runToFiles.insert(run,fullPathFiles);
-    }
 
-    // Begin Progress Dialog
-    const int nFiles = files.size();
-    QProgressDialog* progress = 0;
-    if ( _isShowProgress ) {
-        progress =  new QProgressDialog("Initializing data models...",
-                                        "Abort", 0, nFiles, 0);
-        progress->setWindowModality(Qt::WindowModal);
-        progress->setMinimumDuration(500);
+        return scan;
     }
 
-    QHash<QString,QStringList> runToParams;
-    QHash<QPair<QString,QString>,DataModel*> pfnameToModel;
-    int i = 0;
-    foreach (QString fname, files ) {
-        if ( _isShowProgress ) {
-            if ( nFiles > 7 ) {
-                // Only show progress when loading many files (7 is arbitrary)
-                progress->setValue(i);
-                if (progress->wasCanceled()) {
-                    exit(0);
+  private:
+    QString _filterPattern;
+    QString _excludePattern;
+};
+
+// Create data model and alias its params with the varmap
+// (called on worker threads)
+class RunFileLoader
+{
+  public:
+    typedef RunFileLoad result_type;
+
+    RunFileLoader(const QStringList& timeNames,
+                  const QHash<QString,QStringList>& varMap,
+                  const QHash<QString,TrkCatalog*>& catalogs) :
+        _timeNames(timeNames),
+        _varMap(varMap),
+        _catalogs(catalogs)
+    {}
+
+    RunFileLoad operator()(const QString& fname) const
+    {
+        RunFileLoad load;
+
+        DataModel* m = 0;
+        try {
+            QFileInfo fi(fname);
+            TrkCatalogEntry entry;
+            if ( fi.suffix() == "trk" ) {
+                QString dir = TrkCatalog::catalogDir(fi.absolutePath());
+                TrkCatalog* catalog = _catalogs.value(dir,0);
+                if ( catalog ) {
+                    entry = catalog->entry(fname);
                 }
+            }
+            if ( entry.isValid() ) {
+                // Header from catalog, trk file is not opened
+                m = new TrickModel(_timeNames,fname,entry);
             } else {
-                progress->setValue(files.size());
+                m = DataModel::createDataModel(_timeNames,fname);
+                TrickModel* trickModel = qobject_cast<TrickModel*>(m);
+                if ( trickModel ) {
+                    load.entry = trickModel->catalogEntry();
+                }
             }
+        } catch (std::exception &e) {
+            load.err = QString(e.what());
+            return load;
         }
-        DataModel* m = DataModel::createDataModel(_timeNames,fname);
         m->unmap();
-        _models.append(m);
+
+        // Models are used (and deleted) by the gui thread
+        if ( QCoreApplication::instance() ) {
+            m->moveToThread(QCoreApplication::instance()->thread());
+        }
+
+        QString runDir = QFileInfo(fname).absolutePath();
         int ncols = m->columnCount();
-        QStringList mParams;
         for ( int col = 0; col < ncols; ++col ) {
             QString p = m->param(col)->name();
             foreach (QString key, _varMap.keys() ) {
                 if ( p == key ) {
                     break;
                 }
-                QString runDir = QFileInfo(fname).absolutePath();
                 QStringList vals = _varMap.value(key);
                 QStringList names;
                 foreach ( QString val, vals ) {
@@ -165,22 +200,152 @@ void Runs::_init()
                     }
                 }
             }
-            mParams << p;
-            pfnameToModel.insert(qMakePair(p,fname),m);
+            load.params << p;
+        }
+        load.model = m;
+
+        return load;
+    }
+
+  private:
+    QStringList _timeNames;
+    QHash<QString,QStringList> _varMap;
+    QHash<QString,TrkCatalog*> _catalogs;
+};
+
+void Runs::_init()
+{
+    //
+    // Scan run directories for log files (in parallel)
+    //
+    QList<RunDirScan> scans = QtConcurrent::blockingMapped<QList<RunDirScan> >(
+                                       _runDirs,
+                                       RunDirScanner(_filterPattern,
+                                                     _excludePattern));
+    QStringList files;
+    QHash<QString,QStringList> runToFiles;
+    QHash<QString,QString> fileToRun;
+    foreach ( RunDirScan scan, scans ) {
+        if ( !scan.err.isEmpty() ) {
+            _err_stream << scan.err;
+            throw std::invalid_argument(_err_string.toLatin1().constData());
+        }
+        foreach (QString ffile, scan.files) {
+            if ( !fileToRun.contains(ffile) ) {
+                files << ffile;
+                fileToRun.insert(ffile,scan.run);
+            }
+        }
+        runToFiles.insert(scan.run,scan.files);
+    }
+
+    //
+    // Load trk header catalogs (one per MONTE dir or lone RUN dir)
+    //
+    QHash<QString,TrkCatalog*> catalogs;
+    foreach ( QString run, _runDirs ) {
+        QString dir = TrkCatalog::catalogDir(run);
+        if ( !catalogs.contains(dir) ) {
+            TrkCatalog* catalog = new TrkCatalog(dir);
+            catalog->load();
+            catalogs.insert(dir,catalog);
+        }
+    }
+
+    //
+    // Load data models on the thread pool
+    //
+    const int nFiles = files.size();
+    QFuture<RunFileLoad> future = QtConcurrent::mapped(files,
+                                         RunFileLoader(_timeNames,_varMap,
+                                                       catalogs));
+
+    // Progress Dialog (only show when loading many files, 7 is arbitrary)
+    if ( _isShowProgress && nFiles > 7 ) {
+        QProgressDialog progress("Initializing data models...",
+                                 "Abort", 0, nFiles, 0);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(500);
+
+        QFutureWatcher<RunFileLoad> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        QObject::connect(&watcher, SIGNAL(progressValueChanged(int)),
+                         &progress, SLOT(setValue(int)));
+        QObject::connect(&progress, SIGNAL(canceled()),
+                         &watcher, SLOT(cancel()));
+        watcher.setFuture(future);
+        if ( !future.isFinished() ) {
+            loop.exec();
+        }
+        future.waitForFinished();
+        if ( future.isCanceled() ) {
+            exit(0);
+        }
+        progress.setValue(nFiles);
+    } else {
+        future.waitForFinished();
+    }
+
+    //
+    // Gather results (in file order so tables match a serial load)
+    //
+    QString err;
+    for ( int i = 0; i < nFiles; ++i ) {
+        RunFileLoad load = future.resultAt(i);
+        if ( load.model ) {
+            _models.append(load.model);
+        } else if ( err.isEmpty() ) {
+            err = load.err;
+        }
+    }
+    if ( !err.isEmpty() ) {
+        foreach ( DataModel* m, _models ) {
+            delete m;
+        }
+        _models.clear();
+        foreach ( TrkCatalog* catalog, catalogs ) {
+            delete catalog;
+        }
+        _err_stream << err;
+        throw std::runtime_error(_err_string.toLatin1().constData());
+    }
+
+    // Update catalogs with trk headers that were (re)read
+    for ( int i = 0; i < nFiles; ++i ) {
+        RunFileLoad load = future.resultAt(i);
+        if ( load.entry.isValid() ) {
+            QString fname = files.at(i);
+            QString runDir = QFileInfo(fname).absolutePath();
+            TrkCatalog* catalog = catalogs.value(
+                                          TrkCatalog::catalogDir(runDir),0);
+            if ( catalog ) {
+                catalog->insert(fname,load.entry);
+            }
+        }
+    }
+    foreach ( TrkCatalog* catalog, catalogs ) {
+        catalog->save();
+        delete catalog;
+    }
+
+    QHash<QString,QStringList> runToParams;
+    QHash<QString,QHash<QString,DataModel*> > runToParamModel;
+    for ( int i = 0; i < nFiles; ++i ) {
+        RunFileLoad load = future.resultAt(i);
+        QString run = fileToRun.value(files.at(i));
+        QHash<QString,DataModel*>& paramModel = runToParamModel[run];
+        foreach ( QString p, load.params ) {
+            // First file (in run file order) with param wins
+            if ( !paramModel.contains(p) ) {
+                paramModel.insert(p,load.model);
+            }
         }
-        QString run = fileToRun.value(fname);
         QStringList params = runToParams.value(run);
-        params.append(mParams);
+        params.append(load.params);
         params.removeDuplicates();
         params.sort();
         runToParams.insert(run,params);
-        ++i;
-    }
-
-    // End Progress Dialog
-    if ( _isShowProgress ) {
-        progress->setValue(nFiles);
-        delete progress;
     }
 
     // Make list of params that are in each run (coplottable)
@@ -200,14 +365,7 @@ void Runs::_init()
     foreach ( QString p, _params ) {
         _paramToModels.insert(p,new QList<DataModel*>);
         foreach ( QString run, _runDirs ) {
-            DataModel* m = 0;
-            foreach ( QString fname, runToFiles.value(run) ) {
-                QPair<QString,QString> pfname = qMakePair(p,fname);
-                if ( pfnameToModel.contains(pfname) ) {
-                    m = pfnameToModel.value(pfname);
-                    break;
-                }
-            }
+            DataModel* m = runToParamModel.value(run).value(p,0);
             _paramToModels.value(p)->append(m);
         }
     }
@@ -14,12 +14,38 @@
 #include <QStandardItemModel>
 #include <QProgressDialog>
 #include <QRegExp>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QThread>
+#include <QCoreApplication>
+#include <QtConcurrentMap>
 #include <stdexcept>
 #include "datamodel.h"
+#include "datamodel_trick.h"
+#include "trkcatalog.h"
 #include "curvemodel.h"
 #include "numsortitem.h"
 #include "mapvalue.h"
 
+// Result of scanning a RUN dir for log files (done on a worker thread)
+struct RunDirScan
+{
+    QString run;
+    QStringList files;  // full paths
+    QString err;
+};
+
+// Result of loading a single log file (done on a worker thread)
+struct RunFileLoad
+{
+    RunFileLoad() : model(0) {}
+    DataModel* model;
+    QStringList params; // model params after varmap aliasing
+    TrkCatalogEntry entry; // valid if trk header was read from trk file
+    QString err;
+};
+
 class Runs
 {
   public:
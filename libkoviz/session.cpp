@@ -131,11 +131,14 @@ Session::Session(const QString &sessionFileName) :
             }
             if ( _presentation != "compare" &&
                  _presentation != "error" &&
-                 _presentation != "error+compare") {
+                 _presentation != "error+compare" &&
+                 _presentation != "baseline_error" &&
+                 _presentation != "baseline_envelope" ) {
                 fprintf(stderr,"koviz [error]: session file has presentation "
                                "set to \"%s\".  For now, koviz only "
-                               "supports \"compare\", \"error\" and "
-                               "\"error+compare\"\n",
+                               "supports \"compare\", \"error\", "
+                               "\"error+compare\", \"baseline_error\" and "
+                               "\"baseline_envelope\"\n",
                                _presentation.toLatin1().constData());
                 exit(-1);
             }
@@ -1,7 +1,10 @@
 #include "thread.h"
 
 #include <cmath>
+#include <string.h>
 #include <QtCore/qmath.h>
+#include <QtConcurrentMap>
+#include "rowgather.h"
 
 QString Thread::_err_string;
 QTextStream Thread::_err_stream(&Thread::_err_string);
@@ -47,6 +50,73 @@ void Thread::addJob(Job* job)
     _jobs.append(job);
 }
 
+// Frames [beg,beg+cnt) and the sum of the job runtimes of each frame
+class JobRuntimeBlock
+{
+  public:
+    int beg;
+    int cnt;
+    QVector<double> frameTimes;
+};
+
+// Sums the job runtimes of a block of frames.  The rows of the frames are
+// gathered a chunk at a time into a jobs x rows column major matrix.
+// Each frame total adds its rows in order and the jobs of a row in job
+// order (the order a frame was summed in before it was done in blocks),
+// negative runtimes count as zero.  Called on worker threads.
+class JobRuntimeSummer
+{
+  public:
+    typedef JobRuntimeBlock result_type;
+
+    JobRuntimeSummer(const RowGather* runtimes,
+                     const QVector<int>* frameEndRows, int rowsPerChunk) :
+        _runtimes(runtimes), _frameEndRows(frameEndRows),
+        _rowsPerChunk(rowsPerChunk) {}
+
+    JobRuntimeBlock operator()(const JobRuntimeBlock& blockIn) const
+    {
+        JobRuntimeBlock block = blockIn;
+        int nJobs = _runtimes->columnCount();
+        const int* endRows = _frameEndRows->constData();
+        int rowBeg = ( block.beg > 0 ) ? endRows[block.beg-1] : 0;
+        int rowEnd = endRows[block.beg+block.cnt-1];
+
+        block.frameTimes = QVector<double>(block.cnt,0.0);
+        double* frameTimes = block.frameTimes.data();
+        int f = block.beg;
+        double frame_time = 0.0;
+        QVector<double> matrix;
+        for ( int beg = rowBeg; beg < rowEnd; beg += _rowsPerChunk ) {
+            int cnt = qMin(_rowsPerChunk,rowEnd-beg);
+            matrix.resize(nJobs*cnt);
+            _runtimes->gather(beg,cnt,matrix.data());
+            const double* rts = matrix.constData();
+            for ( int i = 0; i < cnt; ++i ) {
+                while ( beg+i >= endRows[f] ) {
+                    frameTimes[f-block.beg] = frame_time;
+                    frame_time = 0.0;
+                    ++f;
+                }
+                for ( int j = 0; j < nJobs; ++j ) {
+                    double rt = rts[j*cnt+i];
+                    frame_time += ( rt < 0.0 ) ? 0.0 : rt;
+                }
+            }
+        }
+        if ( rowEnd > rowBeg ) {
+            frameTimes[f-block.beg] = frame_time;
+        }
+
+        return block;
+    }
+
+  private:
+    const RowGather* _runtimes;
+    const QVector<int>* _frameEndRows;
+    int _rowsPerChunk;
+};
+
 void Thread::_do_stats()
 {
     if ( _jobs.size() == 0 ) {
@@ -115,6 +185,7 @@ void Thread::_do_stats()
         _num_overruns = 0;
         _max_runtime = 0.0;
         int tidx = 0 ;
+        int amfCursor = 0;
         while ( !it->isDone() ) {
 
             // If overrun time is above 0, tally an overrun.
@@ -125,7 +196,8 @@ void Thread::_do_stats()
             // Koviz calculates frame time (ft) by excluding executive
             // time waiting to sync with wall clock but includes
             // the sync with amf children
-            int amfIdx  = timeToSyncWithAMFChildrenCurve->indexAtTime(it->t());
+            int amfIdx  = timeToSyncWithAMFChildrenCurve->
+                                    indexAtTime(it->t(),&amfCursor);
             double timeToSyncWithAMFChildren = iamf->at(amfIdx)->y()/1000000.0;
             double frameSchedTime = it->x()/1000000.0;
             double ft = frameSchedTime - timeToSyncWithAMFChildren;
@@ -156,80 +228,128 @@ void Thread::_do_stats()
         //
         Job* job0 = _jobs.at(0);
         CurveModel* curve = job0->curve();
-        ModelIterator* it = curve->begin();
-        double frame_time = 0.0;
-        _max_runtime = 0.0;
-        int frameidx = 0 ;
-        int tidx = 0 ;
+        int nRows = curve->rowCount();
 
-        double tnext = it->t() + _freq;
-        double epsilon = 1.0e-6;
+        // Job runtime columns
+        RowGather runtimes;
+        QList<DataModel*> models;
+        foreach ( Job* job, _jobs ) {
+            if ( job->isFrameTimerJob() ) {
+                // For Trick 13
+                // Do not use child frame scheduling time for frame
+                // time sum.  Koviz reports the sum of the userjobs,
+                // not the frame scheduling time since the frame
+                // scheduling time includes executive overhead
+                // (e.g. the frame logging itself).
+                continue;
+            }
+            DataModel* model = job->curve()->dataModel();
+            if ( !models.contains(model) ) {
+                models.append(model);
+                model->map();
+            }
+            runtimes.addColumn(model,job->curve()->xColumn());
+        }
 
-        _num_overruns = 0;
-        while ( !it->isDone() ) {
+        QVector<double> times(nRows);
+        curve->map();
+        curve->dataModel()->fetchColumn(curve->tColumn(),0,nRows,
+                                        times.data());
+        curve->unmap();
 
-            double frameTimeStamp = it->t();
-            QList<double> jobTimeStampsAcrossFrame;
-            while ( !it->isDone() && it->t()+epsilon < tnext ) {
-
-                jobTimeStampsAcrossFrame.append(it->t());
-
-                foreach ( Job* job, _jobs ) {
-
-                    if ( job->isFrameTimerJob() ) {
-                        // For Trick 13
-                        // Do not use child frame scheduling time for frame
-                        // time sum.  Koviz reports the sum of the userjobs,
-                        // not the frame scheduling time since the frame
-                        // scheduling time includes executive overhead
-                        // (e.g. the frame logging itself).
-                        continue;
-                    }
-
-                    ModelIterator* it2 = job->curve()->begin();
-                    double ft = it2->at(tidx)->x();
-                    delete it2;
-                    if ( ft < 0 ) {
-                        ft = 0.0;
-                    }
-                    frame_time += ft;
-                }
+        //
+        // Frames (rows that span a thread frame)
+        //
+        QVector<double> frameTimeStamps;
+        QVector<int> frameEndRows;
+        frameTimeStamps.reserve(_frameCount);
+        frameEndRows.reserve(_frameCount);
+        double epsilon = 1.0e-6;
+        double tnext = ( nRows > 0 ) ? times.at(0) + _freq : 0.0;
+        int tidx = 0 ;
+        while ( tidx < nRows ) {
+            double frameTimeStamp = times.at(tidx);
+            while ( tidx < nRows && times.at(tidx)+epsilon < tnext ) {
                 ++tidx;
-                it->next();
-
                 if ( _freq < epsilon ) {
                     break;
                 }
             }
+            frameTimeStamps.append(frameTimeStamp);
+            frameEndRows.append(tidx);
+            tnext += _freq;
+        }
 
-            double ft = frame_time/1000000.0;
-
-            if ( ft > _freq ) {
-                _num_overruns++;
+        //
+        // Frame times in microsecs, blocks of frames summed in parallel
+        //
+        int nFrames = frameEndRows.size();
+        int nJobCols = qMax(1,runtimes.columnCount());
+        int rowsPerBlock = qBound(64,(1<<21)/nJobCols,
+                                  (int)DataModel::FetchBlockSize);
+        QList<JobRuntimeBlock> blocks;
+        for ( int i = 0; i < nFrames; ) {
+            JobRuntimeBlock block;
+            block.beg = i;
+            int rowBeg = ( i > 0 ) ? frameEndRows.at(i-1) : 0;
+            while ( i < nFrames && frameEndRows.at(i)-rowBeg < rowsPerBlock ) {
+                ++i;
+            }
+            if ( i == block.beg ) {
+                ++i;  // a frame with more rows than a block
             }
+            block.cnt = i-block.beg;
+            blocks.append(block);
+        }
+        JobRuntimeSummer summer(&runtimes,&frameEndRows,rowsPerBlock);
+        blocks = QtConcurrent::blockingMapped<QList<JobRuntimeBlock> >(
+                                                            blocks,summer);
+        QVector<double> frameTimes(nFrames);
+        foreach ( const JobRuntimeBlock& block, blocks ) {
+            memcpy(frameTimes.data()+block.beg,block.frameTimes.constData(),
+                   block.cnt*sizeof(double));
+        }
+        foreach ( DataModel* model, models ) {
+            model->unmap();
+        }
 
+        //
+        // Reductions over frame times
+        //
+        const double* fts = frameTimes.constData();
+        _num_overruns = 0;
+        _max_runtime = 0.0;
+        for ( int i = 0; i < nFrames; ++i ) {
+            double ft = fts[i]/1000000.0;
+            _num_overruns += ( ft > _freq ) ? 1 : 0;
+            sum_time += fts[i];
+            sum_squares += ft*ft;
+        }
+        for ( int i = 0; i < nFrames; ++i ) {
+            double ft = fts[i]/1000000.0;
             if ( ft > _max_runtime ) {
                 _max_runtime = ft;
-                _tidx_max_runtime = frameidx;
+                _tidx_max_runtime = i;
             }
+        }
 
-            foreach ( double t, jobTimeStampsAcrossFrame ) {
-                _jobtimestamp2frametime[t] = ft;
+        //
+        // Runtime table and job timestamp to frame time lookup
+        //
+        int beg = 0;
+        for ( int i = 0; i < nFrames; ++i ) {
+            double ft = fts[i]/1000000.0;
+            for ( int k = beg; k < frameEndRows.at(i); ++k ) {
+                _jobtimestamp2frametime[times.at(k)] = ft;
             }
+            beg = frameEndRows.at(i);
 
             QModelIndex timeIdx = _runtimeCurve->index(rowCount,0);
             QModelIndex valIdx = _runtimeCurve->index(rowCount,1);
             ++rowCount;
-            _runtimeCurve->setData(timeIdx,frameTimeStamp);
+            _runtimeCurve->setData(timeIdx,frameTimeStamps.at(i));
             _runtimeCurve->setData(valIdx,ft);
-            sum_time += frame_time;
-            sum_squares += ft*ft;
-            frame_time = 0.0;
-            frameidx++;
-            tnext += _freq;
         }
-
-        delete it;
     }
 
     double ss = sum_squares;
@@ -0,0 +1,132 @@
+#include "timeindex.h"
+#include <math.h>
+#include <algorithm>
+
+TimeIndex::TimeIndex(const QVector<double> &times) :
+    _nrows(times.size()),
+    _isUniform(false),
+    _t0(0.0),
+    _dt(0.0)
+{
+    if ( _nrows == 0 ) {
+        return;
+    }
+
+    const double* t = times.constData();
+    _t0 = t[0];
+
+    // Uniform if every time is within a millionth of a step of t0+i*dt
+    if ( _nrows > 1 ) {
+        _dt = (t[_nrows-1]-_t0)/(_nrows-1);
+        if ( _dt > 0.0 ) {
+            double tol = 1.0e-6*_dt;
+            _isUniform = true;
+            for ( int i = 0; i < _nrows; ++i ) {
+                if ( fabs(t[i]-(_t0+i*_dt)) > tol ) {
+                    _isUniform = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( !_isUniform ) {
+        _times = times;
+        int nBlocks = (_nrows+BlockSize-1)/BlockSize;
+        _blockTimes.resize(nBlocks);
+        for ( int k = 0; k < nBlocks; ++k ) {
+            _blockTimes[k] = t[k*BlockSize];
+        }
+    }
+}
+
+int TimeIndex::indexAtTime(double time) const
+{
+    if ( _nrows == 0 ) {
+        return 0;
+    }
+
+    if ( _isUniform ) {
+        double x = (time-_t0)/_dt + 1.0e-6;
+        if ( !(x > 0.0) ) {
+            return 0;   // also catches nan
+        } else if ( x >= _nrows-1 ) {
+            return _nrows-1;
+        }
+        return (int)x;
+    }
+
+    return _search(time);
+}
+
+int TimeIndex::indexAtTime(double time, int *cursor) const
+{
+    if ( _isUniform || !cursor || _nrows == 0 ) {
+        return indexAtTime(time);
+    }
+
+    // Walk forward a few rows from the last hit
+    const double* t = _times.constData();
+    int i = *cursor;
+    if ( i >= 0 && i < _nrows && t[i] <= time ) {
+        for ( int s = 0; s < 8; ++s ) {
+            if ( i+1 >= _nrows || t[i+1] > time ) {
+                *cursor = i;
+                return i;
+            }
+            ++i;
+        }
+    }
+
+    i = _search(time);
+    *cursor = i;
+
+    return i;
+}
+
+int TimeIndex::_search(double time) const
+{
+    const double* t = _times.constData();
+
+    if ( !(time >= t[0]) ) {
+        return 0;
+    }
+    if ( time >= t[_nrows-1] ) {
+        return _nrows-1;
+    }
+
+    // Block holding time from the sparse index
+    const double* b = _blockTimes.constData();
+    int nBlocks = _blockTimes.size();
+    int k = (int)(std::upper_bound(b,b+nBlocks,time)-b) - 1;
+    if ( k < 0 ) k = 0;
+
+    // Search block keeping t[lo] <= time < t[hi]
+    int lo = k*BlockSize;
+    int hi = qMin(lo+BlockSize,_nrows-1);
+    int nSteps = 0;
+    while ( hi-lo > 8 ) {
+        int mid;
+        if ( nSteps < 3 ) {
+            // Interpolate
+            double f = (time-t[lo])/(t[hi]-t[lo]);
+            mid = lo + (int)(f*(hi-lo));
+        } else {
+            // Bisect if interpolation is not converging (skewed times)
+            mid = (lo+hi)/2;
+        }
+        if ( mid <= lo ) mid = lo+1;
+        if ( mid >= hi ) mid = hi-1;
+        if ( t[mid] <= time ) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+        ++nSteps;
+    }
+    while ( lo+1 < hi && t[lo+1] <= time ) {
+        ++lo;
+    }
+
+    return lo;
+}
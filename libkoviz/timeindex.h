@@ -0,0 +1,43 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <QVector>
+
+//
+// Time lookup for a model's time column
+//
+// indexAtTime(t) returns the largest row with time <= t, clamped to
+// [0,nrows-1] (the same answer the old per model binary searches gave).
+//
+// Uniformly sampled logs (the common case) are answered in O(1) by
+// arithmetic and the time column is not kept.  Irregular logs use a
+// sparse index of every Nth time to find a block, then an interpolation
+// search within the block.  For monotone sequential lookups (e.g. table
+// rows or frames) pass a cursor which remembers the last hit.
+//
+class TimeIndex
+{
+  public:
+
+    TimeIndex(const QVector<double>& times);
+
+    int indexAtTime(double time) const;
+    int indexAtTime(double time, int* cursor) const;
+
+    bool isUniform() const { return _isUniform; }
+
+  private:
+
+    enum { BlockSize = 256 };
+
+    int _nrows;
+    bool _isUniform;
+    double _t0;
+    double _dt;
+    QVector<double> _times;       // empty if uniform
+    QVector<double> _blockTimes;  // every BlockSize-th time
+
+    int _search(double time) const;
+};
+
+#endif // TIMEINDEX_H
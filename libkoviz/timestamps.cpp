@@ -1,80 +1,238 @@
 #include "timestamps.h"
 #include "roundoff.h"
+#include <algorithm>
 
-int TimeStamps::_lastIdx(0);
 double TimeStamps::epsilon(5.391245e-44);  // Planck time is arbitrary
 
-static bool doubleLessThan(double a, double b)
+// Forward cursor over a time column in [start,stop], a block at a time
+class TimeStampsCursor
+{
+  public:
+
+    TimeStampsCursor(DataModel* model, int col, double start, double stop,
+                     const QVector<double>* times) :
+        _model(model),
+        _col(col),
+        _stop(stop),
+        _nrows(model ? model->rowCount() : times->size()),
+        _beg(0), _cnt(0), _i(0),
+        _isSorted(true),
+        _tLast(-DBL_MAX)
+    {
+        if ( model ) {
+            _block.resize(DataModel::FetchBlockSize);
+            _fetch();
+        } else {
+            _t = times->constData();
+            _cnt = _nrows;
+        }
+        while ( !isDone() && t() < start ) {
+            next();
+        }
+    }
+
+    inline bool isDone() const { return _i >= _cnt || t() > _stop; }
+    inline double t() const { return _t[_i]; }
+    inline bool isSorted() const { return _isSorted; }
+
+    inline void next()
+    {
+        _tLast = _t[_i];
+        ++_i;
+        if ( _i >= _cnt && _beg+_cnt < _nrows && _model ) {
+            _beg += _cnt;
+            _fetch();
+        }
+        if ( _i < _cnt && _t[_i] < _tLast ) {
+            _isSorted = false;
+        }
+    }
+
+  private:
+
+    DataModel* _model;
+    int _col;
+    double _stop;
+    int _nrows;
+    int _beg;
+    int _cnt;
+    int _i;
+    bool _isSorted;
+    double _tLast;
+    QVector<double> _block;
+    const double* _t;
+
+    void _fetch()
+    {
+        _cnt = _model->fetchColumn(_col,_beg,DataModel::FetchBlockSize,
+                                   _block.data());
+        _t = _block.constData();
+        _i = 0;
+    }
+};
+
+// Orders cursors in a min heap on their current time
+class TimeStampsCursorGreater
+{
+  public:
+    TimeStampsCursorGreater(const QVector<TimeStampsCursor*>& cursors) :
+        _cursors(cursors) {}
+    bool operator()(int a, int b) const
+    {
+        return _cursors.at(a)->t() > _cursors.at(b)->t();
+    }
+  private:
+    const QVector<TimeStampsCursor*>& _cursors;
+};
+
+TimeStamps::TimeStamps()
 {
-    return a-b < TimeStamps::epsilon;
 }
 
-QList<double> TimeStamps::merge(const QList<double>& listA,
-                                const QList<double>& listB)
+void TimeStamps::addColumn(DataModel *model, int col,
+                           double start, double stop)
 {
-    QList<double> list = listA + listB;
-    usort(list);
-    return list;
+    Column column;
+    column.model = model;
+    column.col = col;
+    column.start = start;
+    column.stop = stop;
+    _columns.append(column);
+}
+
+void TimeStamps::addTimes(const QVector<double> &times)
+{
+    Column column;
+    column.model = 0;
+    column.col = 0;
+    column.start = -DBL_MAX;
+    column.stop = DBL_MAX;
+    column.times = times;
+    _columns.append(column);
 }
 
-void TimeStamps::insert(double t, QList<double> &list)
+QVector<double> TimeStamps::merge() const
 {
-    if ( list.isEmpty() ) {
-        list.append(t);
-        return;
+    QVector<double> list;
+
+    foreach ( const Column& column, _columns ) {
+        if ( column.model ) column.model->map();
     }
 
-    if ( list.count() == 1 ) {
-        double t0 = list.at(0);
-        if ( t < t0-TimeStamps::epsilon ) {
-            list.prepend(t);
-        } else if ( t > t0+TimeStamps::epsilon ) {
+    QVector<TimeStampsCursor*> cursors;
+    QVector<int> heap;
+    int nrows = 0;
+    for ( int i = 0; i < _columns.size(); ++i ) {
+        const Column& column = _columns.at(i);
+        TimeStampsCursor* cursor = new TimeStampsCursor(column.model,
+                                                        column.col,
+                                                        column.start,
+                                                        column.stop,
+                                                        &column.times);
+        nrows = qMax(nrows, column.model ? column.model->rowCount()
+                                         : column.times.size());
+        if ( !cursor->isDone() ) {
+            heap.append(cursors.size());
+        }
+        cursors.append(cursor);
+    }
+
+    // Pop the least time off the heap, append it if it is new
+    list.reserve(nrows);
+    TimeStampsCursorGreater greater(cursors);
+    std::make_heap(heap.begin(),heap.end(),greater);
+    bool isSorted = true;
+    while ( !heap.isEmpty() ) {
+        std::pop_heap(heap.begin(),heap.end(),greater);
+        TimeStampsCursor* cursor = cursors.at(heap.last());
+        double t = cursor->t();
+        if ( list.isEmpty() || t > list.last()+TimeStamps::epsilon ) {
             list.append(t);
         }
-        return;
+        cursor->next();
+        if ( !cursor->isSorted() ) {
+            isSorted = false;
+            break;
+        }
+        if ( cursor->isDone() ) {
+            heap.removeLast();
+        } else {
+            std::push_heap(heap.begin(),heap.end(),greater);
+        }
     }
 
-    int i = idxAtTime(list,t);
-    double ti = list.at(i);
-    if ( qAbs(t-ti) > TimeStamps::epsilon ) {
-        // Time is not in list, so insert
-        if ( i == 0 ) {
-            double t0 = list.at(0);
-            if ( t < t0-TimeStamps::epsilon ) {
-                list.prepend(t);
-            } else {
-                list.insert(1,t);  // list size >= 2 (from checks above)
-            }
+    foreach ( TimeStampsCursor* cursor, cursors ) {
+        delete cursor;
+    }
+
+    if ( !isSorted ) {
+        list = _sortMerge();
+    }
+
+    foreach ( const Column& column, _columns ) {
+        if ( column.model ) column.model->unmap();
+    }
+
+    return list;
+}
+
+// For columns whose time goes backwards, all times in [start,stop]
+// are sorted and times within epsilon of the one before are dropped
+QVector<double> TimeStamps::_sortMerge() const
+{
+    QVector<double> times;
+    foreach ( const Column& column, _columns ) {
+        int nrows = column.model ? column.model->rowCount()
+                                 : column.times.size();
+        QVector<double> buf(nrows);
+        if ( column.model ) {
+            column.model->fetchColumn(column.col,0,nrows,buf.data());
         } else {
-            list.insert(i+1,t);
+            buf = column.times;
+        }
+        foreach ( double t, buf ) {
+            if ( t >= column.start && t <= column.stop ) {
+                times.append(t);
+            }
         }
-    } else {
-        // Nothing to insert since it is already inserted
     }
+    std::sort(times.begin(),times.end());
+
+    QVector<double> list;
+    list.reserve(times.size());
+    foreach ( double t, times ) {
+        if ( list.isEmpty() || t > list.last()+TimeStamps::epsilon ) {
+            list.append(t);
+        }
+    }
+
+    return list;
 }
 
-// Returns -1 if time below list
-// Returns list.count() if time >= last time
-int TimeStamps::idxAtTime(const QList<double> &list, double time)
+int TimeStamps::idxAtTime(const QVector<double> &list, double time,
+                          int* cursor)
 {
     if ( list.isEmpty() ) return -1;
     int rc = list.size();
     if ( rc > 0 && list.at(rc-1) < time-TimeStamps::epsilon ) {
         return rc-1;
     }
-    if ( _lastIdx+1 < rc ) {
-        if ( qAbs(list.at(_lastIdx+1)-time) < TimeStamps::epsilon ) {
-            ++_lastIdx;
-            return _lastIdx;
+    if ( cursor && *cursor >= -1 && *cursor+1 < rc ) {
+        if ( qAbs(list.at(*cursor+1)-time) < TimeStamps::epsilon ) {
+            ++(*cursor);
+            return *cursor;
         }
     }
 
-    _lastIdx = _idxAtTimeBinarySearch(list,0,rc,time);
+    int i = _idxAtTimeBinarySearch(list,0,rc,time);
+    if ( cursor ) {
+        *cursor = i;
+    }
 
-    return _lastIdx;
+    return i;
 }
 
-int TimeStamps::_idxAtTimeBinarySearch(const QList<double>& list,
+int TimeStamps::_idxAtTimeBinarySearch(const QVector<double>& list,
                                        int low, int high, double time)
 {
         if (high <= 0 ) {
@@ -95,16 +253,3 @@ int TimeStamps::_idxAtTimeBinarySearch(const QList<double>& list,
                 }
         }
 }
-
-void TimeStamps::usort(QList<double>& list)
-{
-    qSort(list.begin(),list.end(),doubleLessThan);
-    int rc = list.count();
-    for ( int i = rc-2; i >= 0; --i ) {
-        double a = list.at(i);
-        double b = list.at(i+1);
-        if ( qAbs(b-a) < TimeStamps::epsilon ) {
-            list.removeAt(i+1);
-        }
-    }
-}
@@ -2,23 +2,57 @@
 #define TIMESTAMPS_H
 
 #include <QList>
+#include <QVector>
+#include <float.h>
+#include "datamodel.h"
 
+//
+// Union of time columns
+//
+// Columns are added, then merge() k-way merges them in a single pass
+// over blocks fetched from each model.  Times within epsilon of the
+// last merged time are dropped.  A column whose time goes backwards
+// (e.g. a restarted sim) can't be merged in a pass, so if there is one
+// the times are gathered and sorted instead.
+//
 class TimeStamps
 {
 public:
-    static int idxAtTime(const QList<double>& list, double time);
-    static void insert(double t, QList<double> &list);
+    TimeStamps();
 
-    static void usort(QList<double>& list);
-    static QList<double> merge(const QList<double>& listA,
-                               const QList<double>& listB);
+    // Add time column col of model, times outside of [start,stop] skipped.
+    // The model is mapped while merging.
+    void addColumn(DataModel* model, int col,
+                   double start=-DBL_MAX, double stop=DBL_MAX);
+
+    // Add a list of times (e.g. an earlier merge)
+    void addTimes(const QVector<double>& times);
+
+    QVector<double> merge() const;
+
+    // Returns -1 if time below list
+    // Returns list.count()-1 if time >= last time
+    // For monotone sequential lookups pass a cursor, the last hit
+    static int idxAtTime(const QVector<double>& list, double time,
+                         int* cursor=0);
 
     static double epsilon;
 
 private:
-    TimeStamps() {}
-    static int _lastIdx ;
-    static int _idxAtTimeBinarySearch(const QList<double>& list,
+
+    struct Column
+    {
+        DataModel* model;
+        int col;
+        double start;
+        double stop;
+        QVector<double> times;  // if model is null
+    };
+
+    QList<Column> _columns;
+
+    QVector<double> _sortMerge() const;
+    static int _idxAtTimeBinarySearch(const QVector<double>& list,
                                       int low, int high, double time);
 };
 
@@ -70,18 +70,11 @@ TrickTableModel::TrickTableModel(const QStringList& timeNames,
     }
 
     // Make time stamps list
+    TimeStamps timeStamps;
     foreach ( DataModel* trkModel, _trkModels ) {
-        trkModel->map();
-        int timeCol = trkModel->paramColumn(timeName);
-        ModelIterator* it = trkModel->begin(timeCol,timeCol,timeCol);
-        while ( !it->isDone() ) {
-            double t = it->t();
-            TimeStamps::insert(t,_timeStamps);
-            it->next();
-        }
-        delete it;
-        trkModel->unmap();
+        timeStamps.addColumn(trkModel,trkModel->paramColumn(timeName));
     }
+    _timeStamps = timeStamps.merge();
 }
 
 TrickTableModel::~TrickTableModel()
@@ -149,6 +142,11 @@ QVariant TrickTableModel::data(const QModelIndex &idx, int role) const
     return v;
 }
 
+DataModel* TrickTableModel::columnModel(int col) const
+{
+    return _param2model.value(_params.at(col),0);
+}
+
 QVariant TrickTableModel::headerData(int section,
                                      Qt::Orientation orientation,
                                      int role) const
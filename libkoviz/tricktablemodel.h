@@ -28,6 +28,11 @@ public:
     virtual QVariant headerData(int section, Qt::Orientation orientation,
                                 int role = Qt::DisplayRole ) const;
 
+    // For batch reads of the table (e.g. csv export)
+    const QVector<double>& timeStamps() const { return _timeStamps; }
+    QList<DataModel*> trkModels() const { return _trkModels; }
+    DataModel* columnModel(int col) const;  // 0 if not found, col>0
+
 signals:
     
 public slots:
@@ -38,7 +43,7 @@ private:
     QString _runDir;
     int _rowCount;
     int _colCount;
-    QList<double> _timeStamps;
+    QVector<double> _timeStamps;
 
     QList<DataModel*> _trkModels;
     QStringList _params;
@@ -0,0 +1,183 @@
+#include "trkcatalog.h"
+
+const quint32 TrkCatalog::_magic = 0x4b6f5663; // "KoVc"
+const qint32 TrkCatalog::_version = 1;
+
+bool TrkCatalogEntry::isFresh(const QFileInfo &fi) const
+{
+    return ( isValid() &&
+             fi.size() == fileSize &&
+             fi.lastModified().toMSecsSinceEpoch() == mtime );
+}
+
+TrkCatalog::TrkCatalog(const QString &dir) :
+    _dir(QDir(dir).absolutePath()),
+    _isDirty(false)
+{
+}
+
+QString TrkCatalog::catalogFileName() const
+{
+    return _dir + "/.koviz_catalog";
+}
+
+// The catalog for the RUNs of a MONTE is kept in the MONTE dir
+// e.g. MONTE_foo/RUN_00001 -> MONTE_foo/.koviz_catalog
+// Any other RUN keeps its own catalog e.g. ~/RUN_a -> ~/RUN_a/.koviz_catalog
+// (its parent may be a home or shared dir that koviz shouldn't write to)
+QString TrkCatalog::catalogDir(const QString &runDir)
+{
+    QString absRunDir = QDir(runDir).absolutePath();
+    QFileInfo parent(QFileInfo(absRunDir).absolutePath());
+    if ( parent.fileName().startsWith("MONTE_") ) {
+        return parent.absoluteFilePath();
+    }
+    return absRunDir;
+}
+
+bool TrkCatalog::load()
+{
+    _entries.clear();
+    _isDirty = false;
+
+    QFile file(catalogFileName());
+    if ( !file.exists() ) {
+        return false;
+    }
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_8);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+    if ( magic != _magic || version != _version ) {
+        // Unknown catalog, it will be rewritten
+        file.close();
+        return false;
+    }
+
+    qint32 nEntries;
+    in >> nEntries;
+    for ( int i = 0; i < nEntries; ++i ) {
+        TrkCatalogEntry e;
+        qint8 byteOrder;
+        qint32 nParams;
+        in >> e.fileName >> e.fileSize >> e.mtime >> e.trickVersion
+           >> byteOrder >> e.posBegData >> e.rowSize >> e.nrows >> nParams;
+        e.byteOrder = (char)byteOrder;
+        for ( int j = 0; j < nParams; ++j ) {
+            QString name;
+            QString unit;
+            qint32 type;
+            qint32 size;
+            in >> name >> unit >> type >> size;
+            TrickParameter p;
+            p.setName(name);
+            p.setUnit(unit);
+            p.setType(type);
+            p.setSize(size);
+            e.params.append(p);
+        }
+        if ( in.status() != QDataStream::Ok ) {
+            // Truncated or corrupt catalog, it will be rewritten
+            _entries.clear();
+            file.close();
+            return false;
+        }
+        _entries.insert(e.fileName,e);
+    }
+
+    file.close();
+
+    return true;
+}
+
+// Catalog is written to a temp file which is renamed so that a
+// concurrent koviz never reads a partially written catalog.
+// Failure (e.g. read-only MONTE dir) is not an error, the catalog
+// is just an optimization.
+bool TrkCatalog::save()
+{
+    if ( !_isDirty ) {
+        return true;
+    }
+
+    QFileInfo dirInfo(_dir);
+    if ( !dirInfo.isWritable() ) {
+        return false;
+    }
+
+    // Drop entries whose trk files no longer exist
+    QDir dir(_dir);
+    foreach ( QString fileName, _entries.keys() ) {
+        if ( !QFileInfo(dir.filePath(fileName)).exists() ) {
+            _entries.remove(fileName);
+        }
+    }
+
+    QString tmpName = catalogFileName() +
+                      QString(".%1").arg(QCoreApplication::applicationPid());
+    QFile file(tmpName);
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_8);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out << _magic << _version;
+    out << (qint32)_entries.size();
+    foreach ( TrkCatalogEntry e, _entries.values() ) {
+        out << e.fileName << e.fileSize << e.mtime << e.trickVersion
+            << (qint8)e.byteOrder << e.posBegData << e.rowSize << e.nrows
+            << (qint32)e.params.size();
+        foreach ( TrickParameter p, e.params ) {
+            out << p.name() << p.unit()
+                << (qint32)p.type() << (qint32)p.size();
+        }
+    }
+    file.close();
+
+    if ( out.status() != QDataStream::Ok ) {
+        file.remove();
+        return false;
+    }
+
+    QFile::remove(catalogFileName());
+    if ( !file.rename(catalogFileName()) ) {
+        file.remove();
+        return false;
+    }
+
+    _isDirty = false;
+
+    return true;
+}
+
+TrkCatalogEntry TrkCatalog::entry(const QString &trkFile) const
+{
+    TrkCatalogEntry e = _entries.value(_relativeFileName(trkFile));
+    if ( !e.isFresh(QFileInfo(trkFile)) ) {
+        e = TrkCatalogEntry();
+    }
+    return e;
+}
+
+void TrkCatalog::insert(const QString &trkFile, const TrkCatalogEntry &entry)
+{
+    TrkCatalogEntry e = entry;
+    e.fileName = _relativeFileName(trkFile);
+    _entries.insert(e.fileName,e);
+    _isDirty = true;
+}
+
+QString TrkCatalog::_relativeFileName(const QString &trkFile) const
+{
+    return QDir(_dir).relativeFilePath(QFileInfo(trkFile).absoluteFilePath());
+}
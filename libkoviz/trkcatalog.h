@@ -0,0 +1,80 @@
+#ifndef TRKCATALOG_H
+#define TRKCATALOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QDataStream>
+#include <QCoreApplication>
+
+#include "datamodel_trick.h"
+
+//
+// Cached trk header (see TrkCatalog)
+//
+class TrkCatalogEntry
+{
+  public:
+    TrkCatalogEntry() :
+        fileSize(0), mtime(0), trickVersion(0), byteOrder('L'),
+        posBegData(0), rowSize(0), nrows(0)
+    {}
+
+    bool isValid() const { return !fileName.isEmpty(); }
+    bool isFresh(const QFileInfo& fi) const;
+
+    QString fileName;      // relative to catalog dir
+    qint64  fileSize;
+    qint64  mtime;         // msecs since epoch
+    qint32  trickVersion;  // 7 or 10
+    char    byteOrder;     // 'L' or 'B'
+    qint64  posBegData;
+    qint64  rowSize;
+    qint64  nrows;
+    QList<TrickParameter> params;
+};
+
+//
+// Sidecar catalog of trk headers.
+//
+// The catalog of a MONTE's RUNs lives in the MONTE dir so that reopening
+// a MONTE costs one catalog read instead of opening every trk file.  A RUN
+// outside a MONTE keeps its catalog in the RUN dir.  An entry is stale if
+// its trk file size or mtime changed.  Nothing is cached if the catalog
+// dir isn't writable.
+//
+class TrkCatalog
+{
+  public:
+    TrkCatalog(const QString& dir);
+
+    QString dir() const { return _dir; }
+    QString catalogFileName() const;
+
+    bool load();
+    bool save();
+    bool isDirty() const { return _isDirty; }
+
+    // Returns an invalid entry if trkFile is not cataloged or is stale
+    TrkCatalogEntry entry(const QString& trkFile) const;
+    void insert(const QString& trkFile, const TrkCatalogEntry& entry);
+
+    static QString catalogDir(const QString& runDir);
+
+  private:
+    QString _dir;
+    QHash<QString,TrkCatalogEntry> _entries; // relative file name -> entry
+    bool _isDirty;
+
+    QString _relativeFileName(const QString& trkFile) const;
+
+    static const quint32 _magic;
+    static const qint32 _version;
+};
+
+#endif // TRKCATALOG_H
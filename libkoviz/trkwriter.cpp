@@ -0,0 +1,72 @@
+#include "trkwriter.h"
+
+TrkWriter::TrkWriter()
+{
+}
+
+void TrkWriter::addColumn(const TrickParameter &param,
+                          DataModel *model, int col, const QVector<int> &rows)
+{
+    _gather.addColumn(model,col,rows);
+    _params.append(param);
+}
+
+void TrkWriter::addColumn(const TrickParameter &param,
+                          const QVector<double> &values)
+{
+    _gather.addColumn(values);
+    _params.append(param);
+}
+
+bool TrkWriter::write(QFile *file, int nRows) const
+{
+    // All params are written as doubles
+    QList<TrickParameter> params = _params;
+    for ( int j = 0; j < params.size(); ++j ) {
+        params[j].setType(TRICK_07_DOUBLE);
+        params[j].setSize(sizeof(double));
+    }
+    QDataStream out(file);
+    TrickModel::writeTrkHeader(out,params);
+    if ( out.status() != QDataStream::Ok ) {
+        fprintf(stderr,"koviz [error]: could not write %s\n",
+                file->fileName().toLatin1().constData());
+        return false;
+    }
+
+    int nCols = _gather.columnCount();
+    int recSize = nCols*sizeof(double);
+    int rowsPerChunk = qBound(16,(1<<16)/qMax(1,nCols),4096);
+
+    QVector<double> block(nCols*rowsPerChunk);
+    QByteArray records;
+    records.resize(rowsPerChunk*recSize);
+
+    for ( int beg = 0; beg < nRows; beg += rowsPerChunk ) {
+
+        int cnt = qMin(rowsPerChunk,nRows-beg);
+        _gather.gather(beg,cnt,block.data());
+
+        // Pack records
+        uchar* recs = (uchar*)records.data();
+        for ( int j = 0; j < nCols; ++j ) {
+            const double* src = block.constData()+j*cnt;
+            uchar* dst = recs+j*sizeof(double);
+            for ( int i = 0; i < cnt; ++i ) {
+                quint64 bits;
+                memcpy(&bits,&src[i],sizeof(double));
+                qToLittleEndian<quint64>(bits,dst);
+                dst += recSize;
+            }
+        }
+
+        qint64 nBytes = (qint64)cnt*recSize;
+        if ( file->write(records.constData(),nBytes) != nBytes ) {
+            fprintf(stderr,"koviz [error]: could not write %s\n",
+                    file->fileName().toLatin1().constData());
+            return false;
+        }
+    }
+
+    return true;
+}
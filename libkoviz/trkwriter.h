@@ -0,0 +1,49 @@
+#ifndef TRKWRITER_H
+#define TRKWRITER_H
+
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include <QDataStream>
+#include <QtEndian>
+#include <stdio.h>
+#include <string.h>
+#include "datamodel.h"
+#include "datamodel_trick.h"
+#include "rowgather.h"
+
+//
+// Sequential trk export (the trk counterpart of CsvWriter)
+//
+// Columns are added with their trk param as model columns at a list of
+// model rows per output record (e.g. the sample at or before each time
+// stamp) or as a list of values.  write() writes the Trick-07 header,
+// then walks the records in chunks.  Each chunk is gathered (see
+// RowGather, trk models decode rows straight from the mapping) and packed
+// into little endian double records, so the input is read front to back
+// once and the output is written with one write per chunk.  Models must
+// be mapped while writing.
+//
+// Nothing is shared between writers, so writers of different runs can
+// write on different threads.
+//
+class TrkWriter
+{
+  public:
+
+    TrkWriter();
+
+    void addColumn(const TrickParameter& param,
+                   DataModel* model, int col, const QVector<int>& rows);
+    void addColumn(const TrickParameter& param, const QVector<double>& values);
+
+    bool write(QFile* file, int nRows) const;
+
+  private:
+
+    QList<TrickParameter> _params;
+    RowGather _gather;
+};
+
+#endif // TRKWRITER_H
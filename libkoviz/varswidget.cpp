@@ -264,9 +264,10 @@ void VarsWidget::_addPlotToPage(QStandardItem* pageItem,
     _addChild(plotItem, "PlotBackgroundColor", "#FFFFFF");
     _addChild(plotItem, "PlotForegroundColor", "#000000");
     int rc = _runDirs.count(); // a curve per run, so, rc == nCurves
-    if ( rc == 2 ) {
-        QString presentation = _plotModel->getDataString(QModelIndex(),
-                                                         "Presentation");
+    QString presentation = _plotModel->getDataString(QModelIndex(),
+                                                     "Presentation");
+    if ( rc == 2 ||
+         (rc > 2 && _plotModel->isBaselinePresentation(presentation)) ) {
         _addChild(plotItem, "PlotPresentation", presentation);
     } else {
         _addChild(plotItem, "PlotPresentation", "compare");